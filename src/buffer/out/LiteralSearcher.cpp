@@ -0,0 +1,317 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+#include "LiteralSearcher.hpp"
+
+#include <bitset>
+#include <icu.h>
+#include <isa_availability.h>
+
+#pragma warning(disable : 26481) // Don't use pointer arithmetic. Use span instead (bounds.1).
+#pragma warning(disable : 26490) // Don't use reinterpret_cast (type.1).
+
+extern "C" int __isa_available;
+
+namespace
+{
+    struct FoldTables
+    {
+        // Maps each BMP code unit to its simple case folding. Surrogates map to themselves.
+        std::array<wchar_t, 0x10000> fold;
+        // Set for characters which we can't handle: Those whose full case folding differs from
+        // their simple case folding (for instance U+00DF which full-folds to "ss"), because
+        // that's what ICU uses for case-insensitive matching, as well as all surrogates.
+        std::bitset<0x10000> unsupported;
+    };
+
+    // The tables are 136KiB large, which is why they're only built on first use.
+    const FoldTables& getFoldTables()
+    {
+        static const auto tables = [] {
+            auto t = std::make_unique<FoldTables>();
+
+            for (uint32_t c = 0; c < 0x10000; ++c)
+            {
+                const auto ch = static_cast<char16_t>(c);
+
+                if (U16_IS_SURROGATE(ch))
+                {
+                    til::at(t->fold, c) = static_cast<wchar_t>(ch);
+                    t->unsupported.set(c);
+                    continue;
+                }
+
+                const auto folded = static_cast<wchar_t>(u_foldCase(gsl::narrow_cast<UChar32>(c), U_FOLD_CASE_DEFAULT));
+                til::at(t->fold, c) = folded;
+
+                // Simple and full case folding are identical for ASCII.
+                if (c >= 0x80)
+                {
+                    char16_t full[4];
+                    UErrorCode status = U_ZERO_ERROR;
+                    const auto length = u_strFoldCase(&full[0], 4, &ch, 1, U_FOLD_CASE_DEFAULT, &status);
+                    if (status > U_ZERO_ERROR || length != 1 || static_cast<wchar_t>(full[0]) != folded)
+                    {
+                        t->unsupported.set(c);
+                    }
+                }
+            }
+
+            return t;
+        }();
+        return *tables;
+    }
+}
+
+std::optional<LiteralSearcher> LiteralSearcher::Create(const std::wstring_view& needle, bool caseInsensitive)
+{
+    if (needle.empty())
+    {
+        return std::nullopt;
+    }
+
+    LiteralSearcher searcher;
+    searcher._caseInsensitive = caseInsensitive;
+
+    if (!caseInsensitive)
+    {
+        // A needle that starts or ends in the middle of a surrogate pair would match half of a
+        // pair in the text, whereas ICU operates on code points and wouldn't find anything.
+        if (U16_IS_TRAIL(needle.front()) || U16_IS_LEAD(needle.back()))
+        {
+            return std::nullopt;
+        }
+
+        searcher._needle = needle;
+        searcher._firstVariants.fill(needle.front());
+        searcher._lastVariants.fill(needle.back());
+        return searcher;
+    }
+
+    const auto& tables = getFoldTables();
+
+    searcher._needle.reserve(needle.size());
+    for (const auto ch : needle)
+    {
+        if (tables.unsupported.test(ch))
+        {
+            return std::nullopt;
+        }
+        searcher._needle.push_back(til::at(tables.fold, ch));
+    }
+
+    // Collects all supported characters that fold to `folded`.
+    const auto collectVariants = [&](wchar_t folded, std::array<wchar_t, MaxVariants>& variants) {
+        size_t count = 0;
+
+        for (uint32_t c = 0; c < 0x10000; ++c)
+        {
+            if (til::at(tables.fold, c) == folded && !tables.unsupported.test(c))
+            {
+                if (count == MaxVariants)
+                {
+                    return false;
+                }
+                til::at(variants, count++) = static_cast<wchar_t>(c);
+            }
+        }
+
+        std::fill(variants.begin() + count, variants.end(), variants.front());
+        return count != 0;
+    };
+
+    if (!collectVariants(searcher._needle.front(), searcher._firstVariants) ||
+        !collectVariants(searcher._needle.back(), searcher._lastVariants))
+    {
+        return std::nullopt;
+    }
+
+    searcher._fold = tables.fold.data();
+    return searcher;
+}
+
+// Returns false if the text contains characters for which our
+// simple case folding would produce results different from ICU's.
+bool LiteralSearcher::IsSupportedText(const std::wstring_view& text) const noexcept
+{
+    if (!_caseInsensitive)
+    {
+        return true;
+    }
+
+    const auto& tables = getFoldTables();
+    for (const auto ch : text)
+    {
+        if (ch >= 0x80 && tables.unsupported.test(ch))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+size_t LiteralSearcher::NeedleLength() const noexcept
+{
+    return _needle.size();
+}
+
+// Returns the offset of the first occurrence of the needle in `text` at or after `offset`, or npos.
+size_t LiteralSearcher::Find(const std::wstring_view& text, size_t offset) const noexcept
+{
+    const auto n = _needle.size();
+    if (offset > text.size() || text.size() - offset < n)
+    {
+        return std::wstring_view::npos;
+    }
+
+    const auto beg = text.data();
+    auto it = beg + offset;
+    // The last position at which the needle may start.
+    const auto last = beg + (text.size() - n);
+
+    // The vectorized code below checks the first and last character of the needle at the same time:
+    // It loads a vector of characters at `it` as well as `it + n - 1` and compares them against all
+    // variants of the first and last needle character respectively. Only positions where both of them
+    // match are then verified with _matchesAt(). For the common case of a needle that's rare in the text
+    // this skips 8 (SSE2, NEON) or 16 (AVX2) characters per iteration.
+#if defined(TIL_SSE_INTRINSICS)
+
+    if (__isa_available >= __ISA_AVAILABLE_AVX2)
+    {
+        const auto f0 = _mm256_set1_epi16(static_cast<short>(_firstVariants[0]));
+        const auto f1 = _mm256_set1_epi16(static_cast<short>(_firstVariants[1]));
+        const auto f2 = _mm256_set1_epi16(static_cast<short>(_firstVariants[2]));
+        const auto f3 = _mm256_set1_epi16(static_cast<short>(_firstVariants[3]));
+        const auto l0 = _mm256_set1_epi16(static_cast<short>(_lastVariants[0]));
+        const auto l1 = _mm256_set1_epi16(static_cast<short>(_lastVariants[1]));
+        const auto l2 = _mm256_set1_epi16(static_cast<short>(_lastVariants[2]));
+        const auto l3 = _mm256_set1_epi16(static_cast<short>(_lastVariants[3]));
+
+        for (; last - it >= 15; it += 16)
+        {
+            const auto a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(it));
+            const auto b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(it + n - 1));
+            const auto ma = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi16(a, f0), _mm256_cmpeq_epi16(a, f1)), _mm256_or_si256(_mm256_cmpeq_epi16(a, f2), _mm256_cmpeq_epi16(a, f3)));
+            const auto mb = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi16(b, l0), _mm256_cmpeq_epi16(b, l1)), _mm256_or_si256(_mm256_cmpeq_epi16(b, l2), _mm256_cmpeq_epi16(b, l3)));
+            auto mask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_and_si256(ma, mb)));
+
+            while (mask)
+            {
+                unsigned long index;
+                _BitScanForward(&index, mask);
+                // Each 16-bit lane results in 2 bits in the mask.
+                const auto candidate = it + index / 2;
+                if (_matchesAt(candidate))
+                {
+                    return candidate - beg;
+                }
+                mask &= ~(3u << index);
+            }
+        }
+    }
+
+    {
+        const auto f0 = _mm_set1_epi16(static_cast<short>(_firstVariants[0]));
+        const auto f1 = _mm_set1_epi16(static_cast<short>(_firstVariants[1]));
+        const auto f2 = _mm_set1_epi16(static_cast<short>(_firstVariants[2]));
+        const auto f3 = _mm_set1_epi16(static_cast<short>(_firstVariants[3]));
+        const auto l0 = _mm_set1_epi16(static_cast<short>(_lastVariants[0]));
+        const auto l1 = _mm_set1_epi16(static_cast<short>(_lastVariants[1]));
+        const auto l2 = _mm_set1_epi16(static_cast<short>(_lastVariants[2]));
+        const auto l3 = _mm_set1_epi16(static_cast<short>(_lastVariants[3]));
+
+        for (; last - it >= 7; it += 8)
+        {
+            const auto a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(it));
+            const auto b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(it + n - 1));
+            const auto ma = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi16(a, f0), _mm_cmpeq_epi16(a, f1)), _mm_or_si128(_mm_cmpeq_epi16(a, f2), _mm_cmpeq_epi16(a, f3)));
+            const auto mb = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi16(b, l0), _mm_cmpeq_epi16(b, l1)), _mm_or_si128(_mm_cmpeq_epi16(b, l2), _mm_cmpeq_epi16(b, l3)));
+            auto mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_and_si128(ma, mb)));
+
+            while (mask)
+            {
+                unsigned long index;
+                _BitScanForward(&index, mask);
+                const auto candidate = it + index / 2;
+                if (_matchesAt(candidate))
+                {
+                    return candidate - beg;
+                }
+                mask &= ~(3u << index);
+            }
+        }
+    }
+
+#elif defined(TIL_ARM_NEON_INTRINSICS)
+
+    {
+        const auto f0 = vdupq_n_u16(_firstVariants[0]);
+        const auto f1 = vdupq_n_u16(_firstVariants[1]);
+        const auto f2 = vdupq_n_u16(_firstVariants[2]);
+        const auto f3 = vdupq_n_u16(_firstVariants[3]);
+        const auto l0 = vdupq_n_u16(_lastVariants[0]);
+        const auto l1 = vdupq_n_u16(_lastVariants[1]);
+        const auto l2 = vdupq_n_u16(_lastVariants[2]);
+        const auto l3 = vdupq_n_u16(_lastVariants[3]);
+
+        for (; last - it >= 7; it += 8)
+        {
+            const auto a = vld1q_u16(reinterpret_cast<const uint16_t*>(it));
+            const auto b = vld1q_u16(reinterpret_cast<const uint16_t*>(it + n - 1));
+            const auto ma = vorrq_u16(vorrq_u16(vceqq_u16(a, f0), vceqq_u16(a, f1)), vorrq_u16(vceqq_u16(a, f2), vceqq_u16(a, f3)));
+            const auto mb = vorrq_u16(vorrq_u16(vceqq_u16(b, l0), vceqq_u16(b, l1)), vorrq_u16(vceqq_u16(b, l2), vceqq_u16(b, l3)));
+            // NEON lacks movemask. Shifting each 16-bit lane right by 4 and narrowing it to 8 bits
+            // results in a 64-bit integer with 4 bits per lane, which serves the same purpose.
+            auto mask = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vandq_u16(ma, mb), 4)), 0);
+
+            while (mask)
+            {
+                unsigned long index;
+                _BitScanForward64(&index, mask);
+                const auto candidate = it + index / 4;
+                if (_matchesAt(candidate))
+                {
+                    return candidate - beg;
+                }
+                mask &= ~(uint64_t{ 0xf } << (index & ~3ul));
+            }
+        }
+    }
+
+#endif
+
+    return _findScalar(beg, it, last);
+}
+
+size_t LiteralSearcher::_findScalar(const wchar_t* beg, const wchar_t* it, const wchar_t* last) const noexcept
+{
+    for (; it <= last; ++it)
+    {
+        if (_matchesAt(it))
+        {
+            return it - beg;
+        }
+    }
+    return std::wstring_view::npos;
+}
+
+bool LiteralSearcher::_matchesAt(const wchar_t* it) const noexcept
+{
+    const auto n = _needle.size();
+    const auto needle = _needle.data();
+
+    if (!_caseInsensitive)
+    {
+        return wmemcmp(it, needle, n) == 0;
+    }
+
+    for (size_t i = 0; i < n; ++i)
+    {
+        if (_fold[it[i]] != needle[i])
+        {
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,48 @@
+/*++
+Copyright (c) Microsoft Corporation
+Licensed under the MIT license.
+
+Module Name:
+- LiteralSearcher.hpp
+
+Abstract:
+- A fast path for TextBuffer::SearchText that finds literal (non-regex) needles
+  in ROW text directly, without going through ICU's regex engine and UText.
+- It uses SIMD to filter candidate positions by their first and last character
+  and supports case-insensitive matching via simple case folding of the BMP.
+  Text for which simple and full case folding disagree (e.g. U+00DF) must be
+  searched with ICU instead. See IsSupportedText().
+--*/
+
+#pragma once
+
+class LiteralSearcher
+{
+public:
+    // Returns nullopt if the needle can't be handled by this class.
+    static std::optional<LiteralSearcher> Create(const std::wstring_view& needle, bool caseInsensitive);
+
+    bool IsSupportedText(const std::wstring_view& text) const noexcept;
+    size_t Find(const std::wstring_view& text, size_t offset) const noexcept;
+    size_t NeedleLength() const noexcept;
+
+private:
+    // Up to this many characters may fold to the same character. With simple case folding in the BMP
+    // this is at most 4 (e.g. "θ", "ϑ", "Θ" and "ϴ"). Needles for which this isn't true are rejected.
+    static constexpr size_t MaxVariants = 4;
+
+    LiteralSearcher() = default;
+
+    bool _matchesAt(const wchar_t* it) const noexcept;
+    size_t _findScalar(const wchar_t* beg, const wchar_t* it, const wchar_t* last) const noexcept;
+
+    // The needle, folded if _caseInsensitive is true.
+    std::wstring _needle;
+    // All characters which (when folded) are equal to the needle's first and last character respectively.
+    // Unused slots are filled with duplicates of the first entry, so that they can always all be compared.
+    std::array<wchar_t, MaxVariants> _firstVariants{};
+    std::array<wchar_t, MaxVariants> _lastVariants{};
+    // The simple case folding table. Only set if _caseInsensitive is true.
+    const wchar_t* _fold = nullptr;
+    bool _caseInsensitive = false;
+};
@@ -5,6 +5,7 @@
 #include "Row.hpp"
 
 #include <isa_availability.h>
+#include <til/hash.h>
 
 #include "../../types/inc/CodepointWidthDetector.hpp"
 
@@ -169,9 +170,17 @@ ROW::ROW(wchar_t* charsBuffer, uint16_t* charOffsetsBuffer, uint16_t rowWidth, c
     _init();
 }
 
+// See _flagsDirtyWord.
+void ROW::SetFlagsDirtyBit(uint64_t* word, uint64_t mask) noexcept
+{
+    _flagsDirtyWord = word;
+    _flagsDirtyMask = mask;
+}
+
 void ROW::SetWrapForced(const bool wrap) noexcept
 {
     _wrapForced = wrap;
+    _flagsChanged();
 }
 
 bool ROW::WasWrapForced() const noexcept
@@ -182,6 +191,7 @@ bool ROW::WasWrapForced() const noexcept
 void ROW::SetDoubleBytePadded(const bool doubleBytePadded) noexcept
 {
     _doubleBytePadded = doubleBytePadded;
+    _invalidateSearchSummary();
 }
 
 bool ROW::WasDoubleBytePadded() const noexcept
@@ -192,6 +202,7 @@ bool ROW::WasDoubleBytePadded() const noexcept
 void ROW::SetLineRendition(const LineRendition lineRendition) noexcept
 {
     _lineRendition = lineRendition;
+    _invalidateSearchSummary();
 }
 
 LineRendition ROW::GetLineRendition() const noexcept
@@ -231,6 +242,8 @@ void ROW::Reset(const TextAttribute& attr) noexcept
     _doubleBytePadded = false;
     _promptData = std::nullopt;
     _init();
+    _invalidateSearchSummary();
+    _flagsChanged();
 }
 
 void ROW::_init() noexcept
@@ -352,6 +365,8 @@ void ROW::CopyFrom(const ROW& source)
 {
     _lineRendition = source._lineRendition;
     _wrapForced = source._wrapForced;
+    _invalidateSearchSummary();
+    _flagsChanged();
 
     RowCopyTextFromState state{
         .source = source,
@@ -857,6 +872,7 @@ catch (...)
 
 [[msvc::forceinline]] void ROW::WriteHelper::Finish()
 {
+    row._invalidateSearchSummary();
     colEndDirty = row._adjustForward(colEndDirty);
 
     const uint16_t trailingSpaces = colEndDirty - colEnd;
@@ -952,6 +968,47 @@ TextAttribute ROW::GetAttrByColumn(const til::CoordType column) const
     return _attr.at(_clampedColumn(column));
 }
 
+// Appends the glyphs in the columns [columnBegin,columnEnd) to runs, split up by their attributes.
+// A wide glyph belongs to the run of its leading half. If columnBegin points at the trailing half
+// of a wide glyph, the first run starts at its leading half, so check the columnBegin of the result.
+// This is a lot cheaper than walking the row with a TextBufferCellIterator, because
+// the work is done per attribute run instead of per cell.
+void ROW::GetTextRuns(const til::CoordType columnBegin, const til::CoordType columnEnd, std::vector<RowTextRun>& runs) const
+{
+    const auto end = _clampedColumnInclusive(std::min(columnEnd, GetReadableColumnCount()));
+    auto pos = _adjustBackward(_clampedColumn(columnBegin));
+    auto runBeg = 0;
+
+    for (const auto& run : _attr.runs())
+    {
+        const auto runEnd = runBeg + run.length;
+        if (runEnd <= pos)
+        {
+            runBeg = runEnd;
+            continue;
+        }
+        if (pos >= end)
+        {
+            break;
+        }
+
+        // If the attribute run ends in the middle of a wide glyph, the rest of the glyph still belongs to this run.
+        const auto glyphEnd = _adjustForward(gsl::narrow_cast<uint16_t>(std::min<int>(runEnd, end)));
+        if (glyphEnd > pos)
+        {
+            runs.emplace_back(RowTextRun{
+                .text = GetText(pos, glyphEnd),
+                .columnBegin = pos,
+                .columnEnd = glyphEnd,
+                .attr = run.value,
+            });
+            pos = glyphEnd;
+        }
+
+        runBeg = runEnd;
+    }
+}
+
 std::vector<uint16_t> ROW::GetHyperlinks() const
 {
     std::vector<uint16_t> ids;
@@ -1237,6 +1294,7 @@ const std::optional<ScrollbarData>& ROW::GetScrollbarData() const noexcept
 void ROW::SetScrollbarData(std::optional<ScrollbarData> data) noexcept
 {
     _promptData = data;
+    _flagsChanged();
 }
 
 void ROW::StartPrompt() noexcept
@@ -1257,6 +1315,7 @@ void ROW::StartPrompt() noexcept
         // https://github.com/microsoft/terminal/pull/16937#discussion_r1553660833
 
         _promptData.emplace(MarkCategory::Prompt);
+        _flagsChanged();
     }
 }
 
@@ -1271,3 +1330,256 @@ void ROW::EndOutput(std::optional<unsigned int> error) noexcept
         }
     }
 }
+
+void RowSearchSummary::AddBigram(wchar_t a, wchar_t b) noexcept
+{
+    // Fibonacci hashing: The top 8 bits of the product are well distributed even for small inputs.
+    const auto h = (static_cast<uint32_t>(a) << 16 | b) * 0x9E3779B1u;
+    const auto bit = h >> 24;
+    til::at(bloom, bit >> 6) |= uint64_t{ 1 } << (bit & 63);
+}
+
+bool RowSearchSummary::MayContainBigram(wchar_t a, wchar_t b) const noexcept
+{
+    const auto h = (static_cast<uint32_t>(a) << 16 | b) * 0x9E3779B1u;
+    const auto bit = h >> 24;
+    return (til::at(bloom, bit >> 6) & (uint64_t{ 1 } << (bit & 63))) != 0;
+}
+
+const RowSearchSummary& ROW::GetSearchSummary() const noexcept
+{
+    if (_searchSummaryValid)
+    {
+        return _searchSummary;
+    }
+
+    const auto text = GetText();
+    RowSearchSummary summary;
+
+    if (!text.empty())
+    {
+        auto prev = RowSearchSummary::Fold(text.front());
+        auto nonAscii = text.front() >= 0x80;
+
+        for (const auto ch : text.substr(1))
+        {
+            const auto folded = RowSearchSummary::Fold(ch);
+            summary.AddBigram(prev, folded);
+            nonAscii |= ch >= 0x80;
+            prev = folded;
+        }
+
+        summary.first = RowSearchSummary::Fold(text.front());
+        summary.last = prev;
+        summary.nonAscii = nonAscii;
+    }
+
+    _searchSummary = summary;
+    _searchSummaryValid = true;
+    return _searchSummary;
+}
+
+void ROW::_invalidateSearchSummary() noexcept
+{
+    _searchSummaryValid = false;
+}
+
+void ROW::_flagsChanged() noexcept
+{
+    if (_flagsDirtyWord)
+    {
+        *_flagsDirtyWord |= _flagsDirtyMask;
+    }
+}
+
+// Returns the ID of the given attribute, adding it to the palette if needed.
+// Returns nullopt if the palette is full, because IDs are limited to 16 bits.
+std::optional<uint16_t> AttributePalette::Intern(const TextAttribute& attr)
+{
+    if (const auto it = _ids.find(attr); it != _ids.end())
+    {
+        return it->second;
+    }
+    if (_attributes.size() > UINT16_MAX)
+    {
+        return std::nullopt;
+    }
+
+    const auto id = gsl::narrow_cast<uint16_t>(_attributes.size());
+    _attributes.emplace_back(attr);
+    _ids.emplace(attr, id);
+    return id;
+}
+
+const TextAttribute& AttributePalette::Get(uint16_t id) const
+{
+    return til::at(_attributes, id);
+}
+
+size_t AttributePalette::Size() const noexcept
+{
+    return _attributes.size();
+}
+
+void AttributePalette::Clear() noexcept
+{
+    _attributes.clear();
+    _ids.clear();
+}
+
+size_t AttributePalette::Hash::operator()(const TextAttribute& attr) const noexcept
+{
+    // TextAttribute::operator== compares the bytes as well.
+    return til::hasher{}.write(static_cast<const void*>(&attr), sizeof(attr)).finalize();
+}
+
+std::vector<uint16_t> PackedRow::GetHyperlinks(const AttributePalette& palette) const
+{
+    std::vector<uint16_t> ids;
+    for (const auto& run : attr)
+    {
+        const auto& value = palette.Get(run.value);
+        if (value.IsHyperlink())
+        {
+            ids.emplace_back(value.GetHyperlinkId());
+        }
+    }
+    return ids;
+}
+
+// Image slices are comparatively large and rare. Rows with them are simply kept as is.
+bool ROW::IsPackable() const noexcept
+{
+    return !_imageSlice;
+}
+
+// Returns nullopt if the attributes don't fit into the palette anymore.
+std::optional<PackedRow> ROW::Pack(AttributePalette& palette) const
+{
+    PackedRow packed;
+
+    // Trim the trailing whitespace, as long as each of those columns holds exactly 1 space.
+    // This is what allows Unpack() to restore them without storing anything about them.
+    auto columns = _columnCount;
+    for (; columns > 0; --columns)
+    {
+        const auto offset = _charOffsets[columns - 1u];
+        if ((offset & CharOffsetsTrailer) || _uncheckedCharOffset(columns) - offset != 1 || _chars[offset] != L' ')
+        {
+            break;
+        }
+    }
+
+    const std::wstring_view text{ _chars.data(), _uncheckedCharOffset(columns) };
+    packed.columns = columns;
+
+    auto trivialOffsets = text.size() == columns;
+    for (uint16_t i = 0; trivialOffsets && i <= columns; ++i)
+    {
+        trivialOffsets = _charOffsets[i] == i;
+    }
+    if (!trivialOffsets)
+    {
+        packed.charOffsets.assign(_charOffsets.begin(), _charOffsets.begin() + columns + 1u);
+    }
+
+    if (std::all_of(text.begin(), text.end(), [](wchar_t ch) { return ch < 0x100; }))
+    {
+        packed.encoding = PackedRow::Encoding::Latin1;
+        packed.text.resize(text.size());
+        std::transform(text.begin(), text.end(), packed.text.begin(), [](wchar_t ch) { return static_cast<char>(ch); });
+    }
+    else if (SUCCEEDED(til::u16u8(text, packed.text)) && til::u8u16(packed.text) == text)
+    {
+        packed.encoding = PackedRow::Encoding::Utf8;
+    }
+    else
+    {
+        packed.encoding = PackedRow::Encoding::Utf16;
+        packed.text.resize(text.size() * sizeof(wchar_t));
+        memcpy(packed.text.data(), text.data(), packed.text.size());
+    }
+
+    packed.attr.reserve(_attr.runs().size());
+    for (const auto& run : _attr.runs())
+    {
+        const auto id = palette.Intern(run.value);
+        if (!id)
+        {
+            return std::nullopt;
+        }
+        packed.attr.emplace_back(*id, run.length);
+    }
+
+    packed.promptData = _promptData;
+    packed.searchSummary = GetSearchSummary();
+    packed.lineRendition = _lineRendition;
+    packed.wrapForced = _wrapForced;
+    packed.doubleBytePadded = _doubleBytePadded;
+    return packed;
+}
+
+// Restores the contents of a row previously packed with Pack().
+// This row must be at least as wide as the one that was packed.
+void ROW::Unpack(const PackedRow& packed, const AttributePalette& palette)
+{
+    assert(packed.columns <= _columnCount);
+
+    std::wstring text;
+    switch (packed.encoding)
+    {
+    case PackedRow::Encoding::Latin1:
+        text.resize(packed.text.size());
+        std::transform(packed.text.begin(), packed.text.end(), text.begin(), [](char ch) { return static_cast<wchar_t>(static_cast<uint8_t>(ch)); });
+        break;
+    case PackedRow::Encoding::Utf8:
+        text = til::u8u16(packed.text);
+        break;
+    default:
+        text.resize(packed.text.size() / sizeof(wchar_t));
+        memcpy(text.data(), packed.text.data(), text.size() * sizeof(wchar_t));
+        break;
+    }
+
+    Reset(packed.attr.empty() ? TextAttribute{} : palette.Get(packed.attr.front().value));
+
+    const auto spaces = static_cast<size_t>(_columnCount - packed.columns);
+    const auto length = text.size() + spaces;
+
+    if (length > _chars.size())
+    {
+        const auto capacity = gsl::narrow<uint16_t>(length);
+        _charsHeap = std::make_unique_for_overwrite<wchar_t[]>(capacity);
+        _chars = { _charsHeap.get(), capacity };
+    }
+
+    std::fill_n(std::copy(text.begin(), text.end(), _chars.begin()), spaces, L' ');
+
+    // Reset() initialized _charOffsets for exactly 1 character per column.
+    if (!packed.charOffsets.empty())
+    {
+        std::copy(packed.charOffsets.begin(), packed.charOffsets.end(), _charOffsets.begin());
+        iota_n(_charOffsets.begin() + packed.columns + 1u, spaces, gsl::narrow_cast<uint16_t>(text.size() + 1));
+    }
+
+    if (!packed.attr.empty())
+    {
+        std::vector<til::rle_pair<TextAttribute, uint16_t>> runs;
+        runs.reserve(packed.attr.size());
+        for (const auto& run : packed.attr)
+        {
+            runs.emplace_back(palette.Get(run.value), run.length);
+        }
+        _attr.replace(0, _columnCount, std::span{ runs });
+        // The packed row may have been narrower than this one (see SpillLog).
+        _attr.resize_trailing_extent(_columnCount);
+    }
+
+    _promptData = packed.promptData;
+    _lineRendition = packed.lineRendition;
+    _wrapForced = packed.wrapForced;
+    _doubleBytePadded = packed.doubleBytePadded;
+    _searchSummary = packed.searchSummary;
+    _searchSummaryValid = true;
+    _flagsChanged();
+}
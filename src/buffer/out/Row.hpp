@@ -67,6 +67,17 @@ struct RowCopyTextFromState
     til::CoordType sourceColumnEnd = 0; // OUT
 };
 
+// A run of glyphs that share the same attributes, as returned by ROW::GetTextRuns().
+struct RowTextRun
+{
+    // The text of all glyphs in the run.
+    std::wstring_view text;
+    // The columns covered by the glyphs in the run, including the trailing half of the last wide glyph.
+    til::CoordType columnBegin = 0;
+    til::CoordType columnEnd = 0;
+    TextAttribute attr;
+};
+
 // This structure is basically an inverse of ROW::_charOffsets. If you have a pointer
 // into a ROW's text this class can tell you what cell that pointer belongs to.
 struct CharToColumnMapper
@@ -89,6 +100,90 @@ private:
     til::CoordType _currentColumn;
 };
 
+// A cheap, conservative summary of a ROW's text. TextBuffer::SearchText uses it to skip rows that can't possibly
+// contain a literal needle.
+// It's computed lazily by ROW::GetSearchSummary() and invalidated whenever the row's text changes.
+struct RowSearchSummary
+{
+    // Bigrams are hashed into a 256-bit bloom filter with 1 bit each. At 120 columns of dense
+    // text this fills about a third of the filter, which is plenty to reject the majority
+    // of rows for any needle that's longer than a couple characters.
+    static constexpr size_t BloomWords = 4;
+
+    // Only ASCII is folded, because ICU's full case folding can map non-ASCII characters
+    // to ASCII ones (e.g. U+212A KELVIN SIGN to "k" or U+00DF to "ss"). See nonAscii.
+    static constexpr wchar_t Fold(wchar_t ch) noexcept
+    {
+        return ch >= L'A' && ch <= L'Z' ? static_cast<wchar_t>(ch | 0x20) : ch;
+    }
+
+    void AddBigram(wchar_t a, wchar_t b) noexcept;
+    bool MayContainBigram(wchar_t a, wchar_t b) const noexcept;
+
+    std::array<uint64_t, BloomWords> bloom{};
+    // The folded first and last character of the row's text (0 if it's empty).
+    // These are used to reconstruct the bigram spanning two soft-wrapped rows.
+    wchar_t first = 0;
+    wchar_t last = 0;
+    // Case-insensitive searches can't trust the bloom filter for rows with non-ASCII text. See Fold().
+    bool nonAscii = false;
+};
+
+// Interns TextAttributes for PackedRow, so that its attribute runs only need to store a 16-bit ID instead
+// of an entire TextAttribute. The entries aren't reference counted. Instead, TextBuffer periodically rebuilds
+// the palette from the attributes its packed rows still use. See TextBuffer::_compactAttributePalette().
+// Live ROWs deliberately don't use it (see ROW::_attr), which limits the palette to the packed scrollback.
+class AttributePalette
+{
+public:
+    std::optional<uint16_t> Intern(const TextAttribute& attr);
+    const TextAttribute& Get(uint16_t id) const;
+    size_t Size() const noexcept;
+    void Clear() noexcept;
+
+private:
+    struct Hash
+    {
+        size_t operator()(const TextAttribute& attr) const noexcept;
+    };
+
+    std::vector<TextAttribute> _attributes;
+    std::unordered_map<TextAttribute, uint16_t, Hash> _ids;
+};
+
+// A compact copy of a ROW, which TextBuffer uses to store rows in the scrollback far away from the cursor.
+// See ROW::Pack() and ROW::Unpack(). The text is trimmed by its trailing whitespace and stored as Latin-1
+// if possible and as UTF-8 otherwise. ROW::_charOffsets is only stored if it isn't trivial (wide glyphs, etc.).
+struct PackedRow
+{
+    enum class Encoding : uint8_t
+    {
+        Latin1,
+        Utf8,
+        // Used for text that doesn't survive a roundtrip through UTF-8 (unpaired surrogates).
+        Utf16,
+    };
+
+    std::vector<uint16_t> GetHyperlinks(const AttributePalette& palette) const;
+
+    std::string text;
+    // Empty if each of the first `columns` columns contains exactly 1 character.
+    // Otherwise it's a copy of ROW::_charOffsets[0..columns] (inclusive).
+    std::vector<uint16_t> charOffsets;
+    // The attribute runs as IDs into the AttributePalette that was passed to ROW::Pack().
+    std::vector<til::rle_pair<uint16_t, uint16_t>> attr;
+    std::optional<ScrollbarData> promptData;
+    // ROW::GetSearchSummary() at the time it was packed. This allows TextBuffer::SearchText()
+    // to skip packed rows without decoding them.
+    RowSearchSummary searchSummary;
+    // The number of columns covered by `text`. The remaining ones contain whitespace.
+    uint16_t columns = 0;
+    Encoding encoding = Encoding::Latin1;
+    LineRendition lineRendition = LineRendition::SingleWidth;
+    bool wrapForced = false;
+    bool doubleBytePadded = false;
+};
+
 class ROW final
 {
 public:
@@ -124,6 +219,7 @@ public:
     ROW(ROW&& other) = default;
     ROW& operator=(ROW&& other) = default;
 
+    void SetFlagsDirtyBit(uint64_t* word, uint64_t mask) noexcept;
     void SetWrapForced(const bool wrap) noexcept;
     bool WasWrapForced() const noexcept;
     void SetDoubleBytePadded(const bool doubleBytePadded) noexcept;
@@ -151,6 +247,7 @@ public:
     til::small_rle<TextAttribute, uint16_t, 1>& Attributes() noexcept;
     const til::small_rle<TextAttribute, uint16_t, 1>& Attributes() const noexcept;
     TextAttribute GetAttrByColumn(til::CoordType column) const;
+    void GetTextRuns(til::CoordType columnBegin, til::CoordType columnEnd, std::vector<RowTextRun>& runs) const;
     std::vector<uint16_t> GetHyperlinks() const;
     ImageSlice* SetImageSlice(ImageSlice::Pointer imageSlice) noexcept;
     const ImageSlice* GetImageSlice() const noexcept;
@@ -176,6 +273,12 @@ public:
     void StartPrompt() noexcept;
     void EndOutput(std::optional<unsigned int> error) noexcept;
 
+    const RowSearchSummary& GetSearchSummary() const noexcept;
+
+    bool IsPackable() const noexcept;
+    std::optional<PackedRow> Pack(AttributePalette& palette) const;
+    void Unpack(const PackedRow& packed, const AttributePalette& palette);
+
 #ifdef UNIT_TESTING
     friend constexpr bool operator==(const ROW& a, const ROW& b) noexcept;
     friend class RowTests;
@@ -252,6 +355,8 @@ private:
     T _adjustForward(T column) const noexcept;
 
     void _init() noexcept;
+    void _invalidateSearchSummary() noexcept;
+    void _flagsChanged() noexcept;
     void _resizeChars(uint16_t colEndDirty, uint16_t chBegDirty, size_t chEndDirty, uint16_t chEndDirtyOld);
     CharToColumnMapper _createCharToColumnMapper(ptrdiff_t offset) const noexcept;
 
@@ -297,6 +402,9 @@ private:
     std::span<uint16_t> _charOffsets;
     // _attr is a run-length-encoded vector of TextAttribute with a decompressed
     // length equal to _columnCount (= 1 TextAttribute per column).
+    // It stores full TextAttributes and not AttributePalette IDs. Most of the scrollback is packed anyway
+    // (see TextBuffer::PackColdRows()), while IDs would require every reader and writer of live rows
+    // to go through the buffer's palette and its compaction to remap the IDs of all live rows.
     til::small_rle<TextAttribute, uint16_t, 1> _attr;
     // The width of the row in visual columns.
     uint16_t _columnCount = 0;
@@ -308,9 +416,17 @@ private:
     bool _doubleBytePadded = false;
 
     std::optional<ScrollbarData> _promptData = std::nullopt;
+    // If set, _flagsChanged() sets the _flagsDirtyMask bits in this word whenever _wrapForced or _promptData change.
+    // TextBuffer uses this to keep its index of those flags up to date. See TextBuffer::_refreshRowFlags().
+    uint64_t* _flagsDirtyWord = nullptr;
+    uint64_t _flagsDirtyMask = 0;
 
     // Stores any image content covering the row.
     ImageSlice::Pointer _imageSlice;
+
+    // Lazily computed by GetSearchSummary(). It's reset whenever the text changes.
+    mutable RowSearchSummary _searchSummary;
+    mutable bool _searchSummaryValid = false;
 };
 
 #ifdef UNIT_TESTING
@@ -0,0 +1,251 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+#include "SpillLog.hpp"
+
+#pragma warning(disable : 26481) // Don't use pointer arithmetic. Use span instead (bounds.1).
+
+// Each attribute run is stored as the TextAttribute followed by its uint16_t length.
+// The log stores the attributes themselves instead of AttributePalette IDs, because the palette of
+// the TextBuffer is compacted over time and the log would otherwise need to keep all of its entries alive.
+static_assert(std::is_trivially_copyable_v<TextAttribute>);
+static constexpr size_t attrRunSize = sizeof(TextAttribute) + sizeof(uint16_t);
+
+SpillLog::SpillLog()
+{
+    std::array<wchar_t, MAX_PATH + 1> directory{};
+    std::array<wchar_t, MAX_PATH + 1> path{};
+    THROW_LAST_ERROR_IF(GetTempPathW(gsl::narrow_cast<DWORD>(directory.size()), directory.data()) == 0);
+    THROW_LAST_ERROR_IF(GetTempFileNameW(directory.data(), L"wt", 0, path.data()) == 0);
+
+    // FILE_ATTRIBUTE_TEMPORARY hints the cache manager to avoid flushing the data to disk for as long as there's enough memory.
+    // FILE_FLAG_DELETE_ON_CLOSE ensures that we don't leave multi-GB files behind, even if we crash.
+    _file.reset(CreateFileW(path.data(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_TEMPORARY | FILE_FLAG_DELETE_ON_CLOSE, nullptr));
+    THROW_LAST_ERROR_IF(!_file);
+}
+
+uint64_t SpillLog::RowCount() const noexcept
+{
+    return _rowCount;
+}
+
+// Returns the width of the widest row that was appended so far.
+til::CoordType SpillLog::MaxColumns() const noexcept
+{
+    return _maxColumns;
+}
+
+// Returns the scrollbar marks of all rows in the log, ordered by their row index.
+const std::vector<SpilledMark>& SpillLog::Marks() const noexcept
+{
+    return _marks;
+}
+
+// The row's attribute IDs refer to the given palette.
+void SpillLog::Append(const PackedRow& row, const AttributePalette& palette)
+{
+    const auto payloadSize = sizeof(RecordHeader) + row.text.size() + row.charOffsets.size() * sizeof(uint16_t) + row.attr.size() * attrRunSize;
+    const auto size = (payloadSize + 7) & ~size_t{ 7 };
+    // ROWs are at most 65535 columns wide, which puts an upper bound of a few MiB on this.
+    THROW_HR_IF(E_UNEXPECTED, size > SegmentSize);
+
+    if (!_writeView || size > SegmentSize - _writeOffset)
+    {
+        _beginSegment(_writeView ? _writeSegment + 1 : 0);
+    }
+
+    if (_rowCount % CheckpointInterval == 0)
+    {
+        _checkpoints.emplace_back(uint64_t{ _writeSegment } * SegmentSize + _writeOffset);
+    }
+
+    uint16_t columns = 0;
+    for (const auto& run : row.attr)
+    {
+        columns += run.length;
+    }
+
+    uint8_t flags = 0;
+    WI_SetFlagIf(flags, FlagWrapForced, row.wrapForced);
+    WI_SetFlagIf(flags, FlagDoubleBytePadded, row.doubleBytePadded);
+
+    const RecordHeader header{
+        .size = gsl::narrow_cast<uint32_t>(size),
+        .textSize = gsl::narrow_cast<uint32_t>(row.text.size()),
+        .columns = row.columns,
+        .charOffsetCount = gsl::narrow_cast<uint16_t>(row.charOffsets.size()),
+        .attrCount = gsl::narrow_cast<uint16_t>(row.attr.size()),
+        .encoding = static_cast<uint8_t>(row.encoding),
+        .lineRendition = static_cast<uint8_t>(row.lineRendition),
+        .flags = flags,
+    };
+
+    auto ptr = _writeView.get() + _writeOffset;
+    memcpy(ptr, &header, sizeof(header));
+    ptr += sizeof(header);
+    memcpy(ptr, row.text.data(), row.text.size());
+    ptr += row.text.size();
+    memcpy(ptr, row.charOffsets.data(), row.charOffsets.size() * sizeof(uint16_t));
+    ptr += row.charOffsets.size() * sizeof(uint16_t);
+    for (const auto& run : row.attr)
+    {
+        memcpy(ptr, &palette.Get(run.value), sizeof(TextAttribute));
+        memcpy(ptr + sizeof(TextAttribute), &run.length, sizeof(uint16_t));
+        ptr += attrRunSize;
+    }
+
+    _writeOffset += size;
+
+    if (row.promptData)
+    {
+        _marks.emplace_back(SpilledMark{ _rowCount, *row.promptData });
+    }
+
+    _maxColumns = std::max<til::CoordType>(_maxColumns, columns);
+    _rowCount++;
+}
+
+// Returns the rows [beg,end) in the order they were appended.
+// Their attributes are interned into the given palette.
+std::vector<PackedRow> SpillLog::Read(uint64_t beg, uint64_t end, AttributePalette& palette) const
+{
+    THROW_HR_IF(E_BOUNDS, beg > end || end > _rowCount);
+
+    std::vector<PackedRow> rows;
+    if (beg == end)
+    {
+        return rows;
+    }
+    rows.reserve(gsl::narrow<size_t>(end - beg));
+
+    const auto checkpoint = til::at(_checkpoints, gsl::narrow_cast<size_t>(beg / CheckpointInterval));
+    auto segment = gsl::narrow_cast<size_t>(checkpoint / SegmentSize);
+    auto offset = gsl::narrow_cast<size_t>(checkpoint % SegmentSize);
+    auto view = _segment(segment);
+
+    // The rows' marks aren't stored in the records. They're merged back in from _marks.
+    auto mark = std::lower_bound(_marks.begin(), _marks.end(), beg, [](const SpilledMark& m, uint64_t row) { return m.row < row; });
+
+    for (auto row = beg - beg % CheckpointInterval; row < end; ++row)
+    {
+        RecordHeader header{};
+        if (SegmentSize - offset >= sizeof(header))
+        {
+            memcpy(&header, view + offset, sizeof(header));
+        }
+        if (header.size == 0)
+        {
+            segment++;
+            offset = 0;
+            view = _segment(segment);
+            memcpy(&header, view, sizeof(header));
+        }
+
+        if (row >= beg)
+        {
+            auto ptr = view + offset + sizeof(header);
+            auto& packed = rows.emplace_back();
+
+            packed.text.assign(reinterpret_cast<const char*>(ptr), header.textSize);
+            ptr += header.textSize;
+
+            packed.charOffsets.resize(header.charOffsetCount);
+            memcpy(packed.charOffsets.data(), ptr, header.charOffsetCount * sizeof(uint16_t));
+            ptr += header.charOffsetCount * sizeof(uint16_t);
+
+            packed.attr.resize(header.attrCount);
+            for (auto& run : packed.attr)
+            {
+                TextAttribute value;
+                memcpy(&value, ptr, sizeof(TextAttribute));
+                memcpy(&run.length, ptr + sizeof(TextAttribute), sizeof(uint16_t));
+                ptr += attrRunSize;
+
+                const auto id = palette.Intern(value);
+                // Only possible if the rows use more than 65536 distinct attributes.
+                THROW_HR_IF(E_NOT_SUFFICIENT_BUFFER, !id);
+                run.value = *id;
+            }
+
+            if (mark != _marks.end() && mark->row == row)
+            {
+                packed.promptData = mark->data;
+                ++mark;
+            }
+
+            packed.columns = header.columns;
+            packed.encoding = static_cast<PackedRow::Encoding>(header.encoding);
+            packed.lineRendition = static_cast<LineRendition>(header.lineRendition);
+            packed.wrapForced = WI_IsFlagSet(header.flags, FlagWrapForced);
+            packed.doubleBytePadded = WI_IsFlagSet(header.flags, FlagDoubleBytePadded);
+        }
+
+        offset += header.size;
+    }
+
+    return rows;
+}
+
+// Discards all rows and truncates the file.
+void SpillLog::Clear() noexcept
+{
+    _writeView.reset();
+    _readView.reset();
+    _mappings.clear();
+    _writeSegment = 0;
+    _writeOffset = 0;
+    _checkpoints.clear();
+    _marks.clear();
+    _rowCount = 0;
+    _maxColumns = 0;
+
+    LOG_IF_WIN32_BOOL_FALSE(SetFilePointerEx(_file.get(), {}, nullptr, FILE_BEGIN));
+    LOG_IF_WIN32_BOOL_FALSE(SetEndOfFile(_file.get()));
+}
+
+// Returns a pointer to the start of the given segment. Segments other than the one being
+// written to are mapped on demand and only the most recently read one stays mapped.
+std::byte* SpillLog::_segment(size_t index) const
+{
+    if (index == _writeSegment && _writeView)
+    {
+        return _writeView.get();
+    }
+
+    if (!_readView || _readSegment != index)
+    {
+        const auto offset = uint64_t{ index } * SegmentSize;
+        _readView.reset(static_cast<std::byte*>(MapViewOfFile(til::at(_mappings, index).get(), FILE_MAP_READ, gsl::narrow_cast<DWORD>(offset >> 32), gsl::narrow_cast<DWORD>(offset), SegmentSize)));
+        THROW_LAST_ERROR_IF(!_readView);
+        _readSegment = index;
+    }
+
+    return _readView.get();
+}
+
+// Finishes the current segment (if any) and maps the given one for writing.
+void SpillLog::_beginSegment(size_t index)
+{
+    const auto offset = uint64_t{ index } * SegmentSize;
+    const auto fileSize = offset + SegmentSize;
+
+    // Creating a mapping that's larger than the file grows the file. The new space reads as zeroes.
+    wil::unique_handle mapping{ CreateFileMappingW(_file.get(), nullptr, PAGE_READWRITE, gsl::narrow_cast<DWORD>(fileSize >> 32), gsl::narrow_cast<DWORD>(fileSize), nullptr) };
+    THROW_LAST_ERROR_IF(!mapping);
+
+    wil::unique_mapview_ptr<std::byte> view{ static_cast<std::byte*>(MapViewOfFile(mapping.get(), FILE_MAP_READ | FILE_MAP_WRITE, gsl::narrow_cast<DWORD>(offset >> 32), gsl::narrow_cast<DWORD>(offset), SegmentSize)) };
+    THROW_LAST_ERROR_IF(!view);
+
+    // Mark the end of the previous segment. Offsets are 8-byte aligned, so there's always enough space for the size field.
+    if (_writeView && _writeOffset < SegmentSize)
+    {
+        memset(_writeView.get() + _writeOffset, 0, sizeof(uint32_t));
+    }
+
+    _mappings.resize(index);
+    _mappings.emplace_back(std::move(mapping));
+    _writeView = std::move(view);
+    _writeSegment = index;
+    _writeOffset = 0;
+}
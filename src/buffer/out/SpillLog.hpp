@@ -0,0 +1,79 @@
+/*++
+Copyright (c) Microsoft Corporation
+Licensed under the MIT license.
+
+Module Name:
+- SpillLog.hpp
+
+Abstract:
+- An append-only log of PackedRows in a temporary, memory-mapped file.
+- TextBuffer uses it for unbounded scrollback: Rows evicted from the top of
+  the buffer are appended here instead of being discarded. See TextBuffer::EnableSpill().
+- The file is split into fixed-size segments, which are mapped on demand. Only the
+  segment being written to and the one last read from are mapped at any time. The
+  only per-row state kept in memory is a sparse index and the rows' scrollbar marks.
+--*/
+
+#pragma once
+
+#include "Row.hpp"
+
+struct SpilledMark
+{
+    uint64_t row = 0;
+    ScrollbarData data;
+};
+
+class SpillLog final
+{
+public:
+    // The file offset of every n-th row is stored in _checkpoints. Reading
+    // a row requires skipping over at most this many records minus 1.
+    static constexpr uint64_t CheckpointInterval = 256;
+
+    SpillLog();
+
+    uint64_t RowCount() const noexcept;
+    til::CoordType MaxColumns() const noexcept;
+    const std::vector<SpilledMark>& Marks() const noexcept;
+
+    void Append(const PackedRow& row, const AttributePalette& palette);
+    std::vector<PackedRow> Read(uint64_t beg, uint64_t end, AttributePalette& palette) const;
+    void Clear() noexcept;
+
+private:
+    struct RecordHeader
+    {
+        // The size of the record including this header, rounded up to a multiple of 8.
+        // A size of 0 marks the end of a segment. The next record is at the start of the next one.
+        uint32_t size;
+        uint32_t textSize;
+        uint16_t columns;
+        uint16_t charOffsetCount;
+        uint16_t attrCount;
+        uint8_t encoding;
+        uint8_t lineRendition;
+        uint8_t flags;
+    };
+
+    static constexpr uint8_t FlagWrapForced = 1 << 0;
+    static constexpr uint8_t FlagDoubleBytePadded = 1 << 1;
+
+    // Must be a multiple of the allocation granularity (64KiB), since segments are mapped individually.
+    static constexpr size_t SegmentSize = 64 * 1024 * 1024;
+    std::byte* _segment(size_t index) const;
+    void _beginSegment(size_t index);
+
+    wil::unique_hfile _file;
+    std::vector<wil::unique_handle> _mappings;
+    wil::unique_mapview_ptr<std::byte> _writeView;
+    mutable wil::unique_mapview_ptr<std::byte> _readView;
+    mutable size_t _readSegment = 0;
+    size_t _writeSegment = 0;
+    size_t _writeOffset = 0;
+
+    std::vector<uint64_t> _checkpoints;
+    std::vector<SpilledMark> _marks;
+    uint64_t _rowCount = 0;
+    til::CoordType _maxColumns = 0;
+};
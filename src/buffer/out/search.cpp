@@ -19,15 +19,205 @@ bool Search::IsStale(const Microsoft::Console::Render::IRenderData& renderData,
 void Search::Reset(Microsoft::Console::Render::IRenderData& renderData, const std::wstring_view& needle, SearchFlag flags, bool reverse)
 {
     const auto& textBuffer = renderData.GetTextBuffer();
+    const auto updateInPlace = _canUpdateInPlace(renderData, needle, flags);
+    const auto lastMutationId = _lastMutationId;
 
     _renderData = &renderData;
     _needle = needle;
     _flags = flags;
     _lastMutationId = textBuffer.GetLastMutationId();
+    _streaming = false;
+    _staleResults.clear();
 
-    auto result = textBuffer.SearchText(needle, _flags);
-    _ok = result.has_value();
-    _results = std::move(result).value_or(std::vector<til::point_span>{});
+    if (!updateInPlace || !_updateResults(textBuffer, lastMutationId))
+    {
+        auto result = textBuffer.SearchText(needle, _flags);
+        _ok = result.has_value();
+        _replaceResults(std::move(result).value_or(std::vector<til::point_span>{}));
+    }
+
+    _textBuffer = &textBuffer;
+    _bufferWidth = textBuffer.GetSize().Width();
+    _circularBufferRotations = textBuffer.GetCircularBufferRotations();
+    _rowTop = -textBuffer.GetSpilledRowCount();
+    _rowCount = textBuffer.EstimateOffsetOfLastCommittedRow() + 1;
+    _moveToInitialMatch(reverse);
+}
+
+// Like Reset(), but only searches the rows in the viewport before returning. The remaining rows are
+// searched outwards from the viewport by calling StreamNext() until it returns false. This allows the
+// caller to show the matches in the viewport without having to wait for the entire buffer to be searched.
+// Calling this function again for the same query while a search is still streaming continues that search.
+void Search::ResetStreaming(Microsoft::Console::Render::IRenderData& renderData, const std::wstring_view& needle, SearchFlag flags, bool reverse)
+{
+    if (_streaming && _isSameQuery(renderData, needle, flags))
+    {
+        return;
+    }
+
+    // Matches of regular expressions and of needles containing newlines may span across
+    // any number of lines and thus across the chunks we search. Those are searched at once.
+    const auto& textBuffer = renderData.GetTextBuffer();
+    if (_canUpdateInPlace(renderData, needle, flags) ||
+        WI_IsFlagSet(flags, SearchFlag::RegularExpression) ||
+        needle.find_first_of(L"\r\n") != std::wstring_view::npos)
+    {
+        Reset(renderData, needle, flags, reverse);
+        return;
+    }
+
+    _renderData = &renderData;
+    _needle = needle;
+    _flags = flags;
+    _lastMutationId = textBuffer.GetLastMutationId();
+    _textBuffer = &textBuffer;
+    _bufferWidth = textBuffer.GetSize().Width();
+    _circularBufferRotations = textBuffer.GetCircularBufferRotations();
+    _rowTop = -textBuffer.GetSpilledRowCount();
+    _ok = true;
+    _staleResults.clear();
+    _replaceResults({});
+
+    const auto rowCount = textBuffer.EstimateOffsetOfLastCommittedRow() + 1;
+    _rowCount = rowCount;
+
+    // Start with the logical lines that intersect with the viewport.
+    const auto viewport = renderData.GetViewport();
+    auto beg = std::clamp(viewport.Top(), _rowTop, rowCount);
+    auto end = std::clamp(viewport.BottomExclusive(), beg, rowCount);
+    beg = textBuffer.GetLogicalLineStart(beg);
+    end = std::min(rowCount, textBuffer.GetLogicalLineEnd(end - 1));
+
+    _streamAbove = beg;
+    _streamBelow = end;
+    _streamEnd = rowCount;
+    _streamDownwards = !reverse;
+    _streaming = beg > _rowTop || end < rowCount;
+
+    _streamRows(textBuffer, beg, end, false);
+    _moveToInitialMatch(reverse);
+}
+
+// Searches through up to `rowBudget` more rows of a streaming search (see ResetStreaming()), alternating
+// between the rows above and below the ones searched so far. The new matches are merged into Results()
+// and CurrentMatch() is adjusted so that it continues to refer to the same match.
+// Returns true if there are rows left to search.
+bool Search::StreamNext(til::CoordType rowBudget)
+{
+    if (!_streaming)
+    {
+        return false;
+    }
+
+    const auto& textBuffer = _renderData->GetTextBuffer();
+
+    // The buffer got swapped (e.g. alternate screen) or reflowed. Everything we know is outdated.
+    if (_textBuffer != &textBuffer || _bufferWidth != textBuffer.GetSize().Width())
+    {
+        const auto needle = std::move(_needle);
+        _streaming = false;
+        _ok = false;
+        ResetStreaming(*_renderData, needle, _flags, _step < 0);
+        return _streaming;
+    }
+
+    // Rows scrolled out of the buffer since the last call.
+    if (const auto rotations = textBuffer.GetCircularBufferRotations() - _circularBufferRotations)
+    {
+        const auto shift = gsl::narrow_cast<til::CoordType>(std::min<uint64_t>(rotations, til::CoordTypeMax));
+        _circularBufferRotations += rotations;
+        _rowTop = -textBuffer.GetSpilledRowCount();
+
+        const auto erased = gsl::narrow_cast<ptrdiff_t>(_shiftRows(shift));
+        _index = std::max<ptrdiff_t>(0, _index - erased);
+        _streamAbove = std::max(_rowTop, _streamAbove - shift);
+        _streamBelow = std::max(_rowTop, _streamBelow - shift);
+        _streamEnd = std::max(_rowTop, _streamEnd - shift);
+    }
+
+    rowBudget = std::max(1, rowBudget);
+
+    if (_streamBelow < _streamEnd && (_streamDownwards || _streamAbove <= _rowTop))
+    {
+        const auto beg = _streamBelow;
+        const auto end = std::min(_streamEnd, textBuffer.GetLogicalLineEnd(beg + std::min(rowBudget, _streamEnd - beg) - 1));
+        _streamBelow = end;
+        _streaming = _streamRows(textBuffer, beg, end, false);
+    }
+    else if (_streamAbove > _rowTop)
+    {
+        const auto end = _streamAbove;
+        const auto beg = textBuffer.GetLogicalLineStart(std::max(_rowTop, end - rowBudget));
+        _streamAbove = beg;
+        _streaming = _streamRows(textBuffer, beg, end, true);
+    }
+
+    _streamDownwards = !_streamDownwards;
+
+    if (_streaming && (_streamAbove > _rowTop || _streamBelow < _streamEnd))
+    {
+        return true;
+    }
+
+    _streaming = false;
+
+    // The buffer changed while we were searching through it. Now that the search is complete we can
+    // catch up on the changes since ResetStreaming() the same way Reset() would. Re-searching rows
+    // that were changed before we got to them is redundant, but harmless.
+    if (_ok && _lastMutationId != textBuffer.GetLastMutationId())
+    {
+        const auto lastMutationId = std::exchange(_lastMutationId, textBuffer.GetLastMutationId());
+        if (!_updateResults(textBuffer, lastMutationId))
+        {
+            auto result = textBuffer.SearchText(_needle, _flags);
+            _ok = result.has_value();
+            _replaceResults(std::move(result).value_or(std::vector<til::point_span>{}));
+        }
+        _rowCount = textBuffer.EstimateOffsetOfLastCommittedRow() + 1;
+    }
+
+    // If the viewport had no matches on one side of the initial _index, it may now point past either end.
+    const auto count = gsl::narrow_cast<ptrdiff_t>(_results.size());
+    if (count)
+    {
+        _index = (_index % count + count) % count;
+    }
+
+    return false;
+}
+
+bool Search::IsStreaming() const noexcept
+{
+    return _streaming;
+}
+
+// Searches the rows [beg,end) and merges the matches into _results.
+// The rows must be either above (`prepend`) or below all the rows that were searched so far.
+bool Search::_streamRows(const TextBuffer& textBuffer, til::CoordType beg, til::CoordType end, bool prepend)
+{
+    auto found = textBuffer.SearchText(_needle, _flags, beg, end);
+    if (!found)
+    {
+        _ok = false;
+        _replaceResults({});
+        return false;
+    }
+
+    if (prepend)
+    {
+        _results.insert(_results.begin(), found->begin(), found->end());
+        _index += gsl::narrow_cast<ptrdiff_t>(found->size());
+    }
+    else
+    {
+        _results.insert(_results.end(), found->begin(), found->end());
+    }
+
+    return true;
+}
+
+void Search::_moveToInitialMatch(bool reverse) noexcept
+{
     _index = reverse ? gsl::narrow_cast<ptrdiff_t>(_results.size()) - 1 : 0;
     _step = reverse ? -1 : 1;
 
@@ -41,6 +231,158 @@ void Search::Reset(Microsoft::Console::Render::IRenderData& renderData, const st
     }
 }
 
+bool Search::_isSameQuery(const Microsoft::Console::Render::IRenderData& renderData, const std::wstring_view& needle, SearchFlag flags) const noexcept
+{
+    const auto& textBuffer = renderData.GetTextBuffer();
+    return _renderData == &renderData &&
+           _textBuffer == &textBuffer &&
+           _bufferWidth == textBuffer.GetSize().Width() &&
+           _needle == needle &&
+           _flags == flags;
+}
+
+// Returns true if the previous results are for the same query on the same buffer and can be updated
+// incrementally. Regular expressions aren't eligible, because their matches may span across lines.
+bool Search::_canUpdateInPlace(const Microsoft::Console::Render::IRenderData& renderData, const std::wstring_view& needle, SearchFlag flags) const noexcept
+{
+    return _ok &&
+           !_streaming &&
+           _isSameQuery(renderData, needle, flags) &&
+           WI_IsFlagClear(flags, SearchFlag::RegularExpression);
+}
+
+// Re-searches only the logical lines whose rows changed since `sinceMutationId` and splices the new
+// matches into _results. The replaced ones are moved to _staleResults. Returns false if a full search is needed instead.
+bool Search::_updateResults(const TextBuffer& textBuffer, const uint64_t sinceMutationId)
+{
+    const auto rotations = textBuffer.GetCircularBufferRotations() - _circularBufferRotations;
+    if (rotations && rotations >= gsl::narrow_cast<uint64_t>(_rowCount))
+    {
+        return false;
+    }
+
+    std::vector<til::CoordType> dirtyRows;
+    if (!textBuffer.GetMutatedRowsSince(sinceMutationId, dirtyRows))
+    {
+        return false;
+    }
+
+    // The rows scrolled out of the buffer. Shift everything else up accordingly.
+    if (rotations)
+    {
+        _rowTop = -textBuffer.GetSpilledRowCount();
+        _shiftRows(gsl::narrow_cast<til::CoordType>(rotations));
+        // The top row after a rotation may have lost the beginning of its logical line,
+        // which changes where the (non-overlapping) literal matches are found.
+        dirtyRows.emplace_back(0);
+    }
+
+    std::ranges::sort(dirtyRows);
+
+    const auto rowCount = textBuffer.EstimateOffsetOfLastCommittedRow() + 1;
+    const auto oldRowCount = _rowCount;
+    std::vector<std::pair<til::CoordType, til::CoordType>> ranges;
+    const auto addRange = [&](til::CoordType beg, til::CoordType end) {
+        if (!ranges.empty() && beg <= ranges.back().second)
+        {
+            ranges.back().second = std::max(ranges.back().second, end);
+        }
+        else
+        {
+            ranges.emplace_back(beg, end);
+        }
+    };
+
+    for (const auto y : dirtyRows)
+    {
+        if (y >= std::min(rowCount, oldRowCount))
+        {
+            break;
+        }
+        // Expand the dirty row to its logical line. Changes to the wrap flag of a row
+        // also affect the line of the next row, so we include that one as well.
+        if (ranges.empty() || y + 1 >= ranges.back().second)
+        {
+            const auto beg = textBuffer.GetLogicalLineStart(y);
+            const auto end = std::min(rowCount, textBuffer.GetLogicalLineEnd(std::min(y + 1, rowCount - 1)));
+            addRange(beg, end);
+        }
+    }
+
+    // Rows that got committed since the last search haven't been searched yet.
+    if (rowCount > oldRowCount)
+    {
+        addRange(textBuffer.GetLogicalLineStart(oldRowCount), rowCount);
+    }
+    // Rows past the end of the committed range were cleared (e.g. by ClearScrollback()).
+    if (oldRowCount > rowCount)
+    {
+        addRange(rowCount, oldRowCount);
+    }
+
+    if (ranges.empty())
+    {
+        return true;
+    }
+
+    std::vector<til::point_span> results;
+    results.reserve(_results.size());
+    auto it = _results.begin();
+    const auto end = _results.end();
+
+    for (const auto& [beg, rangeEnd] : ranges)
+    {
+        for (; it != end && it->start.y < beg; ++it)
+        {
+            results.emplace_back(*it);
+        }
+        for (; it != end && it->start.y < rangeEnd; ++it)
+        {
+            _staleResults.emplace_back(*it);
+        }
+
+        auto found = textBuffer.SearchText(_needle, _flags, beg, rangeEnd);
+        if (!found)
+        {
+            return false;
+        }
+        results.insert(results.end(), found->begin(), found->end());
+    }
+
+    results.insert(results.end(), it, end);
+    _results = std::move(results);
+    return true;
+}
+
+// Replaces _results and moves the previous ones to _staleResults.
+void Search::_replaceResults(std::vector<til::point_span>&& results)
+{
+    if (_staleResults.empty())
+    {
+        _staleResults = std::move(_results);
+    }
+    else
+    {
+        _staleResults.insert(_staleResults.end(), _results.begin(), _results.end());
+    }
+    _results = std::move(results);
+}
+
+// Moves the results up by `shift` rows and removes the ones that moved above _rowTop.
+// Returns the number of results that were removed.
+size_t Search::_shiftRows(til::CoordType shift)
+{
+    _rowCount = std::max(0, _rowCount - shift);
+
+    const auto erased = std::erase_if(_results, [&](const til::point_span& s) { return s.start.y - shift < _rowTop; });
+    for (auto& s : _results)
+    {
+        s.start.y -= shift;
+        s.end.y -= shift;
+    }
+    return erased;
+}
+
 void Search::MoveToPoint(const til::point anchor) noexcept
 {
     if (_results.empty())
@@ -137,9 +479,11 @@ const std::vector<til::point_span>& Search::Results() const noexcept
     return _results;
 }
 
-std::vector<til::point_span>&& Search::ExtractResults() noexcept
+// Returns the matches that the last Reset(), ResetStreaming() or StreamNext() removed from Results(),
+// so that the caller can invalidate their highlights. Matches that were merely found again may be included.
+std::vector<til::point_span> Search::TakeStaleResults() noexcept
 {
-    return std::move(_results);
+    return std::exchange(_staleResults, {});
 }
 
 ptrdiff_t Search::CurrentMatch() const noexcept
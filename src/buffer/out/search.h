@@ -37,6 +37,9 @@ public:
 
     bool IsStale(const Microsoft::Console::Render::IRenderData& renderData, const std::wstring_view& needle, SearchFlag flags) const noexcept;
     void Reset(Microsoft::Console::Render::IRenderData& renderData, const std::wstring_view& needle, SearchFlag flags, bool reverse);
+    void ResetStreaming(Microsoft::Console::Render::IRenderData& renderData, const std::wstring_view& needle, SearchFlag flags, bool reverse);
+    bool StreamNext(til::CoordType rowBudget);
+    bool IsStreaming() const noexcept;
 
     void MoveToPoint(til::point anchor) noexcept;
     void MovePastPoint(til::point anchor) noexcept;
@@ -46,19 +49,47 @@ public:
     bool SelectCurrent() const;
 
     const std::vector<til::point_span>& Results() const noexcept;
-    std::vector<til::point_span>&& ExtractResults() noexcept;
+    std::vector<til::point_span> TakeStaleResults() noexcept;
     ptrdiff_t CurrentMatch() const noexcept;
     bool IsOk() const noexcept;
 
 private:
+    bool _isSameQuery(const Microsoft::Console::Render::IRenderData& renderData, const std::wstring_view& needle, SearchFlag flags) const noexcept;
+    bool _canUpdateInPlace(const Microsoft::Console::Render::IRenderData& renderData, const std::wstring_view& needle, SearchFlag flags) const noexcept;
+    bool _updateResults(const TextBuffer& textBuffer, uint64_t sinceMutationId);
+    void _replaceResults(std::vector<til::point_span>&& results);
+    size_t _shiftRows(til::CoordType shift);
+    void _moveToInitialMatch(bool reverse) noexcept;
+    bool _streamRows(const TextBuffer& textBuffer, til::CoordType beg, til::CoordType end, bool prepend);
+
     // _renderData is a pointer so that Search() is constexpr default constructable.
     Microsoft::Console::Render::IRenderData* _renderData = nullptr;
     std::wstring _needle;
     SearchFlag _flags{};
     uint64_t _lastMutationId = 0;
 
+    // These allow Reset() to update _results in place, by only searching through the logical lines that
+    // changed since the last call, according to TextBuffer::GetMutatedRowsSince(). _rowCount is the number
+    // of committed rows that were searched, so that rows that got committed since then are searched as well.
+    const TextBuffer* _textBuffer = nullptr;
+    til::CoordType _bufferWidth = 0;
+    uint64_t _circularBufferRotations = 0;
+    til::CoordType _rowCount = 0;
+    // The first row that can be searched. It's negative if the buffer spills rows to disk. See TextBuffer::EnableSpill().
+    til::CoordType _rowTop = 0;
+
+    // A streaming search (see ResetStreaming()) has searched the rows [_streamAbove,_streamBelow) so far.
+    // The rows [_rowTop,_streamAbove) and [_streamBelow,_streamEnd) are still pending.
+    til::CoordType _streamAbove = 0;
+    til::CoordType _streamBelow = 0;
+    til::CoordType _streamEnd = 0;
+    bool _streamDownwards = true;
+    bool _streaming = false;
+
     bool _ok{ false };
     std::vector<til::point_span> _results;
+    // The matches that were removed from _results by the last update. See TakeStaleResults().
+    std::vector<til::point_span> _staleResults;
     ptrdiff_t _index = 0;
     ptrdiff_t _step = 0;
 };
@@ -6,6 +6,8 @@
 
 #include <til/hash.h>
 
+#include "LiteralSearcher.hpp"
+#include "SpillLog.hpp"
 #include "UTextAdapter.h"
 #include "../../types/inc/CodepointWidthDetector.hpp"
 #include "../renderer/base/renderer.hpp"
@@ -56,6 +58,7 @@ TextBuffer::TextBuffer(til::size screenBufferSize,
     // This way every TextBuffer will start with a ""unique"" _lastMutationId
     // and so it'll compare unequal with the counter of other TextBuffers.
     _lastMutationId{ s_lastMutationIdInitialValue.fetch_add(0x100000000) },
+    _mutationJournalFloor{ _lastMutationId },
     _cursor{ cursorSize, *this },
     _isActiveBuffer{ isActiveBuffer }
 {
@@ -118,6 +121,9 @@ void TextBuffer::_reserve(til::size screenBufferSize, const TextAttribute& defau
     _bufferOffsetCharOffsets = rowSize + charsBufferSize;
     _width = w;
     _height = h;
+    _wrapForced.assign((rowCount + 63) / 64, 0);
+    _hasMark.assign((rowCount + 63) / 64, 0);
+    _rowFlagsDirty.assign((rowCount + 63) / 64, 0);
 }
 
 // MEM_COMMITs the memory and constructs all ROWs up to and including the given row pointer.
@@ -148,6 +154,78 @@ void TextBuffer::_decommit() noexcept
     _destroy();
     VirtualFree(_buffer.get(), 0, MEM_DECOMMIT);
     _commitWatermark = _buffer.get();
+    _packedChunks.clear();
+    _packedChunkCount = 0;
+    _dropDecodedRows();
+    _attributePalette.Clear();
+    _attributePaletteCompactSize = _attributePaletteMinGrowth;
+    std::fill(_wrapForced.begin(), _wrapForced.end(), 0);
+    std::fill(_hasMark.begin(), _hasMark.end(), 0);
+    std::fill(_rowFlagsDirty.begin(), _rowFlagsDirty.end(), 0);
+    _invalidateMutationJournal();
+}
+
+// Like _decommit(), but only for the ROWs from row y to the end of the _buffer arena, which are expected to be unused.
+// ContinueReflow() uses this to release the rows of a source buffer as soon as they've been consumed.
+// This is rounded up to the next chunk of _packChunkRowCount rows, so that no packed chunk is split in half.
+// If the rows wrap around the end of the arena, they're kept until the buffer is destroyed.
+void TextBuffer::_decommitFrom(til::CoordType y) noexcept
+{
+    if (y < 0 || _firstRow + y >= _height)
+    {
+        return;
+    }
+
+    const auto chunk = (gsl::narrow_cast<size_t>(_firstRow + y) + _packChunkRowCount - 1) / _packChunkRowCount;
+    const auto first = chunk * _packChunkRowCount + 1;
+    const auto beg = _buffer.get() + _bufferRowStride * first;
+    if (beg >= _commitWatermark)
+    {
+        return;
+    }
+
+    auto offset = first;
+    for (auto it = beg; it < _commitWatermark; it += _bufferRowStride, ++offset)
+    {
+        if (!_isPackedOffset(offset))
+        {
+            std::destroy_at(reinterpret_cast<ROW*>(it));
+        }
+    }
+
+    for (auto i = chunk; i < _packedChunks.size(); ++i)
+    {
+        if (!til::at(_packedChunks, i).empty())
+        {
+            til::at(_packedChunks, i) = {};
+            _packedChunkCount--;
+        }
+    }
+
+    // The first page is usually shared with the rows that are still in use.
+    const auto pageBeg = (reinterpret_cast<uintptr_t>(beg) + _pageSize - 1) & ~(_pageSize - 1);
+    const auto pageEnd = reinterpret_cast<uintptr_t>(_commitWatermark);
+    if (pageEnd > pageBeg)
+    {
+        VirtualFree(reinterpret_cast<void*>(pageBeg), pageEnd - pageBeg, MEM_DECOMMIT);
+    }
+
+    _commitWatermark = beg;
+    _dropDecodedRows();
+    // _packChunkRowCount is a multiple of 64, so the bits of the released rows start at a word boundary.
+    static_assert(_packChunkRowCount % 64 == 0);
+    const auto word = gsl::narrow_cast<ptrdiff_t>(first - 1) / 64;
+    std::fill(_wrapForced.begin() + word, _wrapForced.end(), 0);
+    std::fill(_hasMark.begin() + word, _hasMark.end(), 0);
+    std::fill(_rowFlagsDirty.begin() + word, _rowFlagsDirty.end(), 0);
+}
+
+// Forgets all rows recorded in _mutationJournal. This needs to be called whenever rows move around
+// without going through GetMutableRowByOffset() and IncrementCircularBuffer(), like when _firstRow changes.
+void TextBuffer::_invalidateMutationJournal() noexcept
+{
+    _mutationJournal.clear();
+    _mutationJournalFloor = ++_lastMutationId;
 }
 
 // Constructs ROWs between [_commitWatermark,until).
@@ -159,15 +237,20 @@ void TextBuffer::_construct(const std::byte* until) noexcept
         const auto chars = reinterpret_cast<wchar_t*>(_commitWatermark + _bufferOffsetChars);
         const auto indices = reinterpret_cast<uint16_t*>(_commitWatermark + _bufferOffsetCharOffsets);
         std::construct_at(row, chars, indices, _width, _initialAttributes);
+        _trackRowFlags(*row, gsl::narrow_cast<size_t>(_commitWatermark - _buffer.get()) / _bufferRowStride);
     }
 }
 
-// Destructs ROWs between [_buffer,_commitWatermark).
+// Destructs ROWs between [_buffer,_commitWatermark), except for those that are packed and thus already destroyed.
 void TextBuffer::_destroy() const noexcept
 {
-    for (auto it = _buffer.get(); it < _commitWatermark; it += _bufferRowStride)
+    size_t offset = 0;
+    for (auto it = _buffer.get(); it < _commitWatermark; it += _bufferRowStride, ++offset)
     {
-        std::destroy_at(reinterpret_cast<ROW*>(it));
+        if (!_isPackedOffset(offset))
+        {
+            std::destroy_at(reinterpret_cast<ROW*>(it));
+        }
     }
 }
 
@@ -187,7 +270,105 @@ ROW& TextBuffer::_getRowByOffsetDirect(size_t offset)
 }
 
 // See GetRowByOffset().
-ROW& TextBuffer::_getRow(til::CoordType y) const
+const ROW& TextBuffer::_getRow(til::CoordType y) const
+{
+    const auto offset = _rowOffset(y);
+
+    // Packed rows are left alone. Readers get a decoded copy instead.
+    if (_isPackedOffset(offset))
+    {
+        return _getDecodedRow(offset);
+    }
+
+#pragma warning(suppress : 26492) // Don't use const_cast to cast away const or volatile (type.3).
+    return const_cast<TextBuffer*>(this)->_getRowByOffsetDirect(offset);
+}
+
+// Like _getRow(), but for writing. Packed rows are unpacked in place, at the same address they had before.
+ROW& TextBuffer::_getMutableRowAtOffset(size_t offset)
+{
+    if (_isPackedOffset(offset))
+    {
+        _unpackChunk((offset - 1) / _packChunkRowCount);
+    }
+    return _getRowByOffsetDirect(offset);
+}
+
+// Returns a copy of the packed ROW at the given offset, decoded into _decodedRows.
+// The copy is kept until the next call to PackColdRows(), so that the returned reference stays valid like any other.
+// _decodedRowsLock makes this safe to call concurrently, like from the workers in _searchTextParallel().
+const ROW& TextBuffer::_getDecodedRow(size_t offset) const
+{
+    const std::scoped_lock guard{ _decodedRowsLock };
+
+    auto& decoded = _decodedRows[offset];
+    if (!decoded)
+    {
+        const auto& packed = til::at(_packedChunks, (offset - 1) / _packChunkRowCount);
+        decoded = std::make_unique<DecodedRow>(til::at(packed, (offset - 1) % _packChunkRowCount), _attributePalette, _width, _initialAttributes);
+    }
+
+    return decoded->row;
+}
+
+// Like _getDecodedRow(), but for the spilled row y, which is negative. See EnableSpill().
+// Reading a row from the _spill costs about as much as reading all rows up to the next checkpoint,
+// which is why this decodes all of them at once. The renderer will ask for the neighboring rows next.
+const ROW& TextBuffer::_getSpilledRow(til::CoordType y) const
+{
+    THROW_HR_IF(E_BOUNDS, y < -GetSpilledRowCount());
+
+    const std::scoped_lock guard{ _decodedRowsLock };
+
+    const auto total = _spill->RowCount();
+    const auto index = total - gsl::narrow_cast<uint64_t>(-y);
+
+    if (const auto it = _decodedSpilledRows.find(index); it != _decodedSpilledRows.end())
+    {
+        return it->second->row;
+    }
+
+    const auto beg = index - index % SpillLog::CheckpointInterval;
+    const auto end = std::min(beg + SpillLog::CheckpointInterval, total);
+    AttributePalette palette;
+    const auto rows = _spill->Read(beg, end, palette);
+
+    auto i = beg;
+    for (const auto& packed : rows)
+    {
+        auto& decoded = _decodedSpilledRows[i++];
+        if (!decoded)
+        {
+            // Spilled rows may predate a resize and be wider than the buffer is now.
+            uint16_t columns = 0;
+            for (const auto& run : packed.attr)
+            {
+                columns += run.length;
+            }
+            decoded = std::make_unique<DecodedRow>(packed, palette, std::max(_width, columns), _initialAttributes);
+        }
+    }
+
+    return _decodedSpilledRows.at(index)->row;
+}
+
+TextBuffer::DecodedRow::DecodedRow(const PackedRow& packed, const AttributePalette& palette, uint16_t width, const TextAttribute& fillAttribute) :
+    chars{ std::make_unique<wchar_t[]>(ROW::CalculateCharsBufferSize(width) / sizeof(wchar_t)) },
+    charOffsets{ std::make_unique<uint16_t[]>(ROW::CalculateCharOffsetsBufferSize(width) / sizeof(uint16_t)) },
+    row{ chars.get(), charOffsets.get(), width, fillAttribute }
+{
+    row.Unpack(packed, palette);
+}
+
+// Frees the rows returned by _getDecodedRow() and _getSpilledRow(). This invalidates any references to them.
+void TextBuffer::_dropDecodedRows() noexcept
+{
+    _decodedRows.clear();
+    _decodedSpilledRows.clear();
+}
+
+// Returns the offset of the given row in the _buffer arena, for use with _getRowByOffsetDirect().
+size_t TextBuffer::_rowOffset(til::CoordType y) const noexcept
 {
     // Rows are stored circularly, so the index you ask for is offset by the start position and mod the total of rows.
     auto offset = (_firstRow + y) % _height;
@@ -201,8 +382,254 @@ ROW& TextBuffer::_getRow(til::CoordType y) const
 
     // We add 1 to the row offset, because row "0" is the one returned by GetScratchpadRow().
     // See GetScratchpadRow() for more explanation.
-#pragma warning(suppress : 26492) // Don't use const_cast to cast away const or volatile (type.3).
-    return const_cast<TextBuffer*>(this)->_getRowByOffsetDirect(gsl::narrow_cast<size_t>(offset) + 1);
+    return gsl::narrow_cast<size_t>(offset) + 1;
+}
+
+// Returns true if the ROW at the given _buffer offset is currently packed (see PackColdRows()).
+bool TextBuffer::_isPackedOffset(size_t offset) const noexcept
+{
+    if (_packedChunkCount == 0 || offset == 0)
+    {
+        return false;
+    }
+    const auto chunk = (offset - 1) / _packChunkRowCount;
+    return chunk < _packedChunks.size() && !til::at(_packedChunks, chunk).empty();
+}
+
+// Returns the packed representation of the given row, or nullptr if it isn't packed.
+// This allows you to inspect rows without decoding them, like _PruneHyperlinks() does.
+const PackedRow* TextBuffer::_getPackedRow(til::CoordType y) const noexcept
+{
+    // Negative rows refer to the spilled scrollback. See EnableSpill().
+    if (y < 0 && _spill)
+    {
+        return nullptr;
+    }
+
+    const auto offset = _rowOffset(y);
+    if (!_isPackedOffset(offset))
+    {
+        return nullptr;
+    }
+    const auto& packed = til::at(_packedChunks, (offset - 1) / _packChunkRowCount);
+    return &til::at(packed, (offset - 1) % _packChunkRowCount);
+}
+
+// Lets the ROW at the given offset mark itself in _rowFlagsDirty whenever its wrap flag or scrollbar data changes.
+void TextBuffer::_trackRowFlags(ROW& row, size_t offset) noexcept
+{
+    // The scratchpad row at offset 0 isn't covered by _wrapForced and _hasMark.
+    if (offset != 0)
+    {
+        row.SetFlagsDirtyBit(&til::at(_rowFlagsDirty, (offset - 1) / 64), uint64_t{ 1 } << ((offset - 1) % 64));
+    }
+}
+
+// Reads the flags of the rows in the given word of _wrapForced/_hasMark back from the ROWs,
+// if they marked themselves as dirty. See _trackRowFlags(). The word covers the ROWs at the offsets [word*64+1,word*64+65).
+void TextBuffer::_refreshRowFlags(size_t word) const
+{
+    auto& dirty = til::at(_rowFlagsDirty, word);
+    if (!dirty)
+    {
+        return;
+    }
+
+    auto& wrapBits = til::at(_wrapForced, word);
+    auto& markBits = til::at(_hasMark, word);
+
+    for (; dirty; dirty &= dirty - 1)
+    {
+        unsigned long bit;
+        _BitScanForward64(&bit, dirty);
+
+        const auto offset = word * 64 + bit + 1;
+        const auto row = _buffer.get() + _bufferRowStride * offset;
+        auto wrap = false;
+        auto mark = false;
+
+        // Don't use _getRow() here, as that would decode the row.
+        if (_isPackedOffset(offset))
+        {
+            const auto& packed = til::at(til::at(_packedChunks, (offset - 1) / _packChunkRowCount), (offset - 1) % _packChunkRowCount);
+            wrap = packed.wrapForced;
+            mark = packed.promptData.has_value();
+        }
+        else if (row < _commitWatermark)
+        {
+            const auto r = reinterpret_cast<const ROW*>(row);
+            wrap = r->WasWrapForced();
+            mark = r->GetScrollbarData().has_value();
+        }
+
+        const auto mask = uint64_t{ 1 } << bit;
+        wrapBits = wrap ? wrapBits | mask : wrapBits & ~mask;
+        markBits = mark ? markBits | mask : markBits & ~mask;
+    }
+}
+
+// Returns the wrap flags of the 64 ROWs at the offsets [word*64+1,word*64+65) as a bitmask.
+uint64_t TextBuffer::_getWrapWord(size_t word) const
+{
+    _refreshRowFlags(word);
+    return til::at(_wrapForced, word);
+}
+
+// Returns whether the 64 ROWs at the offsets [word*64+1,word*64+65) have scrollbar data, as a bitmask.
+uint64_t TextBuffer::_getMarkWord(size_t word) const
+{
+    _refreshRowFlags(word);
+    return til::at(_hasMark, word);
+}
+
+// Returns the first row in [y,end) that has scrollbar data (a mark) or `end` if there's none.
+// Like GetLogicalLineEnd() this scans 64 rows at a time.
+til::CoordType TextBuffer::_findNextMarkRow(til::CoordType y, til::CoordType end) const
+{
+    y = std::max(0, y);
+    end = std::min<til::CoordType>(end, _height);
+    auto bit = _rowOffset(y) - 1;
+
+    while (y < end)
+    {
+        const auto pos = gsl::narrow_cast<til::CoordType>(bit % 64);
+        const auto avail = std::min({ 64 - pos, end - y, _height - gsl::narrow_cast<til::CoordType>(bit) });
+        auto word = _getMarkWord(bit / 64) >> pos;
+        if (avail < 64)
+        {
+            word &= (uint64_t{ 1 } << avail) - 1;
+        }
+
+        unsigned long index;
+        if (_BitScanForward64(&index, word))
+        {
+            return y + gsl::narrow_cast<til::CoordType>(index);
+        }
+
+        y += avail;
+        bit += avail;
+        if (bit == _height)
+        {
+            bit = 0;
+        }
+    }
+
+    return end;
+}
+
+// Returns the last row in [0,y] that has scrollbar data (a mark) or -1 if there's none.
+// Like GetLogicalLineStart() this scans 64 rows at a time.
+til::CoordType TextBuffer::_findPrevMarkRow(til::CoordType y) const
+{
+    y = std::min<til::CoordType>(y, _height - 1);
+    auto bit = _rowOffset(y) - 1;
+
+    while (y >= 0)
+    {
+        const auto pos = gsl::narrow_cast<til::CoordType>(bit % 64);
+        const auto avail = std::min(pos + 1, y + 1);
+        // Move the bit of row y to the top and discard the ones of the rows below y-avail+1.
+        auto word = _getMarkWord(bit / 64) << (63 - pos);
+        if (avail < 64)
+        {
+            word &= ~((uint64_t{ 1 } << (64 - avail)) - 1);
+        }
+
+        unsigned long index;
+        if (_BitScanReverse64(&index, word))
+        {
+            return y - (63 - gsl::narrow_cast<til::CoordType>(index));
+        }
+
+        y -= avail;
+        bit = bit >= gsl::narrow_cast<size_t>(avail) ? bit - avail : size_t{ _height } - 1;
+    }
+
+    return -1;
+}
+
+// Packs the ROWs in the given chunk, destroys them and MEM_DECOMMITs the memory they occupied.
+// Returns false if the chunk can't be packed, because not all of its rows are committed or packable.
+bool TextBuffer::_packChunk(size_t chunk)
+{
+    const auto first = chunk * _packChunkRowCount + 1;
+    const auto last = std::min(first + _packChunkRowCount, size_t{ _height } + 1);
+    const auto beg = _buffer.get() + _bufferRowStride * first;
+    const auto end = _buffer.get() + _bufferRowStride * last;
+
+    if (end > _commitWatermark)
+    {
+        return false;
+    }
+
+    // Pack all rows before modifying anything, so that we remain consistent if this throws.
+    std::vector<PackedRow> packed;
+    packed.reserve(last - first);
+    for (auto it = beg; it < end; it += _bufferRowStride)
+    {
+        const auto& row = *reinterpret_cast<const ROW*>(it);
+        if (!row.IsPackable())
+        {
+            return false;
+        }
+        auto p = row.Pack(_attributePalette);
+        if (!p)
+        {
+            return false;
+        }
+        packed.emplace_back(std::move(*p));
+    }
+
+    for (auto it = beg; it < end; it += _bufferRowStride)
+    {
+        std::destroy_at(reinterpret_cast<ROW*>(it));
+    }
+
+    // The first and last page of the chunk are usually shared with the neighboring chunks. Those need to stay committed.
+    const auto pageBeg = (reinterpret_cast<uintptr_t>(beg) + _pageSize - 1) & ~(_pageSize - 1);
+    const auto pageEnd = reinterpret_cast<uintptr_t>(end) & ~(_pageSize - 1);
+    if (pageEnd > pageBeg)
+    {
+        VirtualFree(reinterpret_cast<void*>(pageBeg), pageEnd - pageBeg, MEM_DECOMMIT);
+    }
+
+    til::at(_packedChunks, chunk) = std::move(packed);
+    _packedChunkCount++;
+    return true;
+}
+
+// The counterpart to _packChunk(). It MEM_COMMITs the chunk's memory again and
+// reconstructs the ROWs in place, at the same address they had before.
+void TextBuffer::_unpackChunk(size_t chunk)
+{
+    const auto first = chunk * _packChunkRowCount + 1;
+    const auto last = std::min(first + _packChunkRowCount, size_t{ _height } + 1);
+    const auto beg = _buffer.get() + _bufferRowStride * first;
+    const auto end = _buffer.get() + _bufferRowStride * last;
+
+    THROW_LAST_ERROR_IF_NULL(VirtualAlloc(beg, end - beg, MEM_COMMIT, PAGE_READWRITE));
+
+    // Once the ROWs are constructed the chunk is consistent again, even if one of the Unpack() calls below throws.
+    auto offset = first;
+    for (auto it = beg; it < end; it += _bufferRowStride, ++offset)
+    {
+        const auto row = reinterpret_cast<ROW*>(it);
+        const auto chars = reinterpret_cast<wchar_t*>(it + _bufferOffsetChars);
+        const auto indices = reinterpret_cast<uint16_t*>(it + _bufferOffsetCharOffsets);
+        std::construct_at(row, chars, indices, _width, _initialAttributes);
+        _trackRowFlags(*row, offset);
+    }
+
+    const auto packed = std::move(til::at(_packedChunks, chunk));
+    til::at(_packedChunks, chunk) = {};
+    _packedChunkCount--;
+
+    auto it = beg;
+    for (const auto& p : packed)
+    {
+        reinterpret_cast<ROW*>(it)->Unpack(p, _attributePalette);
+        it += _bufferRowStride;
+    }
 }
 
 // Returns the "user-visible" index of the last committed row, which can be used
@@ -220,8 +647,13 @@ til::CoordType TextBuffer::_estimateOffsetOfLastCommittedRow() const noexcept
 
 // Retrieves a row from the buffer by its offset from the first row of the text buffer
 // (what corresponds to the top row of the screen buffer).
+// Negative offsets refer to the spilled scrollback, if it's enabled. See EnableSpill().
 const ROW& TextBuffer::GetRowByOffset(const til::CoordType index) const
 {
+    if (index < 0 && _spill)
+    {
+        return _getSpilledRow(index);
+    }
     return _getRow(index);
 }
 
@@ -230,7 +662,25 @@ const ROW& TextBuffer::GetRowByOffset(const til::CoordType index) const
 ROW& TextBuffer::GetMutableRowByOffset(const til::CoordType index)
 {
     _lastMutationId++;
-    return _getRow(index);
+
+    // Consecutive writes usually hit the same row, so that's all we need to check for duplicates.
+    const auto row = _circularBufferRotations + gsl::narrow_cast<uint64_t>(index);
+    if (!_mutationJournal.empty() && _mutationJournal.back().row == row)
+    {
+        _mutationJournal.back().mutationId = _lastMutationId;
+    }
+    else
+    {
+        if (_mutationJournal.size() >= _mutationJournalCapacity)
+        {
+            const auto half = _mutationJournal.begin() + _mutationJournalCapacity / 2;
+            _mutationJournalFloor = (half - 1)->mutationId;
+            _mutationJournal.erase(_mutationJournal.begin(), half);
+        }
+        _mutationJournal.emplace_back(MutationJournalEntry{ _lastMutationId, row });
+    }
+
+    return _getMutableRowAtOffset(_rowOffset(index));
 }
 
 // Returns a row filled with whitespace and the current attributes, for you to freely use.
@@ -530,7 +980,7 @@ void TextBuffer::Replace(til::CoordType row, const TextAttribute& attributes, Ro
     r.ReplaceText(state);
     r.ReplaceAttributes(state.columnBegin, state.columnEnd, attributes);
     ImageSlice::EraseCells(r, state.columnBegin, state.columnEnd);
-    TriggerRedraw(Viewport::FromExclusive({ state.columnBeginDirty, row, state.columnEndDirty, row + 1 }));
+    _damageRow(row, state.columnBeginDirty, state.columnEndDirty);
 }
 
 void TextBuffer::Insert(til::CoordType row, const TextAttribute& attributes, RowWriteState& state)
@@ -564,7 +1014,7 @@ void TextBuffer::Insert(til::CoordType row, const TextAttribute& attributes, Row
     // Image content at the insert position needs to be erased.
     ImageSlice::EraseCells(r, state.columnBegin, restoreState.columnBegin);
 
-    TriggerRedraw(Viewport::FromExclusive({ state.columnBeginDirty, row, restoreState.columnEndDirty, row + 1 }));
+    _damageRow(row, state.columnBeginDirty, restoreState.columnEndDirty);
 }
 
 // Fills an area of the buffer with a given fill character(s) and attributes.
@@ -618,7 +1068,7 @@ void TextBuffer::FillRect(const til::rect& rect, const std::wstring_view& fill,
             r.CopyTextFrom(state);
             r.ReplaceAttributes(rect.left, rect.right, attributes);
             ImageSlice::EraseCells(r, rect.left, rect.right);
-            TriggerRedraw(Viewport::FromExclusive({ state.columnBeginDirty, y, state.columnEndDirty, y + 1 }));
+            _damageRow(y, state.columnBeginDirty, state.columnEndDirty);
         }
     }
 }
@@ -701,8 +1151,7 @@ OutputCellIterator TextBuffer::WriteLine(const OutputCellIterator givenIt,
 
     // Take the cell distance written and notify that it needs to be repainted.
     const auto written = newIt.GetCellDistance(givenIt);
-    const auto paint = Viewport::FromDimensions(target, { written, 1 });
-    TriggerRedraw(paint);
+    _damageRow(target.y, target.x, target.x + written);
 
     return newIt;
 }
@@ -715,6 +1164,27 @@ OutputCellIterator TextBuffer::WriteLine(const OutputCellIterator givenIt,
 // - true if we successfully incremented the buffer.
 void TextBuffer::IncrementCircularBuffer(const TextAttribute& fillAttributes)
 {
+    if (_spill)
+    {
+        if (const auto packed = _getPackedRow(0))
+        {
+            _spill->Append(*packed, _attributePalette);
+        }
+        else
+        {
+            // A palette for a single row can't run out of IDs, since a row has less than 65536 attribute runs.
+            _spillPalette.Clear();
+            _spill->Append(*GetRowByOffset(0).Pack(_spillPalette), _spillPalette);
+        }
+    }
+
+    // The top row may be one of the blank rows reserved for ContinueReflow().
+    // Once they're all gone, there's no room left for the rows that are still pending.
+    if (_reflowTop > 0 && --_reflowTop == 0)
+    {
+        _pendingReflow.clear();
+    }
+
     // Prune hyperlinks to delete obsolete references
     _PruneHyperlinks();
 
@@ -724,6 +1194,7 @@ void TextBuffer::IncrementCircularBuffer(const TextAttribute& fillAttributes)
         // Now proceed to increment.
         // Incrementing it will cause the next line down to become the new "top" of the window (the new "0" in logical coordinates)
         _firstRow++;
+        _circularBufferRotations++;
 
         // If we pass up the height of the buffer, loop back to 0.
         if (_firstRow >= GetSize().Height())
@@ -733,6 +1204,100 @@ void TextBuffer::IncrementCircularBuffer(const TextAttribute& fillAttributes)
     }
 }
 
+// Routine Description:
+// - Packs the rows that are far away from both the given viewport and the cursor into a compact representation
+//   and releases the memory they occupied. Packed rows that are close to either of them are unpacked again,
+//   so that painting and writing don't have to go through the packed representation.
+// - Packed rows can still be read through GetRowByOffset(), which returns a decoded copy. Those copies are freed here.
+// - This function destroys ROWs and so you must not hold on to any ROW references across calls to it.
+//   It's meant to be called when the buffer is idle, not while text is being written.
+void TextBuffer::PackColdRows(const Viewport& viewport)
+{
+    _dropDecodedRows();
+
+    // Returns true if any of the rows [beg,end] are close to the viewport or the cursor.
+    const auto cursorY = _cursor.GetPosition().y;
+    const auto isHot = [&](til::CoordType beg, til::CoordType end) {
+        return (beg <= viewport.BottomInclusive() + _packMinDistance && end >= viewport.Top() - _packMinDistance) ||
+               (beg <= cursorY + _packMinDistance && end >= cursorY - _packMinDistance);
+    };
+
+    if (_attributePalette.Size() >= _attributePaletteCompactSize)
+    {
+        _compactAttributePalette();
+    }
+
+    const auto chunkCount = (size_t{ _height } + _packChunkRowCount - 1) / _packChunkRowCount;
+    _packedChunks.resize(chunkCount);
+
+    for (size_t chunk = 0; chunk < chunkCount; ++chunk)
+    {
+        const auto physicalBeg = gsl::narrow_cast<til::CoordType>(chunk * _packChunkRowCount);
+        const auto physicalEnd = std::min<til::CoordType>(physicalBeg + gsl::narrow_cast<til::CoordType>(_packChunkRowCount), _height);
+        auto firstY = physicalBeg - _firstRow;
+        if (firstY < 0)
+        {
+            firstY += _height;
+        }
+
+        // If the chunk straddles _firstRow, then its rows are [firstY,_height) and [0,lastY-_height].
+        const auto lastY = firstY + (physicalEnd - physicalBeg) - 1;
+        const auto hot = lastY >= _height ? isHot(firstY, _height - 1) || isHot(0, lastY - _height) : isHot(firstY, lastY);
+        const auto packed = !til::at(_packedChunks, chunk).empty();
+
+        if (hot && packed)
+        {
+            _unpackChunk(chunk);
+        }
+        else if (!hot && !packed)
+        {
+            _packChunk(chunk);
+        }
+    }
+}
+
+// Rebuilds _attributePalette from the attributes that the packed rows still use. The palette's IDs aren't
+// reference counted, so like _PruneHyperlinks() does for hyperlinks, this is how unused ones are discarded.
+// If more than half of the IDs are still in use afterwards, the palette isn't compacted again and once it's full,
+// _packChunk() fails for rows with new attributes. That requires 32K distinct attributes in the scrollback.
+void TextBuffer::_compactAttributePalette()
+{
+    // Build the new palette before modifying anything, so that we remain consistent if this throws.
+    std::vector<uint16_t> remap(_attributePalette.Size());
+    std::vector<bool> used(_attributePalette.Size());
+    AttributePalette compacted;
+
+    for (const auto& chunk : _packedChunks)
+    {
+        for (const auto& row : chunk)
+        {
+            for (const auto& run : row.attr)
+            {
+                if (!til::at(used, run.value))
+                {
+                    til::at(used, run.value) = true;
+                    // The new palette can't be full, as it holds a subset of the current one.
+                    til::at(remap, run.value) = *compacted.Intern(_attributePalette.Get(run.value));
+                }
+            }
+        }
+    }
+
+    for (auto& chunk : _packedChunks)
+    {
+        for (auto& row : chunk)
+        {
+            for (auto& run : row.attr)
+            {
+                run.value = til::at(remap, run.value);
+            }
+        }
+    }
+
+    _attributePalette = std::move(compacted);
+    _attributePaletteCompactSize = _attributePalette.Size() + std::max(_attributePalette.Size(), _attributePaletteMinGrowth);
+}
+
 //Routine Description:
 // - Retrieves the position of the last non-space character in the given
 //   viewport
@@ -788,6 +1353,22 @@ const Viewport TextBuffer::GetSize() const noexcept
 
 void TextBuffer::_SetFirstRowIndex(const til::CoordType FirstRowIndex) noexcept
 {
+    try
+    {
+        FlushDamage();
+    }
+    catch (...)
+    {
+        LOG_CAUGHT_EXCEPTION();
+        // The physical row indices can't be kept past this point.
+        // Dropping them loses a redraw, but keeps them from landing on the wrong rows.
+        for (const auto physical : _damagedRows)
+        {
+            til::at(_damageSpans, gsl::narrow_cast<size_t>(physical)) = {};
+        }
+        _damagedRows.clear();
+    }
+    _invalidateMutationJournal();
     _firstRow = FirstRowIndex;
 }
 
@@ -884,9 +1465,46 @@ uint64_t TextBuffer::GetLastMutationId() const noexcept
     return _lastMutationId;
 }
 
-const TextAttribute& TextBuffer::GetCurrentAttributes() const noexcept
+// Returns how often IncrementCircularBuffer() has been called. Consumers which cache per-row
+// data (like Search) can use the difference between two calls to shift their row indices.
+uint64_t TextBuffer::GetCircularBufferRotations() const noexcept
 {
-    return _currentAttributes;
+    return _circularBufferRotations;
+}
+
+// Appends the rows (relative to the current first row) that were handed out by GetMutableRowByOffset()
+// after GetLastMutationId() returned `mutationId`. Rows may be reported more than once and in any order.
+// Returns false if that's unknown, because the mutation is too old or rows were moved around
+// in the meantime (for instance by a resize), in which case the caller must assume that all rows changed.
+bool TextBuffer::GetMutatedRowsSince(const uint64_t mutationId, std::vector<til::CoordType>& rows) const
+{
+    if (mutationId < _mutationJournalFloor)
+    {
+        return false;
+    }
+
+    const auto beg = std::ranges::upper_bound(_mutationJournal, mutationId, {}, &MutationJournalEntry::mutationId);
+    for (auto it = beg; it != _mutationJournal.end(); ++it)
+    {
+        // Rows that rotated out of the buffer don't exist anymore.
+        if (it->row >= _circularBufferRotations)
+        {
+            rows.emplace_back(gsl::narrow_cast<til::CoordType>(it->row - _circularBufferRotations));
+        }
+    }
+    return true;
+}
+
+// Returns the index of the last row that was ever written to (approximately).
+// Rows past this one are guaranteed to be empty.
+til::CoordType TextBuffer::EstimateOffsetOfLastCommittedRow() const noexcept
+{
+    return _estimateOffsetOfLastCommittedRow();
+}
+
+const TextAttribute& TextBuffer::GetCurrentAttributes() const noexcept
+{
+    return _currentAttributes;
 }
 
 void TextBuffer::SetCurrentAttributes(const TextAttribute& currentAttributes) noexcept
@@ -899,6 +1517,107 @@ void TextBuffer::SetWrapForced(const til::CoordType y, bool wrap)
     GetMutableRowByOffset(y).SetWrapForced(wrap);
 }
 
+// Same as GetRowByOffset(y).WasWrapForced(), but it reads the flag from _wrapForced,
+// which avoids decoding the row if it's packed.
+bool TextBuffer::WasWrapForced(til::CoordType y) const
+{
+    // The spilled rows (see EnableSpill()) aren't covered by _wrapForced.
+    if (y < 0 && _spill)
+    {
+        return GetRowByOffset(y).WasWrapForced();
+    }
+
+    const auto bit = _rowOffset(y) - 1;
+    return (_getWrapWord(bit / 64) >> (bit % 64)) & 1;
+}
+
+// Returns the first row of the logical line that contains row y, that is, the row after
+// the closest row above y whose wrap flag isn't set. The rows are scanned 64 at a time.
+til::CoordType TextBuffer::GetLogicalLineStart(til::CoordType y) const
+{
+    // The index of the row above y in _wrapForced.
+    auto bit = _rowOffset(y - 1) - 1;
+
+    while (y > 0)
+    {
+        const auto word = _getWrapWord(bit / 64);
+        const auto pos = gsl::narrow_cast<til::CoordType>(bit % 64);
+        const auto avail = std::min(pos + 1, y);
+
+        // Count the set bits going downwards from `pos`, which are the wrapped rows going upwards from y-1.
+        unsigned long zero;
+        const auto ones = _BitScanReverse64(&zero, ~word << (63 - pos)) ? 63 - gsl::narrow_cast<til::CoordType>(zero) : 64;
+        const auto run = std::min(ones, avail);
+
+        y -= run;
+        if (run < avail)
+        {
+            break;
+        }
+
+        // The rows are stored circularly. Continue at the end of the arena if we've reached its start.
+        bit = bit >= gsl::narrow_cast<size_t>(run) ? bit - run : size_t{ _height } - 1;
+    }
+
+    // The spilled rows (see EnableSpill()) aren't covered by _wrapForced.
+    // Like in SearchText() their lines are split at row 0.
+    if (y < 0 && _spill)
+    {
+        for (const auto top = -GetSpilledRowCount(); y > top && GetRowByOffset(y - 1).WasWrapForced(); --y)
+        {
+        }
+    }
+
+    return y;
+}
+
+// Returns the row past the last row of the logical line that contains row y, that is,
+// the row after the first row at or below y whose wrap flag isn't set. It's at most the buffer height.
+til::CoordType TextBuffer::GetLogicalLineEnd(til::CoordType y) const
+{
+    // The spilled rows (see EnableSpill()) aren't covered by _wrapForced.
+    // Like in SearchText() their lines are split at row 0.
+    if (y < 0 && _spill)
+    {
+        for (; y < -1 && GetRowByOffset(y).WasWrapForced(); ++y)
+        {
+        }
+        return y + 1;
+    }
+
+    // The index of the row end-1 in _wrapForced.
+    auto bit = _rowOffset(y) - 1;
+    auto end = y + 1;
+
+    while (end < _height)
+    {
+        const auto word = _getWrapWord(bit / 64);
+        const auto pos = gsl::narrow_cast<til::CoordType>(bit % 64);
+        // Stop at the end of the arena as well, since the row after that is at its start.
+        const auto avail = std::min({ 64 - pos, _height - end, _height - gsl::narrow_cast<til::CoordType>(bit) });
+
+        // Count the set bits going upwards from `pos`, which are the wrapped rows going downwards from end-1.
+        unsigned long zero;
+        const auto ones = _BitScanForward64(&zero, ~word >> pos) ? gsl::narrow_cast<til::CoordType>(zero) : 64;
+        const auto run = std::min(ones, avail);
+
+        end += run;
+        if (run < avail)
+        {
+            break;
+        }
+
+        // The rows are stored circularly. Continue at the start of the arena if we've reached its end.
+        bit += run;
+        if (bit == _height)
+        {
+            bit = 0;
+        }
+    }
+
+    return end;
+}
+
 void TextBuffer::SetCurrentLineRendition(const LineRendition lineRendition, const TextAttribute& fillAttributes)
 {
     const auto cursorPosition = GetCursor().GetPosition();
@@ -933,6 +1652,11 @@ void TextBuffer::ResetLineRenditionRange(const til::CoordType startRow, const ti
 
 LineRendition TextBuffer::GetLineRendition(const til::CoordType row) const
 {
+    // The renderer calls this for every invalidated region. There's no need to decode packed rows for it.
+    if (const auto packed = _getPackedRow(row))
+    {
+        return packed->lineRendition;
+    }
     return GetRowByOffset(row).GetLineRendition();
 }
 
@@ -974,6 +1698,12 @@ til::point TextBuffer::BufferToScreenPosition(const til::point position) const
 void TextBuffer::Reset() noexcept
 {
     _decommit();
+    _pendingReflow.clear();
+    _reflowTop = 0;
+    if (_spill)
+    {
+        _spill->Clear();
+    }
     _initialAttributes = _currentAttributes;
 }
 
@@ -982,6 +1712,14 @@ void TextBuffer::Reset() noexcept
 // - rowsToKeep: the number of rows to keep in the buffer.
 void TextBuffer::ClearScrollback(const til::CoordType newFirstRow, const til::CoordType rowsToKeep)
 {
+    if (_spill)
+    {
+        _spill->Clear();
+        _dropDecodedRows();
+    }
+    _pendingReflow.clear();
+    _reflowTop = 0;
+
     // We're already at the top? don't clear anything. There's no scrollback.
     if (newFirstRow <= 0)
     {
@@ -1003,7 +1741,7 @@ void TextBuffer::ClearScrollback(const til::CoordType newFirstRow, const til::Co
     // the absolute start while reading from relative coordinates. This works because GetRowByOffset()
     // operates modulo the buffer height and so the possibly-too-large startAbsolute won't be an issue.
     const auto startAbsolute = _firstRow + newFirstRow;
-    _firstRow = 0;
+    _SetFirstRowIndex(0);
     ScrollRows(startAbsolute, rowsToKeep, -startAbsolute);
 
     const auto end = _estimateOffsetOfLastCommittedRow();
@@ -1025,6 +1763,9 @@ void TextBuffer::ResizeTraditional(til::size newSize)
     newSize.width = std::max(newSize.width, 1);
     newSize.height = std::max(newSize.height, 1);
 
+    // The damage is indexed by physical row and wouldn't survive the change in height.
+    FlushDamage();
+
     TextBuffer newBuffer{ newSize, _currentAttributes, 0, false, _renderer };
     const auto cursorRow = GetCursor().GetPosition().y;
     const auto copyableRows = std::min<til::CoordType>(_height, newSize.height);
@@ -1051,12 +1792,26 @@ void TextBuffer::ResizeTraditional(til::size newSize)
     _bufferOffsetCharOffsets = newBuffer._bufferOffsetCharOffsets;
     _width = newBuffer._width;
     _height = newBuffer._height;
+    _packedChunks = std::move(newBuffer._packedChunks);
+    _packedChunkCount = std::exchange(newBuffer._packedChunkCount, 0);
+    _dropDecodedRows();
+    _attributePalette = std::move(newBuffer._attributePalette);
+    _attributePaletteCompactSize = newBuffer._attributePaletteCompactSize;
+    _wrapForced = std::move(newBuffer._wrapForced);
+    _hasMark = std::move(newBuffer._hasMark);
+    _rowFlagsDirty = std::move(newBuffer._rowFlagsDirty);
 
     _SetFirstRowIndex(0);
 }
 
 void TextBuffer::SetAsActiveBuffer(const bool isActiveBuffer) noexcept
 {
+    if (!isActiveBuffer)
+    {
+        // Whoever activates the other buffer redraws everything anyway.
+        _damageSpans.clear();
+        _damagedRows.clear();
+    }
     _isActiveBuffer = isActiveBuffer;
 }
 
@@ -1078,11 +1833,18 @@ void TextBuffer::NotifyPaintFrame() noexcept
     }
 }
 
+// Routine Description:
+// - Marks the given region (in buffer coordinates) as damaged. Unlike calling Renderer::TriggerRedraw(),
+//   this doesn't need to wait for the renderer to finish painting the current frame.
 void TextBuffer::TriggerRedraw(const Viewport& viewport)
 {
-    if (_isActiveBuffer && _renderer)
+    const auto rect = viewport.ToExclusive();
+    const auto left = std::clamp(rect.left, 0, _width);
+    const auto right = std::clamp(rect.right, 0, _width);
+
+    for (auto y = std::max(rect.top, 0); y < std::min(rect.bottom, _height); ++y)
     {
-        _renderer->TriggerRedraw(viewport);
+        _damageRow(y, left, right);
     }
 }
 
@@ -1118,6 +1880,103 @@ void TextBuffer::TriggerNewTextNotification(const std::wstring_view newText)
     }
 }
 
+// Routine Description:
+// - Appends the regions (in buffer coordinates) that were written to since the last call to rects and marks them clean.
+// - Vertically adjacent rows with identical column spans are merged into a single rectangle,
+//   which is the common case when text is printed line by line.
+void TextBuffer::TakeDamage(std::vector<til::rect>& rects)
+{
+    if (_damagedRows.empty())
+    {
+        return;
+    }
+
+    std::sort(_damagedRows.begin(), _damagedRows.end());
+
+    til::rect rect;
+    for (const auto physical : _damagedRows)
+    {
+        auto& span = til::at(_damageSpans, gsl::narrow_cast<size_t>(physical));
+        const auto y = (physical - _firstRow + _height) % _height;
+
+        if (y == rect.bottom && span.begin == rect.left && span.end == rect.right)
+        {
+            rect.bottom++;
+        }
+        else
+        {
+            if (rect)
+            {
+                rects.emplace_back(rect);
+            }
+            rect = { span.begin, y, span.end, y + 1 };
+        }
+
+        span = {};
+    }
+
+    rects.emplace_back(rect);
+    _damagedRows.clear();
+}
+
+// Routine Description:
+// - Hands the damage over to the renderer right away. Used before _firstRow or _height
+//   change in a way that the physical row indices of the damage can't represent.
+void TextBuffer::FlushDamage()
+{
+    if (_damagedRows.empty())
+    {
+        return;
+    }
+
+    std::vector<til::rect> rects;
+    TakeDamage(rects);
+
+    if (_isActiveBuffer && _renderer)
+    {
+        for (const auto& rect : rects)
+        {
+            _renderer->TriggerRedraw(Viewport::FromExclusive(rect));
+        }
+    }
+}
+
+// Routine Description:
+// - Records that the columns [begin,end) of the given row were modified.
+// - This replaces calling TriggerRedraw() for every write: The renderer collects the damage
+//   once per frame via TakeDamage(), instead of invalidating every engine for every write.
+void TextBuffer::_damageRow(const til::CoordType row, const til::CoordType begin, const til::CoordType end)
+{
+    if (!_isActiveBuffer || !_renderer || begin >= end)
+    {
+        return;
+    }
+
+    // Sized lazily, since most TextBuffer instances are never active.
+    if (_damageSpans.size() != gsl::narrow_cast<size_t>(_height))
+    {
+        _damageSpans.resize(gsl::narrow_cast<size_t>(_height));
+    }
+
+    const auto physical = (_firstRow + row) % _height;
+    auto& span = til::at(_damageSpans, gsl::narrow_cast<size_t>(physical));
+
+    if (span.begin < span.end)
+    {
+        span.begin = std::min(span.begin, begin);
+        span.end = std::max(span.end, end);
+        return;
+    }
+
+    if (_damagedRows.empty())
+    {
+        _renderer->NotifyPaintFrame();
+    }
+
+    _damagedRows.emplace_back(physical);
+    span = { begin, end };
+}
+
 // Method Description:
 // - get delimiter class for buffer cell position
 // - used for double click selection and uia word navigation
@@ -1256,8 +2115,7 @@ til::point TextBuffer::_GetWordStartForSelection(const til::point target, const
             if (result.y > 0)
             {
                 // Prevent wrapping to the previous line if it was hard-wrapped (e.g. not forced by us to wrap)
-                const auto& priorRow = GetRowByOffset(result.y - 1);
-                if (!priorRow.WasWrapForced())
+                if (!WasWrapForced(result.y - 1))
                 {
                     break;
                 }
@@ -1390,8 +2248,7 @@ til::point TextBuffer::_GetWordEndForSelection(const til::point target, const st
             }
 
             // Prevent wrapping to the next line if this one was hard-wrapped (e.g. not forced by us to wrap)
-            const auto& row = GetRowByOffset(result.y);
-            if (!row.WasWrapForced())
+            if (!WasWrapForced(result.y))
             {
                 break;
             }
@@ -1432,7 +2289,9 @@ void TextBuffer::_PruneHyperlinks()
         // to see if those references are anywhere else
         for (til::CoordType i = 1; i < total; ++i)
         {
-            const auto nextRowRefs = GetRowByOffset(i).GetHyperlinks();
+            // Avoid decoding the entire scrollback just to look at its hyperlinks.
+            const auto packed = _getPackedRow(i);
+            const auto nextRowRefs = packed ? packed->GetHyperlinks(_attributePalette) : GetRowByOffset(i).GetHyperlinks();
             for (auto id : nextRowRefs)
             {
                 if (firstRowRefs.find(id) != firstRowRefs.end())
@@ -1827,6 +2686,12 @@ size_t TextBuffer::SpanLength(const til::point coordStart, const til::point coor
 // - Just the text.
 std::wstring TextBuffer::GetPlainText(const til::point start, const til::point end) const
 {
+    // Negative rows refer to the spilled scrollback. See EnableSpill().
+    if (start.y < 0 && _spill)
+    {
+        return _getSpilledPlainText(start, end);
+    }
+
     const auto req = CopyRequest::FromConfig(*this, start, end, true, false, false, false);
     return GetPlainText(req);
 }
@@ -1871,7 +2736,7 @@ std::tuple<til::CoordType, til::CoordType, bool> TextBuffer::_RowCopyHelper(cons
 
     // When `formatWrappedRows` is set, apply formatting on all rows (wrapped
     // and non-wrapped), but when it's false, format non-wrapped rows only.
-    const auto shouldFormatRow = req.formatWrappedRows || !row.WasWrapForced();
+    const auto shouldFormatRow = req.formatWrappedRows || !WasWrapForced(iRow);
 
     // trim trailing whitespace
     if (shouldFormatRow && req.trimTrailingWhitespace)
@@ -2649,9 +3514,15 @@ void TextBuffer::Serialize(const wchar_t* destination) const
 // - positionInfo - Optional. The caller can provide a pair of rows in this
 //   parameter and we'll calculate the position of the _end_ of those rows in
 //   the new buffer. The rows's new value is placed back into this parameter.
+// - oldBeg, oldEnd - Optional. Only reflow the rows [oldBeg,oldEnd) of the old buffer.
+//   oldBeg must be the start of a logical line and at or above the cursor and positionInfo.
+//   If oldEnd is given, it must be the end of a logical line and above the cursor.
+//   See GetLazyReflowStart() and ContinueReflow().
+// - newBeg - Optional. The number of blank rows to leave at the top of the new buffer.
+//   See GetLazyReflowReserve().
 // Return Value:
-// - S_OK if we successfully copied the contents to the new buffer, otherwise an appropriate HRESULT.
-void TextBuffer::Reflow(TextBuffer& oldBuffer, TextBuffer& newBuffer, const Viewport* lastCharacterViewport, PositionInformation* positionInfo)
+// - The number of rows that were written to the new buffer.
+til::CoordType TextBuffer::Reflow(TextBuffer& oldBuffer, TextBuffer& newBuffer, const Viewport* lastCharacterViewport, PositionInformation* positionInfo, til::CoordType oldBeg, til::CoordType oldEnd, til::CoordType newBeg)
 {
     const auto& oldCursor = oldBuffer.GetCursor();
     auto& newCursor = newBuffer.GetCursor();
@@ -2668,18 +3539,17 @@ void TextBuffer::Reflow(TextBuffer& oldBuffer, TextBuffer& newBuffer, const View
     oldCursorPos.x = std::clamp(oldCursorPos.x, 0, oldBuffer._width - 1);
     oldCursorPos.y = std::clamp(oldCursorPos.y, 0, oldBuffer._height - 1);
 
-    const auto lastRowWithText = oldBuffer.GetLastNonSpaceCharacter(lastCharacterViewport).y;
-
     auto mutableViewportTop = positionInfo ? positionInfo->mutableViewportTop : til::CoordTypeMax;
     auto visibleViewportTop = positionInfo ? positionInfo->visibleViewportTop : til::CoordTypeMax;
 
-    til::CoordType oldY = 0;
-    til::CoordType newY = 0;
+    til::CoordType oldY = oldBeg;
+    til::CoordType newY = newBeg;
     til::CoordType newX = 0;
     til::CoordType newWidth = newBuffer.GetSize().Width();
     til::CoordType newYLimit = til::CoordTypeMax;
 
-    const auto oldHeight = std::max(lastRowWithText, oldCursorPos.y) + 1;
+    // Finding the last row with text may scan the entire buffer, which we don't need if we're given a range.
+    const auto oldHeight = oldEnd != til::CoordTypeMax ? oldEnd : std::max(oldBuffer.GetLastNonSpaceCharacter(lastCharacterViewport).y, oldCursorPos.y) + 1;
     const auto newHeight = newBuffer.GetSize().Height();
     const auto newWidthU16 = gsl::narrow_cast<uint16_t>(newWidth);
 
@@ -2860,7 +3730,7 @@ void TextBuffer::Reflow(TextBuffer& oldBuffer, TextBuffer& newBuffer, const View
     // printable character. This is to fix the `color 2f` scenario, where you
     // change the buffer colors then resize and everything below the last
     // printable char gets reset. See GH #12567
-    const auto initializedRowsEnd = oldBuffer._estimateOffsetOfLastCommittedRow() + 1;
+    const auto initializedRowsEnd = std::min(oldEnd, oldBuffer._estimateOffsetOfLastCommittedRow() + 1);
     for (; oldY < initializedRowsEnd && newY < newHeight; oldY++, newY++)
     {
         auto& oldRow = oldBuffer.GetRowByOffset(oldY);
@@ -2885,11 +3755,148 @@ void TextBuffer::Reflow(TextBuffer& oldBuffer, TextBuffer& newBuffer, const View
 
     newBuffer.CopyProperties(oldBuffer);
     newBuffer.CopyHyperlinkMaps(oldBuffer);
+    // The spilled rows are read back at their original width. See _unspill().
+    newBuffer._spill = std::move(oldBuffer._spill);
+    // If we wrapped around, the oldest of the reserved rows were overwritten.
+    newBuffer._reflowTop = std::max(0, newBeg - std::max(0, newY - newHeight));
 
     assert(newCursorPos.x >= 0 && newCursorPos.x < newWidth);
     assert(newCursorPos.y >= 0 && newCursorPos.y < newHeight);
     newCursor.SetSize(oldCursor.GetSize());
     newCursor.SetPosition(newCursorPos);
+
+    return std::min(newY, newHeight);
+}
+
+// Returns the row at which a resize should start to Reflow() the given buffer, so that only the rows at and
+// below `row` (plus some margin) are reflowed right away and the rest later via ContinueReflow().
+// If there aren't enough rows above `row` to make this worthwhile, this returns the first row in use,
+// which is past the rows the buffer has reserved for its own ContinueReflow(), if any.
+til::CoordType TextBuffer::GetLazyReflowStart(const TextBuffer& buffer, til::CoordType row)
+{
+    auto beg = row - _reflowEagerRowCount;
+    if (beg - buffer._reflowTop < _reflowEagerRowCount)
+    {
+        return buffer._reflowTop;
+    }
+
+    // Reflow() must start at the beginning of a logical line.
+    return buffer.GetLogicalLineStart(beg);
+}
+
+// Returns the number of blank rows Reflow() should leave at the top of a buffer of size newSize (its newBeg parameter),
+// so that ContinueReflow() has room for the rows of `buffer` above `end` and for the rows that are still pending in it.
+// It assumes that every row wraps into ceil(oldWidth / newWidth) rows. Whatever isn't needed is removed in the end.
+til::CoordType TextBuffer::GetLazyReflowReserve(const TextBuffer& buffer, til::CoordType end, til::size newSize)
+{
+    int64_t rows = 0;
+    const auto add = [&](const TextBuffer& source, til::CoordType count) {
+        const auto widthRatio = (source._width + newSize.width - 1) / newSize.width;
+        rows += int64_t{ std::max(0, count) } * widthRatio;
+    };
+
+    add(buffer, end - buffer._reflowTop);
+    for (const auto& pending : buffer._pendingReflow)
+    {
+        add(*pending.source, pending.end - pending.beg);
+    }
+
+    return gsl::narrow_cast<til::CoordType>(std::min<int64_t>(rows, newSize.height));
+}
+
+// Takes ownership of the buffer that was passed to Reflow() as the oldBuffer, along with the rows
+// of it that were skipped via the oldBeg parameter, so that ContinueReflow() can reflow them later.
+// The rows that were still pending in the old buffer are taken over as well, as they're even older.
+void TextBuffer::DeferReflow(std::unique_ptr<TextBuffer> oldBuffer, til::CoordType end)
+{
+    _pendingReflow = std::move(oldBuffer->_pendingReflow);
+
+    const auto beg = oldBuffer->_reflowTop;
+    if (end > beg)
+    {
+        // The rows below `end` are already part of this buffer.
+        oldBuffer->_decommitFrom(end);
+        _pendingReflow.emplace_back(PendingReflow{ std::move(oldBuffer), beg, end });
+    }
+
+    // Reflow() had to overwrite all of the reserved rows, so there's no room for the pending ones.
+    if (_reflowTop == 0)
+    {
+        _pendingReflow.clear();
+    }
+}
+
+bool TextBuffer::IsReflowPending() const noexcept
+{
+    return !_pendingReflow.empty() || _reflowTop > 0;
+}
+
+// Reflows roughly rowBudget rows that were deferred by DeferReflow() into the blank rows [0,_reflowTop)
+// that Reflow() reserved for them, filling them from the bottom up. Rows that don't fit are discarded,
+// just like Reflow() would have done. None of the existing rows move, except once everything is reflowed:
+// The reserved rows that weren't needed are then removed by rotating them to the bottom of the buffer.
+// Returns the number of rows removed that way, by which the caller needs to adjust its own row coordinates.
+til::CoordType TextBuffer::ContinueReflow(til::CoordType rowBudget)
+{
+    if (_pendingReflow.empty())
+    {
+        const auto unused = std::exchange(_reflowTop, 0);
+        if (unused > 0)
+        {
+            // The rows are blank and nothing gets evicted, so unlike with IncrementCircularBuffer()
+            // this doesn't count as a rotation and the spilled rows (if any) stay where they are.
+            _firstRow = (_firstRow + unused) % _height;
+            _invalidateMutationJournal();
+
+            auto cursorPos = _cursor.GetPosition();
+            cursorPos.y -= unused;
+            _cursor.SetPosition(cursorPos);
+        }
+        return unused;
+    }
+
+    auto& pending = _pendingReflow.back();
+    const auto end = pending.end;
+    // Reflow() must start at the beginning of a logical line.
+    const auto beg = std::max(pending.beg, pending.source->GetLogicalLineStart(end - std::max(1, rowBudget)));
+
+    // In the worst case each row wraps into ceil(oldWidth / newWidth) rows.
+    const auto widthRatio = (pending.source->_width + _width - 1) / _width;
+    const auto maxRows = std::min<int64_t>(int64_t{ end - beg } * widthRatio + 1, UINT16_MAX);
+    TextBuffer rows{ { _width, gsl::narrow_cast<til::CoordType>(maxRows) }, _initialAttributes, 0, false, nullptr };
+    const auto count = Reflow(*pending.source, rows, nullptr, nullptr, beg, end);
+    const auto inserted = std::min(count, _reflowTop);
+
+    // GetMutableRowByOffset() records the rows in the mutation journal and the ROWs mark their flags as dirty,
+    // which lets the search and the scroll marks catch up on them like on any other output.
+    for (til::CoordType y = 0; y < inserted; ++y)
+    {
+        const auto& src = rows.GetRowByOffset(count - inserted + y);
+        auto& dst = GetMutableRowByOffset(_reflowTop - inserted + y);
+        dst.Reset(_initialAttributes);
+        dst.CopyFrom(src);
+        dst.SetScrollbarData(src.GetScrollbarData());
+        ImageSlice::CopyRow(src, dst);
+    }
+
+    _reflowTop -= inserted;
+
+    if (inserted < count || _reflowTop == 0)
+    {
+        // The buffer is full and everything that's still pending is older than the rows we just inserted.
+        _pendingReflow.clear();
+    }
+    else if (beg == pending.beg)
+    {
+        _pendingReflow.pop_back();
+    }
+    else
+    {
+        pending.end = beg;
+        pending.source->_decommitFrom(beg);
+    }
+
+    return 0;
 }
 
 // Method Description:
@@ -3002,7 +4009,7 @@ void TextBuffer::CopyHyperlinkMaps(const TextBuffer& other)
 // The end coordinates of the returned ranges are considered inclusive.
 std::optional<std::vector<til::point_span>> TextBuffer::SearchText(const std::wstring_view& needle, SearchFlag flags) const
 {
-    return SearchText(needle, flags, 0, til::CoordTypeMax);
+    return SearchText(needle, flags, -GetSpilledRowCount(), til::CoordTypeMax);
 }
 
 // Searches through the given rows [rowBeg,rowEnd) for `needle` and returns the coordinates in absolute coordinates.
@@ -3020,8 +4027,6 @@ std::optional<std::vector<til::point_span>> TextBuffer::SearchText(const std::ws
         return results;
     }
 
-    auto text = ICU::UTextFromTextBuffer(*this, rowBeg, rowEnd);
-
     uint32_t icuFlags{ 0 };
     WI_SetFlagIf(icuFlags, UREGEX_CASE_INSENSITIVE, WI_IsFlagSet(flags, SearchFlag::CaseInsensitive));
 
@@ -3041,33 +4046,519 @@ std::optional<std::vector<til::point_span>> TextBuffer::SearchText(const std::ws
         return std::nullopt;
     }
 
-    uregex_setUText(re.get(), &text, &status);
-
-    if (uregex_find(re.get(), -1, &status))
+    // Negative rows refer to the spilled scrollback. See EnableSpill().
+    if (rowBeg < 0)
     {
-        do
+        if (_spill)
         {
-            results.emplace_back(ICU::BufferRangeFromMatch(&text, re.get()));
-        } while (uregex_findNext(re.get(), &status));
+            _searchSpilledText(needle, flags, std::max(rowBeg, -GetSpilledRowCount()), std::min(rowEnd, 0), results);
+        }
+        rowBeg = 0;
+        if (rowBeg >= rowEnd)
+        {
+            return results;
+        }
+    }
+
+    const auto filter = _createSearchFilter(needle, flags);
+    // Literal needles are mostly searched without ICU. It's only used for text our LiteralSearcher can't handle.
+    std::optional<LiteralSearcher> literal;
+    if (WI_IsFlagClear(flags, SearchFlag::RegularExpression) && needle.find_first_of(L"\r\n") == std::wstring_view::npos)
+    {
+        literal = LiteralSearcher::Create(needle, WI_IsFlagSet(flags, SearchFlag::CaseInsensitive));
+    }
+    const auto literalPtr = literal ? &*literal : nullptr;
+
+    // Literal needles can't span across a hard line break (the UText adapter joins them with "\n"),
+    // which allows us to split the range into independent shards and search them concurrently.
+    // Regular expressions on the other hand may match any number of lines (e.g. "\s+").
+    if (WI_IsFlagClear(flags, SearchFlag::RegularExpression) && needle.find_first_of(L"\r\n") == std::wstring_view::npos && rowEnd - rowBeg >= 2 * _searchShardMinRowCount)
+    {
+        _searchTextParallel(re.get(), literalPtr, filter, flags, rowBeg, rowEnd, results);
+    }
+    else
+    {
+        _searchTextRange(re.get(), literalPtr, filter, flags, rowBeg, rowEnd, results);
     }
 
     return results;
 }
 
+// Searches through the rows [rowBeg,rowEnd) using the given regex and appends the matches to `results`.
+// If a `filter` is given (see _createSearchFilter), only logical lines matching it will be searched.
+// If a `literal` searcher is given, it's used for all logical lines that it supports instead of the regex.
+void TextBuffer::_searchTextRange(URegularExpression* re, const LiteralSearcher* literal, const std::vector<std::pair<wchar_t, wchar_t>>& filter, SearchFlag flags, til::CoordType rowBeg, til::CoordType rowEnd, std::vector<til::point_span>& results) const
+{
+    UErrorCode status = U_ZERO_ERROR;
+
+    const auto searchRows = [&](til::CoordType beg, til::CoordType end) {
+        auto text = ICU::UTextFromTextBuffer(*this, beg, end);
+        uregex_setUText(re, &text, &status);
+
+        if (uregex_find(re, -1, &status))
+        {
+            do
+            {
+                results.emplace_back(ICU::BufferRangeFromMatch(&text, re));
+            } while (uregex_findNext(re, &status));
+        }
+    };
+
+    if (filter.empty() && !literal)
+    {
+        searchRows(rowBeg, rowEnd);
+        return;
+    }
+
+    std::wstring joined;
+    std::vector<size_t> joinedOffsets;
+
+    // Returns the text of the logical line [beg,end) if it can be searched with `literal`.
+    const auto literalText = [&](til::CoordType beg, til::CoordType end) -> std::optional<std::wstring_view> {
+        if (!literal)
+        {
+            return std::nullopt;
+        }
+
+        std::wstring_view text;
+        joinedOffsets.clear();
+
+        if (end - beg == 1)
+        {
+            text = GetRowByOffset(beg).GetText();
+        }
+        else
+        {
+            // Soft-wrapped rows are joined without separator, just like the UText adapter does.
+            joined.clear();
+            for (auto y = beg; y < end; ++y)
+            {
+                joinedOffsets.emplace_back(joined.size());
+                joined.append(GetRowByOffset(y).GetText());
+            }
+            text = joined;
+        }
+
+        if (!literal->IsSupportedText(text))
+        {
+            return std::nullopt;
+        }
+        return text;
+    };
+
+    // Searches the `text` previously returned by literalText() for the logical line starting at `beg`.
+    const auto searchLiteral = [&](const std::wstring_view& text, til::CoordType beg) {
+        // Returns the row and the offset within it for the given offset into `text`.
+        const auto rowAt = [&](size_t offset) {
+            if (joinedOffsets.empty())
+            {
+                return std::pair{ beg, offset };
+            }
+            const auto it = std::upper_bound(joinedOffsets.begin(), joinedOffsets.end(), offset) - 1;
+            return std::pair{ beg + gsl::narrow_cast<til::CoordType>(it - joinedOffsets.begin()), offset - *it };
+        };
+
+        const auto length = literal->NeedleLength();
+        for (auto pos = literal->Find(text, 0); pos != std::wstring_view::npos; pos = literal->Find(text, pos + length))
+        {
+            const auto [startY, startOffset] = rowAt(pos);
+            const auto [endY, endOffset] = rowAt(pos + length - 1);
+            auto& span = results.emplace_back();
+            span.start.x = GetRowByOffset(startY).GetLeadingColumnAtCharOffset(gsl::narrow_cast<ptrdiff_t>(startOffset));
+            span.start.y = startY;
+            span.end.x = GetRowByOffset(endY).GetTrailingColumnAtCharOffset(gsl::narrow_cast<ptrdiff_t>(endOffset));
+            span.end.y = endY;
+        }
+    };
+
+    // Since literal needles can't span across hard line breaks, we can check each logical line (a series of
+    // soft-wrapped rows) against the row summaries on its own. Consecutive candidate lines which can't be
+    // searched with `literal` are coalesced so that we don't set up a UText for each of them.
+    auto candidateBeg = rowBeg;
+    auto candidateEnd = rowBeg;
+
+    const auto flushCandidates = [&]() {
+        if (candidateBeg != candidateEnd)
+        {
+            searchRows(candidateBeg, candidateEnd);
+        }
+        candidateBeg = candidateEnd;
+    };
+
+    for (auto y = rowBeg; y < rowEnd;)
+    {
+        const auto lineBeg = y;
+        y = std::min(rowEnd, GetLogicalLineEnd(y));
+
+        if (!filter.empty() && !_mayContainSearchFilter(filter, flags, lineBeg, y))
+        {
+            continue;
+        }
+
+        if (const auto text = literalText(lineBeg, y))
+        {
+            // The results must be in order, so any pending ICU run is searched first.
+            flushCandidates();
+            searchLiteral(*text, lineBeg);
+            continue;
+        }
+
+        if (candidateEnd != lineBeg)
+        {
+            flushCandidates();
+            candidateBeg = lineBeg;
+        }
+        candidateEnd = y;
+    }
+
+    flushCandidates();
+}
+
+// Splits the rows [rowBeg,rowEnd) into shards and searches them on the thread pool. The calling thread
+// participates in the search and blocks until all shards are done, so the caller's lock (if any) protects
+// the buffer for the duration. Shards are split at hard line breaks, which means that matches spanning
+// soft-wrapped rows are always found in their entirety by a single shard. The results are identical to
+// what _searchTextRange() would produce over the entire range and are appended to `results` in order.
+void TextBuffer::_searchTextParallel(URegularExpression* re, const LiteralSearcher* literal, const std::vector<std::pair<wchar_t, wchar_t>>& filter, SearchFlag flags, til::CoordType rowBeg, til::CoordType rowEnd, std::vector<til::point_span>& results) const
+{
+    struct Shard
+    {
+        til::CoordType beg = 0;
+        til::CoordType end = 0;
+        std::vector<til::point_span> results;
+    };
+
+    struct Context
+    {
+        const TextBuffer* self = nullptr;
+        URegularExpression* re = nullptr;
+        const LiteralSearcher* literal = nullptr;
+        const std::vector<std::pair<wchar_t, wchar_t>>* filter = nullptr;
+        SearchFlag flags{};
+        std::vector<Shard> shards;
+        std::atomic<size_t> next{ 0 };
+        std::mutex exceptionLock;
+        std::exception_ptr exception;
+
+        // Each invocation keeps taking shards until there are none left. This way it doesn't
+        // matter how many thread pool callbacks actually get to run and in what order.
+        void Run() noexcept
+        try
+        {
+            UErrorCode status = U_ZERO_ERROR;
+            const ICU::unique_uregex clone{ uregex_clone(re, &status) };
+            THROW_HR_IF(E_OUTOFMEMORY, status > U_ZERO_ERROR);
+
+            for (auto i = next.fetch_add(1, std::memory_order_relaxed); i < shards.size(); i = next.fetch_add(1, std::memory_order_relaxed))
+            {
+                auto& shard = til::at(shards, i);
+                self->_searchTextRange(clone.get(), literal, *filter, flags, shard.beg, shard.end, shard.results);
+            }
+        }
+        catch (...)
+        {
+            const std::scoped_lock guard{ exceptionLock };
+            exception = std::current_exception();
+            // Skip all remaining shards. The search failed anyway.
+            next.store(shards.size(), std::memory_order_relaxed);
+        }
+    };
+
+    // GetLogicalLineEnd() lazily refreshes the mutable _wrapForced and _hasMark words via _refreshRowFlags().
+    // Neighboring shards share those words, so they'd race on them. Get that out of the way now.
+    for (size_t word = 0; word < _rowFlagsDirty.size(); ++word)
+    {
+        _refreshRowFlags(word);
+    }
+
+    const auto rowCount = rowEnd - rowBeg;
+    const auto threads = gsl::narrow_cast<til::CoordType>(std::max(1u, std::thread::hardware_concurrency()));
+    // We create a few more shards than there are threads, in order to balance the load
+    // in case that some shards contain considerably more candidate rows than others.
+    const auto shardCount = std::clamp(rowCount / _searchShardMinRowCount, 1, threads * 4);
+
+    Context ctx;
+    ctx.self = this;
+    ctx.re = re;
+    ctx.literal = literal;
+    ctx.filter = &filter;
+    ctx.flags = flags;
+    ctx.shards.reserve(gsl::narrow_cast<size_t>(shardCount));
+
+    auto beg = rowBeg;
+    for (til::CoordType i = 1; i <= shardCount && beg < rowEnd; ++i)
+    {
+        auto end = rowBeg + gsl::narrow_cast<til::CoordType>(int64_t{ rowCount } * i / shardCount);
+        // Move the boundary down to the start of the next logical line.
+        end = std::min(rowEnd, GetLogicalLineEnd(end - 1));
+        if (end > beg)
+        {
+            ctx.shards.emplace_back(Shard{ .beg = beg, .end = end });
+            beg = end;
+        }
+    }
+
+    static constexpr auto callback = [](PTP_CALLBACK_INSTANCE, PVOID context, PTP_WORK) noexcept {
+        static_cast<Context*>(context)->Run();
+    };
+
+    wil::unique_threadpool_work work{ CreateThreadpoolWork(callback, &ctx, nullptr) };
+    THROW_LAST_ERROR_IF(!work);
+
+    const auto workers = std::min<size_t>(gsl::narrow_cast<size_t>(threads), ctx.shards.size()) - 1;
+    for (size_t i = 0; i < workers; ++i)
+    {
+        SubmitThreadpoolWork(work.get());
+    }
+
+    ctx.Run();
+    WaitForThreadpoolWorkCallbacks(work.get(), FALSE);
+
+    if (ctx.exception)
+    {
+        std::rethrow_exception(ctx.exception);
+    }
+
+    size_t total = 0;
+    for (const auto& shard : ctx.shards)
+    {
+        total += shard.results.size();
+    }
+
+    results.reserve(results.size() + total);
+    for (const auto& shard : ctx.shards)
+    {
+        results.insert(results.end(), shard.results.begin(), shard.results.end());
+    }
+}
+
+// Returns the (folded) bigrams in `needle` that every row summary must contain for it to be a
+// candidate for a literal search. An empty return value means that the filter can't be used.
+std::vector<std::pair<wchar_t, wchar_t>> TextBuffer::_createSearchFilter(const std::wstring_view& needle, SearchFlag flags)
+{
+    std::vector<std::pair<wchar_t, wchar_t>> bigrams;
+
+    // Regular expressions are opaque to us and literal newlines match across hard line breaks.
+    if (WI_IsFlagSet(flags, SearchFlag::RegularExpression) || needle.size() < 2 || needle.find_first_of(L"\r\n") != std::wstring_view::npos)
+    {
+        return bigrams;
+    }
+
+    const auto caseInsensitive = WI_IsFlagSet(flags, SearchFlag::CaseInsensitive);
+    bigrams.reserve(needle.size() - 1);
+
+    for (size_t i = 1; i < needle.size(); ++i)
+    {
+        const auto a = til::at(needle, i - 1);
+        const auto b = til::at(needle, i);
+        // With full case folding, non-ASCII characters may match strings of a different length.
+        // Bigrams containing them are skipped, which results in a less selective filter.
+        if (caseInsensitive && (a >= 0x80 || b >= 0x80))
+        {
+            continue;
+        }
+        bigrams.emplace_back(RowSearchSummary::Fold(a), RowSearchSummary::Fold(b));
+    }
+
+    return bigrams;
+}
+
+// Returns true if the logical line spanning the rows [rowBeg,rowEnd) may contain all of the bigrams in `filter`.
+bool TextBuffer::_mayContainSearchFilter(const std::vector<std::pair<wchar_t, wchar_t>>& filter, SearchFlag flags, til::CoordType rowBeg, til::CoordType rowEnd) const
+{
+    const auto caseInsensitive = WI_IsFlagSet(flags, SearchFlag::CaseInsensitive);
+    RowSearchSummary line;
+    wchar_t prevLast = 0;
+
+    for (auto y = rowBeg; y < rowEnd; ++y)
+    {
+        const auto& summary = _getSearchSummary(y);
+
+        // An empty row would make us reconstruct the wrong bigram between its neighbors.
+        if ((caseInsensitive && summary.nonAscii) || summary.first == 0)
+        {
+            return true;
+        }
+
+        for (size_t i = 0; i < RowSearchSummary::BloomWords; ++i)
+        {
+            til::at(line.bloom, i) |= til::at(summary.bloom, i);
+        }
+
+        if (y != rowBeg)
+        {
+            line.AddBigram(prevLast, summary.first);
+        }
+        prevLast = summary.last;
+    }
+
+    for (const auto& [a, b] : filter)
+    {
+        if (!line.MayContainBigram(a, b))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Returns the search summary of the given row, without decoding it if it's packed.
+// This way only the packed rows that pass the filter get decoded by _searchTextRange().
+const RowSearchSummary& TextBuffer::_getSearchSummary(til::CoordType y) const
+{
+    if (const auto packed = _getPackedRow(y))
+    {
+        return packed->searchSummary;
+    }
+    return GetRowByOffset(y).GetSearchSummary();
+}
+
+// Routine Description:
+// - Enables unbounded scrollback: Rows that IncrementCircularBuffer() evicts from the top of the buffer
+//   are appended to an append-only, memory-mapped file on disk instead of being discarded (see SpillLog).
+// - Spilled rows are addressed with negative row indices: -1 is the row right above row 0
+//   and -GetSpilledRowCount() the oldest one. GetRowByOffset(), SearchText(), GetPlainText() and
+//   GetLogicalLineStart/End() accept them. Searching the entire buffer includes them.
+// - Hyperlinks in spilled rows aren't kept alive. Their IDs may refer to hyperlinks that were pruned.
+void TextBuffer::EnableSpill()
+{
+    if (!_spill)
+    {
+        _spill = std::make_unique<SpillLog>();
+    }
+}
+
+bool TextBuffer::IsSpillEnabled() const noexcept
+{
+    return _spill != nullptr;
+}
+
+// Returns the number of rows that are accessible with negative row indices.
+til::CoordType TextBuffer::GetSpilledRowCount() const noexcept
+{
+    return _spill ? gsl::narrow_cast<til::CoordType>(std::min<uint64_t>(_spill->RowCount(), til::CoordTypeMax)) : 0;
+}
+
+// Same as GetMarkRows(), but for the spilled rows. The returned rows are negative.
+std::vector<ScrollMark> TextBuffer::GetSpilledMarkRows() const
+{
+    std::vector<ScrollMark> marks;
+    if (_spill)
+    {
+        const auto total = _spill->RowCount();
+        const auto count = gsl::narrow_cast<uint64_t>(GetSpilledRowCount());
+        for (const auto& mark : _spill->Marks())
+        {
+            if (const auto distance = total - mark.row; distance <= count)
+            {
+                marks.emplace_back(-gsl::narrow_cast<til::CoordType>(distance), mark.data);
+            }
+        }
+    }
+    return marks;
+}
+
+// Reads the spilled rows [beg,end) back into a new TextBuffer, where they're located at [0,end-beg).
+// The new buffer is wide enough for all spilled rows, as they may predate a resize.
+std::unique_ptr<TextBuffer> TextBuffer::_unspill(til::CoordType beg, til::CoordType end) const
+{
+    assert(_spill && -GetSpilledRowCount() <= beg && beg < end && end <= 0 && end - beg <= _spillReadRowCount);
+
+    const auto total = _spill->RowCount();
+    AttributePalette palette;
+    const auto rows = _spill->Read(total - gsl::narrow_cast<uint64_t>(-beg), total - gsl::narrow_cast<uint64_t>(-end), palette);
+
+    const til::size size{ std::max(_width, _spill->MaxColumns()), end - beg };
+    auto buffer = std::make_unique<TextBuffer>(size, _initialAttributes, 0, false, nullptr);
+
+    til::CoordType y = 0;
+    for (const auto& packed : rows)
+    {
+        buffer->GetMutableRowByOffset(y++).Unpack(packed, palette);
+    }
+
+    return buffer;
+}
+
+// Searches the spilled rows [rowBeg,rowEnd) by reading them back in batches and appends the matches to `results`.
+// The batches are split at hard line breaks, so only regular expressions that match across
+// multiple lines may miss matches that cross a batch boundary.
+void TextBuffer::_searchSpilledText(const std::wstring_view& needle, SearchFlag flags, til::CoordType rowBeg, til::CoordType rowEnd, std::vector<til::point_span>& results) const
+{
+    for (auto beg = rowBeg; beg < rowEnd;)
+    {
+        const auto end = std::min(rowEnd - beg, _spillReadRowCount) + beg;
+        const auto buffer = _unspill(beg, end);
+        auto height = end - beg;
+
+        // Leave the trailing wrapped rows to the next batch, unless the entire batch is a single line.
+        if (end < rowEnd)
+        {
+            const auto h = buffer->GetLogicalLineStart(height);
+            if (h > 0)
+            {
+                height = h;
+            }
+        }
+
+        if (const auto matches = buffer->SearchText(needle, flags, 0, height))
+        {
+            for (auto match : *matches)
+            {
+                match.start.y += beg;
+                match.end.y += beg;
+                results.emplace_back(match);
+            }
+        }
+
+        beg += height;
+    }
+}
+
+// GetPlainText() for ranges that start in the spilled rows.
+std::wstring TextBuffer::_getSpilledPlainText(til::point start, const til::point end) const
+{
+    std::wstring text;
+
+    if (start.y < -GetSpilledRowCount())
+    {
+        start = { 0, -GetSpilledRowCount() };
+    }
+
+    for (auto beg = start.y; beg <= end.y && beg < 0; beg += _spillReadRowCount)
+    {
+        const auto last = std::min({ beg + _spillReadRowCount, end.y + 1, 0 });
+        const auto buffer = _unspill(beg, last);
+        const auto a = beg == start.y ? til::point{ start.x, 0 } : til::point{};
+        const auto b = last - 1 == end.y ? til::point{ end.x, last - 1 - beg } : til::point{ buffer->GetSize().RightInclusive(), last - 1 - beg };
+        text.append(buffer->GetPlainText(a, b));
+    }
+
+    if (end.y >= 0)
+    {
+        text.append(GetPlainText({}, end));
+    }
+
+    return text;
+}
+
 // Collect up all the rows that were marked, and the data marked on that row.
 // This is what should be used for hot paths, like updating the scrollbar.
 std::vector<ScrollMark> TextBuffer::GetMarkRows() const
 {
     std::vector<ScrollMark> marks;
-    const auto bottom = _estimateOffsetOfLastCommittedRow();
-    for (auto y = 0; y <= bottom; y++)
+    const auto end = _estimateOffsetOfLastCommittedRow() + 1;
+    for (auto y = _findNextMarkRow(0, end); y < end; y = _findNextMarkRow(y + 1, end))
     {
-        const auto& row = GetRowByOffset(y);
-        const auto& data{ row.GetScrollbarData() };
-        if (data.has_value())
+        // Packed rows have their own copy of the data. There's no need to decode them.
+        const auto packed = _getPackedRow(y);
+        const auto& data = packed ? packed->promptData : GetRowByOffset(y).GetScrollbarData();
+        if (!data)
         {
-            marks.emplace_back(y, *data);
+            continue;
         }
+        marks.emplace_back(y, *data);
     }
     return marks;
 }
@@ -3090,15 +4581,11 @@ std::vector<MarkExtents> TextBuffer::GetMarkExtents(size_t limit) const
     std::vector<MarkExtents> marks{};
     const auto bottom = _estimateOffsetOfLastCommittedRow();
     auto lastPromptY = bottom;
-    for (auto promptY = bottom; promptY >= 0; promptY--)
+    // Only visit the rows that started a prompt.
+    for (auto promptY = _findPrevMarkRow(bottom); promptY >= 0; promptY = _findPrevMarkRow(promptY - 1))
     {
         const auto& currRow = GetRowByOffset(promptY);
         auto& rowPromptData = currRow.GetScrollbarData();
-        if (!rowPromptData.has_value())
-        {
-            // This row didn't start a prompt, don't even look here.
-            continue;
-        }
 
         // Future thought! In #11000 & #14792, we considered the possibility of
         // scrolling to only an error mark, or something like that. Perhaps in
@@ -3317,23 +4804,16 @@ std::wstring TextBuffer::_commandForRow(const til::CoordType rowOffset,
 
 std::wstring TextBuffer::CurrentCommand() const
 {
-    auto promptY = GetCursor().GetPosition().y;
-    for (; promptY >= 0; promptY--)
+    const auto promptY = _findPrevMarkRow(GetCursor().GetPosition().y);
+    if (promptY < 0)
     {
-        const auto& currRow = GetRowByOffset(promptY);
-        auto& rowPromptData = currRow.GetScrollbarData();
-        if (!rowPromptData.has_value())
-        {
-            // This row didn't start a prompt, don't even look here.
-            continue;
-        }
-
-        // This row did start a prompt! Find the prompt that starts here.
-        // Presumably, no rows below us will have prompts, so pass in the last
-        // row with text as the bottom
-        return _commandForRow(promptY, _estimateOffsetOfLastCommittedRow(), true);
+        return L"";
     }
-    return L"";
+
+    // This row did start a prompt! Find the prompt that starts here.
+    // Presumably, no rows below us will have prompts, so pass in the last
+    // row with text as the bottom
+    return _commandForRow(promptY, _estimateOffsetOfLastCommittedRow(), true);
 }
 
 std::vector<std::wstring> TextBuffer::Commands() const
@@ -3341,16 +4821,9 @@ std::vector<std::wstring> TextBuffer::Commands() const
     std::vector<std::wstring> commands{};
     const auto bottom = _estimateOffsetOfLastCommittedRow();
     auto lastPromptY = bottom;
-    for (auto promptY = bottom; promptY >= 0; promptY--)
+    // Only visit the rows that started a prompt.
+    for (auto promptY = _findPrevMarkRow(bottom); promptY >= 0; promptY = _findPrevMarkRow(promptY - 1))
     {
-        const auto& currRow = GetRowByOffset(promptY);
-        auto& rowPromptData = currRow.GetScrollbarData();
-        if (!rowPromptData.has_value())
-        {
-            // This row didn't start a prompt, don't even look here.
-            continue;
-        }
-
         // This row did start a prompt! Find the prompt that starts here.
         // Presumably, no rows below us will have prompts, so pass in the last
         // row with text as the bottom
@@ -3438,15 +4911,10 @@ void TextBuffer::EndCurrentCommand(std::optional<unsigned int> error)
 {
     _currentAttributes.SetMarkAttributes(MarkKind::None);
 
-    for (auto y = GetCursor().GetPosition().y; y >= 0; y--)
+    const auto promptY = _findPrevMarkRow(GetCursor().GetPosition().y);
+    if (promptY >= 0)
     {
-        auto& currRow = GetMutableRowByOffset(y);
-        auto& rowPromptData = currRow.GetScrollbarData();
-        if (rowPromptData.has_value())
-        {
-            currRow.EndOutput(error);
-            return;
-        }
+        GetMutableRowByOffset(promptY).EndOutput(error);
     }
 }
 
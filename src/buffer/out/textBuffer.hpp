@@ -58,6 +58,8 @@ filling in the last row, and updating the screen.
 #include "../buffer/out/textBufferTextIterator.hpp"
 
 struct URegularExpression;
+class LiteralSearcher;
+class SpillLog;
 enum class SearchFlag : unsigned int;
 
 namespace Microsoft::Console::Render
@@ -123,6 +125,7 @@ public:
 
     // Scroll needs access to this to quickly rotate around the buffer.
     void IncrementCircularBuffer(const TextAttribute& fillAttributes = {});
+    void PackColdRows(const Microsoft::Console::Types::Viewport& viewport);
 
     til::point GetLastNonSpaceCharacter(const Microsoft::Console::Types::Viewport* viewOptional = nullptr) const;
 
@@ -130,6 +133,9 @@ public:
     const Cursor& GetCursor() const noexcept;
 
     uint64_t GetLastMutationId() const noexcept;
+    uint64_t GetCircularBufferRotations() const noexcept;
+    bool GetMutatedRowsSince(uint64_t mutationId, std::vector<til::CoordType>& rows) const;
+    til::CoordType EstimateOffsetOfLastCommittedRow() const noexcept;
     const til::CoordType GetFirstRowIndex() const noexcept;
 
     const Microsoft::Console::Types::Viewport GetSize() const noexcept;
@@ -144,6 +150,9 @@ public:
     void SetCurrentAttributes(const TextAttribute& currentAttributes) noexcept;
 
     void SetWrapForced(til::CoordType y, bool wrap);
+    bool WasWrapForced(til::CoordType y) const;
+    til::CoordType GetLogicalLineStart(til::CoordType y) const;
+    til::CoordType GetLogicalLineEnd(til::CoordType y) const;
     void SetCurrentLineRendition(const LineRendition lineRendition, const TextAttribute& fillAttributes);
     void ResetLineRenditionRange(const til::CoordType startRow, const til::CoordType endRow);
     LineRendition GetLineRendition(const til::CoordType row) const;
@@ -170,6 +179,8 @@ public:
     void TriggerScroll();
     void TriggerScroll(const til::point delta);
     void TriggerNewTextNotification(const std::wstring_view newText);
+    void TakeDamage(std::vector<til::rect>& rects);
+    void FlushDamage();
 
     til::point GetWordStart(const til::point target, const std::wstring_view wordDelimiters, bool accessibilityMode = false, std::optional<til::point> limitOptional = std::nullopt) const;
     til::point GetWordEnd(const til::point target, const std::wstring_view wordDelimiters, bool accessibilityMode = false, std::optional<til::point> limitOptional = std::nullopt) const;
@@ -288,11 +299,22 @@ public:
         til::CoordType visibleViewportTop{ 0 };
     };
 
-    static void Reflow(TextBuffer& oldBuffer, TextBuffer& newBuffer, const Microsoft::Console::Types::Viewport* lastCharacterViewport = nullptr, PositionInformation* positionInfo = nullptr);
+    static til::CoordType Reflow(TextBuffer& oldBuffer, TextBuffer& newBuffer, const Microsoft::Console::Types::Viewport* lastCharacterViewport = nullptr, PositionInformation* positionInfo = nullptr, til::CoordType oldBeg = 0, til::CoordType oldEnd = til::CoordTypeMax, til::CoordType newBeg = 0);
+    static til::CoordType GetLazyReflowStart(const TextBuffer& buffer, til::CoordType row);
+    static til::CoordType GetLazyReflowReserve(const TextBuffer& buffer, til::CoordType end, til::size newSize);
+    void DeferReflow(std::unique_ptr<TextBuffer> oldBuffer, til::CoordType end);
+    bool IsReflowPending() const noexcept;
+    til::CoordType ContinueReflow(til::CoordType rowBudget);
 
     std::optional<std::vector<til::point_span>> SearchText(const std::wstring_view& needle, SearchFlag flags) const;
     std::optional<std::vector<til::point_span>> SearchText(const std::wstring_view& needle, SearchFlag flags, til::CoordType rowBeg, til::CoordType rowEnd) const;
 
+    // Unbounded scrollback
+    void EnableSpill();
+    bool IsSpillEnabled() const noexcept;
+    til::CoordType GetSpilledRowCount() const noexcept;
+    std::vector<ScrollMark> GetSpilledMarkRows() const;
+
     // Mark handling
     std::vector<ScrollMark> GetMarkRows() const;
     std::vector<MarkExtents> GetMarkExtents(size_t limit = SIZE_T_MAX) const;
@@ -311,13 +333,32 @@ private:
     void _reserve(til::size screenBufferSize, const TextAttribute& defaultAttributes);
     void _commit(const std::byte* row);
     void _decommit() noexcept;
+    void _decommitFrom(til::CoordType y) noexcept;
+    void _invalidateMutationJournal() noexcept;
     void _construct(const std::byte* until) noexcept;
     void _destroy() const noexcept;
     ROW& _getRowByOffsetDirect(size_t offset);
-    ROW& _getRow(til::CoordType y) const;
+    const ROW& _getRow(til::CoordType y) const;
+    ROW& _getMutableRowAtOffset(size_t offset);
+    const ROW& _getDecodedRow(size_t offset) const;
+    const ROW& _getSpilledRow(til::CoordType y) const;
+    void _dropDecodedRows() noexcept;
     til::CoordType _estimateOffsetOfLastCommittedRow() const noexcept;
+    size_t _rowOffset(til::CoordType y) const noexcept;
+    bool _isPackedOffset(size_t offset) const noexcept;
+    const PackedRow* _getPackedRow(til::CoordType y) const noexcept;
+    bool _packChunk(size_t chunk);
+    void _unpackChunk(size_t chunk);
+    void _compactAttributePalette();
+    void _trackRowFlags(ROW& row, size_t offset) noexcept;
+    void _refreshRowFlags(size_t word) const;
+    uint64_t _getWrapWord(size_t word) const;
+    uint64_t _getMarkWord(size_t word) const;
+    til::CoordType _findNextMarkRow(til::CoordType y, til::CoordType end) const;
+    til::CoordType _findPrevMarkRow(til::CoordType y) const;
 
     void _SetFirstRowIndex(const til::CoordType FirstRowIndex) noexcept;
+    void _damageRow(til::CoordType row, til::CoordType begin, til::CoordType end);
     void _ExpandTextRow(til::inclusive_rect& selectionRow) const;
     DelimiterClass _GetDelimiterClassAt(const til::point pos, const std::wstring_view wordDelimiters) const;
     til::point _GetWordStartForAccessibility(const til::point target, const std::wstring_view wordDelimiters) const;
@@ -330,6 +371,15 @@ private:
     MarkExtents _scrollMarkExtentForRow(const til::CoordType rowOffset, const til::CoordType bottomInclusive) const;
     bool _createPromptMarkIfNeeded();
 
+    void _searchTextRange(URegularExpression* re, const LiteralSearcher* literal, const std::vector<std::pair<wchar_t, wchar_t>>& filter, SearchFlag flags, til::CoordType rowBeg, til::CoordType rowEnd, std::vector<til::point_span>& results) const;
+    void _searchTextParallel(URegularExpression* re, const LiteralSearcher* literal, const std::vector<std::pair<wchar_t, wchar_t>>& filter, SearchFlag flags, til::CoordType rowBeg, til::CoordType rowEnd, std::vector<til::point_span>& results) const;
+    static std::vector<std::pair<wchar_t, wchar_t>> _createSearchFilter(const std::wstring_view& needle, SearchFlag flags);
+    bool _mayContainSearchFilter(const std::vector<std::pair<wchar_t, wchar_t>>& filter, SearchFlag flags, til::CoordType rowBeg, til::CoordType rowEnd) const;
+    const RowSearchSummary& _getSearchSummary(til::CoordType y) const;
+    std::unique_ptr<TextBuffer> _unspill(til::CoordType beg, til::CoordType end) const;
+    void _searchSpilledText(const std::wstring_view& needle, SearchFlag flags, til::CoordType rowBeg, til::CoordType rowEnd, std::vector<til::point_span>& results) const;
+    std::wstring _getSpilledPlainText(til::point start, til::point end) const;
+
     std::tuple<til::CoordType, til::CoordType, bool> _RowCopyHelper(const CopyRequest& req, const til::CoordType iRow, const ROW& row) const;
 
     static void _AppendRTFText(std::string& contentBuilder, const std::wstring_view& text);
@@ -380,6 +430,23 @@ private:
     // There's probably a better metric than this. (This comment was written when ROW had both,
     // a _chars array containing text and a _charOffsets array contain column-to-text indices.)
     static constexpr size_t _commitReadAheadRowCount = 128;
+    // SearchText() splits ranges of at least 2x this many rows into shards and searches them on the thread pool.
+    // Below this, the overhead of waking up threads and cloning the regex isn't worth it.
+    static constexpr til::CoordType _searchShardMinRowCount = 2048;
+    // PackColdRows() packs rows that are at least this far away from the viewport and the cursor, in chunks of _packChunkRowCount
+    // consecutive ROWs in memory. A chunk is the unit in which it gets packed, MEM_DECOMMITed and unpacked again.
+    static constexpr til::CoordType _packMinDistance = 1024;
+    static constexpr size_t _packChunkRowCount = 64;
+    // Windows uses 4KiB pages on all architectures we support.
+    static constexpr uintptr_t _pageSize = 4096;
+    // PackColdRows() compacts _attributePalette once it has grown by this many entries (or doubled, whichever is more).
+    static constexpr size_t _attributePaletteMinGrowth = 4096;
+    // GetLazyReflowStart() defers the reflow of the rows more than this far above the viewport.
+    static constexpr til::CoordType _reflowEagerRowCount = 1024;
+    // Spilled rows are read back in batches of at most this many rows. See _unspill().
+    static constexpr til::CoordType _spillReadRowCount = 4096;
+    // _mutationJournal drops its older half once it has grown to this many entries.
+    static constexpr size_t _mutationJournalCapacity = 4096;
     // Before TextBuffer was made to use virtual memory it initialized the entire memory arena with the initial
     // attributes right away. To ensure it continues to work the way it used to, this stores these initial attributes.
     TextAttribute _initialAttributes;
@@ -400,6 +467,78 @@ private:
     TextAttribute _currentAttributes;
     til::CoordType _firstRow = 0; // indexes top row (not necessarily 0)
     uint64_t _lastMutationId = 0;
+    uint64_t _circularBufferRotations = 0;
+
+    // The rows that GetMutableRowByOffset() handed out, in the order of their _lastMutationId.
+    // Rows are stored as _circularBufferRotations + y, so that rotating the buffer doesn't invalidate them.
+    // See GetMutatedRowsSince(). It can't answer for mutation IDs before _mutationJournalFloor.
+    struct MutationJournalEntry
+    {
+        uint64_t mutationId = 0;
+        uint64_t row = 0;
+    };
+    std::vector<MutationJournalEntry> _mutationJournal;
+    uint64_t _mutationJournalFloor = 0;
+
+    // Indexed by (row offset - 1) / _packChunkRowCount. An empty vector means that the chunk isn't packed.
+    // Once a chunk is packed, its ROWs are destroyed and its memory is MEM_DECOMMITed, except for the
+    // pages it shares with its neighbors. GetMutableRowByOffset() unpacks the chunk of the row it returns.
+    std::vector<std::vector<PackedRow>> _packedChunks;
+    size_t _packedChunkCount = 0;
+    // The packed rows that GetRowByOffset() decoded, indexed by their row offset. See _getDecodedRow().
+    struct DecodedRow
+    {
+        DecodedRow(const PackedRow& packed, const AttributePalette& palette, uint16_t width, const TextAttribute& fillAttribute);
+
+        std::unique_ptr<wchar_t[]> chars;
+        std::unique_ptr<uint16_t[]> charOffsets;
+        ROW row;
+    };
+    mutable std::unordered_map<size_t, std::unique_ptr<DecodedRow>> _decodedRows;
+    // Same as _decodedRows, but for the spilled rows, indexed by their position in the _spill. See _getSpilledRow().
+    mutable std::unordered_map<uint64_t, std::unique_ptr<DecodedRow>> _decodedSpilledRows;
+    mutable std::mutex _decodedRowsLock;
+    // The attributes of the rows in _packedChunks. See AttributePalette.
+    AttributePalette _attributePalette;
+    size_t _attributePaletteCompactSize = _attributePaletteMinGrowth;
+    // Used by IncrementCircularBuffer() to append rows to the _spill that aren't packed yet.
+    AttributePalette _spillPalette;
+
+    // If set, rows evicted by IncrementCircularBuffer() are appended to this log. See EnableSpill().
+    std::unique_ptr<SpillLog> _spill;
+
+    // The rows [beg,end) of `source` still need to be reflowed into the rows [0,_reflowTop). See DeferReflow().
+    // The vector is ordered from the oldest to the newest rows and ContinueReflow() works from the back.
+    struct PendingReflow
+    {
+        std::unique_ptr<TextBuffer> source;
+        til::CoordType beg = 0;
+        til::CoordType end = 0;
+    };
+    std::vector<PendingReflow> _pendingReflow;
+    // The rows [0,_reflowTop) were left blank by Reflow() and are filled bottom-up by ContinueReflow().
+    til::CoordType _reflowTop = 0;
+
+    // A copy of every ROW's wrap flag and whether it has scrollbar data (a mark), with 1 bit per row,
+    // indexed by (row offset - 1) like _packedChunks. They allow GetLogicalLineStart/End() and the mark
+    // lookups to skip over 64 rows at a time without touching (and possibly decoding) the ROWs.
+    // Each ROW marks itself in _rowFlagsDirty when either of them changes (see _trackRowFlags()),
+    // and _refreshRowFlags() lazily reads them back from the ROW.
+    mutable std::vector<uint64_t> _wrapForced;
+    mutable std::vector<uint64_t> _hasMark;
+    mutable std::vector<uint64_t> _rowFlagsDirty;
+
+    // The columns [begin,end) of each row that were written to since the renderer last called TakeDamage().
+    // Both are indexed by the physical row (that is, not relative to _firstRow), so that rotating the
+    // circular buffer doesn't require touching them. Anything that changes the mapping in another
+    // way must call FlushDamage() first. A span with begin >= end is clean.
+    struct DamageSpan
+    {
+        til::CoordType begin = 0;
+        til::CoordType end = 0;
+    };
+    std::vector<DamageSpan> _damageSpans;
+    std::vector<til::CoordType> _damagedRows;
 
     Cursor _cursor;
     bool _isActiveBuffer = false;
@@ -61,4 +61,99 @@ class UTextAdapterTests
         actual = buffer.SearchText(L"ネコ", SearchFlag::None);
         VERIFY_ARE_EQUAL(expected, actual);
     }
+
+    TEST_METHOD(LiteralAcrossWrappedRows)
+    {
+        DummyRenderer renderer;
+        TextBuffer buffer{ til::size{ 8, 3 }, TextAttribute{}, 0, false, &renderer };
+
+        RowWriteState state{ .text = L"hello wo" };
+        buffer.Replace(0, TextAttribute{}, state);
+        buffer.SetWrapForced(0, true);
+        state = RowWriteState{ .text = L"rld" };
+        buffer.Replace(1, TextAttribute{}, state);
+        // U+212A KELVIN SIGN case-folds to "k".
+        state = RowWriteState{ .text = L"\u212Aey" };
+        buffer.Replace(2, TextAttribute{}, state);
+
+        auto expected = std::vector{ til::point_span{ { 6, 0 }, { 2, 1 } } };
+        auto actual = buffer.SearchText(L"world", SearchFlag::None);
+        VERIFY_ARE_EQUAL(expected, actual);
+
+        actual = buffer.SearchText(L"WORLD", SearchFlag::CaseInsensitive);
+        VERIFY_ARE_EQUAL(expected, actual);
+
+        expected = std::vector<til::point_span>{};
+        actual = buffer.SearchText(L"WORLD", SearchFlag::None);
+        VERIFY_ARE_EQUAL(expected, actual);
+
+        expected = std::vector{ til::point_span{ { 0, 2 }, { 2, 2 } } };
+        actual = buffer.SearchText(L"key", SearchFlag::CaseInsensitive);
+        VERIFY_ARE_EQUAL(expected, actual);
+
+        // Unwrapping the row must invalidate the cached summary.
+        buffer.SetWrapForced(0, false);
+        expected = std::vector<til::point_span>{};
+        actual = buffer.SearchText(L"world", SearchFlag::None);
+        VERIFY_ARE_EQUAL(expected, actual);
+    }
+
+    TEST_METHOD(ParallelAcrossWrappedRows)
+    {
+        // Large enough for SearchText() to split the range into shards.
+        static constexpr til::CoordType height = 9001;
+
+        DummyRenderer renderer;
+        TextBuffer buffer{ til::size{ 10, height }, TextAttribute{}, 0, false, &renderer };
+        std::vector<til::point_span> expected;
+
+        // Every match spans across a soft-wrapped row boundary, so a shard
+        // boundary in the wrong place would split some of them in two.
+        for (til::CoordType y = 0; y + 1 < height; y += 3)
+        {
+            RowWriteState state{ .text = L"xxxxxxxxab" };
+            buffer.Replace(y, TextAttribute{}, state);
+            buffer.SetWrapForced(y, true);
+            state = RowWriteState{ .text = L"cd" };
+            buffer.Replace(y + 1, TextAttribute{}, state);
+            expected.emplace_back(til::point{ 8, y }, til::point{ 1, y + 1 });
+        }
+
+        const auto actual = buffer.SearchText(L"abcd", SearchFlag::None);
+        VERIFY_ARE_EQUAL(expected, actual);
+
+        const auto actualInsensitive = buffer.SearchText(L"ABCD", SearchFlag::CaseInsensitive);
+        VERIFY_ARE_EQUAL(expected, actualInsensitive);
+    }
+
+    TEST_METHOD(LiteralMixedWithIcuFallback)
+    {
+        DummyRenderer renderer;
+        TextBuffer buffer{ til::size{ 8, 3 }, TextAttribute{}, 0, false, &renderer };
+
+        RowWriteState state{ .text = L"ネコ abc" };
+        buffer.Replace(0, TextAttribute{}, state);
+        // U+00DF case-folds to "ss", which the literal fast path can't handle.
+        // This row must be searched by ICU and its results must stay in order.
+        state = RowWriteState{ .text = L"\u00DF abc" };
+        buffer.Replace(1, TextAttribute{}, state);
+        state = RowWriteState{ .text = L"ABC abc" };
+        buffer.Replace(2, TextAttribute{}, state);
+
+        static constexpr auto s = [](til::CoordType y, til::CoordType beg, til::CoordType end) -> til::point_span {
+            return { { beg, y }, { end, y } };
+        };
+
+        auto expected = std::vector{ s(0, 5, 7), s(1, 2, 4), s(2, 0, 2), s(2, 4, 6) };
+        auto actual = buffer.SearchText(L"abc", SearchFlag::CaseInsensitive);
+        VERIFY_ARE_EQUAL(expected, actual);
+
+        expected = std::vector{ s(0, 5, 7), s(1, 2, 4), s(2, 4, 6) };
+        actual = buffer.SearchText(L"abc", SearchFlag::None);
+        VERIFY_ARE_EQUAL(expected, actual);
+
+        expected = std::vector{ s(0, 0, 3) };
+        actual = buffer.SearchText(L"ネコ", SearchFlag::CaseInsensitive);
+        VERIFY_ARE_EQUAL(expected, actual);
+    }
 };
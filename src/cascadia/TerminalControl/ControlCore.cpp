@@ -198,6 +198,7 @@ namespace winrt::Microsoft::Terminal::Control::implementation
                 {
                     const auto lock = t->LockForWriting();
                     t->UpdatePatternsUnderLock();
+                    t->PackColdRowsUnderLock();
                 }
             });
 
@@ -382,6 +383,8 @@ namespace winrt::Microsoft::Terminal::Control::implementation
 
             _terminal->CreateFromSettings(*_settings, *_renderer);
 
+            // Painting hasn't been enabled yet, so the engine can be set up without _renderer->LockEngines().
+            //
             // Tell the render engine to notify us when the swap chain changes.
             // We do this after we initially set the swapchain so as to avoid
             // unnecessary callbacks (and locking problems)
@@ -739,7 +742,10 @@ namespace winrt::Microsoft::Terminal::Control::implementation
         if (_renderEngine)
         {
             const auto lock = _terminal->LockForWriting();
-            _renderEngine->EnableTransparentBackground(_isBackgroundTransparent());
+            {
+                const auto engineLock = _renderer->LockEngines();
+                _renderEngine->EnableTransparentBackground(_isBackgroundTransparent());
+            }
             _renderer->NotifyPaintFrame();
         }
 
@@ -756,13 +762,16 @@ namespace winrt::Microsoft::Terminal::Control::implementation
         // specify a custom pixel shader, manually enable the legacy retro
         // effect first. This will ensure that a toggle off->on will still work,
         // even if they currently have retro effect off.
-        if (path.empty())
-        {
-            _renderEngine->SetRetroTerminalEffect(!_renderEngine->GetRetroTerminalEffect());
-        }
-        else
         {
-            _renderEngine->SetPixelShaderPath(_renderEngine->GetPixelShaderPath().empty() ? std::wstring_view{ path } : std::wstring_view{});
+            const auto engineLock = _renderer->LockEngines();
+            if (path.empty())
+            {
+                _renderEngine->SetRetroTerminalEffect(!_renderEngine->GetRetroTerminalEffect());
+            }
+            else
+            {
+                _renderEngine->SetPixelShaderPath(_renderEngine->GetPixelShaderPath().empty() ? std::wstring_view{ path } : std::wstring_view{});
+            }
         }
         // Always redraw after toggling effects. This way even if the control
         // does not have focus it will update immediately.
@@ -880,11 +889,14 @@ namespace winrt::Microsoft::Terminal::Control::implementation
             return;
         }
 
-        _renderEngine->SetGraphicsAPI(parseGraphicsAPI(_settings->GraphicsAPI()));
-        _renderEngine->SetDisablePartialInvalidation(_settings->DisablePartialInvalidation());
-        _renderEngine->SetSoftwareRendering(_settings->SoftwareRendering());
-        // Inform the renderer of our opacity
-        _renderEngine->EnableTransparentBackground(_isBackgroundTransparent());
+        {
+            const auto engineLock = _renderer->LockEngines();
+            _renderEngine->SetGraphicsAPI(parseGraphicsAPI(_settings->GraphicsAPI()));
+            _renderEngine->SetDisablePartialInvalidation(_settings->DisablePartialInvalidation());
+            _renderEngine->SetSoftwareRendering(_settings->SoftwareRendering());
+            // Inform the renderer of our opacity
+            _renderEngine->EnableTransparentBackground(_isBackgroundTransparent());
+        }
 
         // Trigger a redraw to repaint the window background and tab colors.
         _renderer->TriggerRedrawAll(true, true);
@@ -911,9 +923,12 @@ namespace winrt::Microsoft::Terminal::Control::implementation
         if (_renderEngine)
         {
             // Update AtlasEngine settings under the lock
-            _renderEngine->SetRetroTerminalEffect(newAppearance->RetroTerminalEffect());
-            _renderEngine->SetPixelShaderPath(newAppearance->PixelShaderPath());
-            _renderEngine->SetPixelShaderImagePath(newAppearance->PixelShaderImagePath());
+            {
+                const auto engineLock = _renderer->LockEngines();
+                _renderEngine->SetRetroTerminalEffect(newAppearance->RetroTerminalEffect());
+                _renderEngine->SetPixelShaderPath(newAppearance->PixelShaderPath());
+                _renderEngine->SetPixelShaderImagePath(newAppearance->PixelShaderImagePath());
+            }
 
             // Incase EnableUnfocusedAcrylic is disabled and Focused Acrylic is set to true,
             // the terminal should ignore the unfocused opacity from settings.
@@ -931,7 +946,10 @@ namespace winrt::Microsoft::Terminal::Control::implementation
 
             // Update the renderer as well. It might need to fall back from
             // cleartype -> grayscale if the BG is transparent / acrylic.
-            _renderEngine->EnableTransparentBackground(_isBackgroundTransparent());
+            {
+                const auto engineLock = _renderer->LockEngines();
+                _renderEngine->EnableTransparentBackground(_isBackgroundTransparent());
+            }
             _renderer->NotifyPaintFrame();
 
             auto eventArgs = winrt::make_self<TransparencyChangedEventArgs>(Opacity());
@@ -973,6 +991,7 @@ namespace winrt::Microsoft::Terminal::Control::implementation
             break;
         }
 
+        const auto engineLock = _renderer->LockEngines();
         _renderEngine->SetAntialiasingMode(mode);
     }
 
@@ -1013,6 +1032,7 @@ namespace winrt::Microsoft::Terminal::Control::implementation
 
             // TODO: MSFT:20895307 If the font doesn't exist, this doesn't
             //      actually fail. We need a way to gracefully fallback.
+            const auto engineLock = _renderer->LockEngines();
             LOG_IF_FAILED(_renderEngine->UpdateDpi(newDpi));
             LOG_IF_FAILED(_renderEngine->UpdateFont(_desiredFont, _actualFont, featureMap, axesMap));
         }
@@ -1109,7 +1129,10 @@ namespace winrt::Microsoft::Terminal::Control::implementation
         _terminal->ClearSelection();
 
         // Tell the dx engine that our window is now the new size.
-        THROW_IF_FAILED(_renderEngine->SetWindowSize({ cx, cy }));
+        {
+            const auto engineLock = _renderer->LockEngines();
+            THROW_IF_FAILED(_renderEngine->SetWindowSize({ cx, cy }));
+        }
 
         // Invalidate everything
         _renderer->TriggerRedrawAll();
@@ -1124,6 +1147,12 @@ namespace winrt::Microsoft::Terminal::Control::implementation
 
         _connection.Resize(vp.Height(), vp.Width());
 
+        const auto reflowGeneration = ++_reflowGeneration;
+        if (_terminal->IsReflowPending())
+        {
+            _continueReflow(reflowGeneration);
+        }
+
         // TermControl will call Search() once the OutputIdle even fires after 100ms.
         // Until then we need to hide the now-stale search results from the renderer.
         ClearSearch();
@@ -1726,9 +1755,18 @@ namespace winrt::Microsoft::Terminal::Control::implementation
 
             if (searchInvalidated)
             {
-                oldResults = _searcher.ExtractResults();
-                _searcher.Reset(*_terminal.get(), request.Text, flags, !request.GoForward);
+                // Only the viewport is searched right away, so that its highlights show up immediately,
+                // even if the scrollback is huge. The rest is searched by _continueSearch().
+                _searcher.ResetStreaming(*_terminal.get(), request.Text, flags, !request.GoForward);
                 _terminal->SetSearchHighlights(_searcher.Results());
+                // If the search was only updated in place, these are just the matches that were replaced.
+                oldResults = _searcher.TakeStaleResults();
+
+                const auto generation = ++_searchGeneration;
+                if (_searcher.IsStreaming())
+                {
+                    _continueSearch(generation);
+                }
             }
 
             if (!request.ResetOnly)
@@ -1766,9 +1804,119 @@ namespace winrt::Microsoft::Terminal::Control::implementation
         return _searcher.Results();
     }
 
+    // The scrollbar positions of buffer rows are offset by this much. See Terminal::GetSpilledRowCount().
+    til::CoordType ControlCore::SpilledRowCount() const
+    {
+        const auto lock = _terminal->LockForReading();
+        return _terminal->GetSpilledRowCount();
+    }
+
+    // Searches through the remainder of the buffer after Search() started a streaming search.
+    // The lock is only held for one chunk of rows at a time, so that the search doesn't block
+    // output processing and rendering. Every chunk updates the highlights and raises
+    // SearchResultsUpdated, so that the search box can show the running match count.
+    safe_void_coroutine ControlCore::_continueSearch(const uint64_t generation)
+    {
+        // Roughly 1ms worth of searching on a typical machine.
+        static constexpr til::CoordType rowBudget = 4096;
+
+        const auto weakThis{ get_weak() };
+        co_await winrt::resume_background();
+
+        for (;;)
+        {
+            const auto core = weakThis.get();
+            if (!core || core->_IsClosing())
+            {
+                co_return;
+            }
+
+            int32_t totalMatches = 0;
+            int32_t currentMatch = 0;
+            bool streaming = false;
+
+            {
+                const auto lock = core->_terminal->LockForWriting();
+
+                // A new search was started or the search was cleared in the meantime.
+                if (generation != core->_searchGeneration)
+                {
+                    co_return;
+                }
+
+                streaming = core->_searcher.StreamNext(rowBudget);
+
+                // The new highlights are a superset of the old ones (modulo rows that scrolled out of the buffer),
+                // except for the matches that got replaced when StreamNext() caught up on changes to the buffer.
+                core->_terminal->SetSearchHighlights(core->_searcher.Results());
+                core->_terminal->SetSearchHighlightFocused(gsl::narrow<size_t>(std::max<ptrdiff_t>(0, core->_searcher.CurrentMatch())));
+                core->_renderer->TriggerSearchHighlight(core->_searcher.TakeStaleResults());
+
+                if (const auto idx = core->_searcher.CurrentMatch(); idx >= 0)
+                {
+                    totalMatches = gsl::narrow<int32_t>(core->_searcher.Results().size());
+                    currentMatch = gsl::narrow<int32_t>(idx);
+                }
+            }
+
+            core->SearchResultsUpdated.raise(*core, winrt::make<SearchResultsUpdatedEventArgs>(totalMatches, currentMatch, !streaming));
+
+            if (!streaming)
+            {
+                co_return;
+            }
+        }
+    }
+
+    // Reflows the scrollback that UserResize() deferred, one chunk of rows at a time.
+    // Like _continueSearch() it only holds the lock for one chunk at a time.
+    safe_void_coroutine ControlCore::_continueReflow(const uint64_t generation)
+    {
+        static constexpr til::CoordType rowBudget = 1024;
+
+        const auto weakThis{ get_weak() };
+        co_await winrt::resume_background();
+
+        for (;;)
+        {
+            const auto core = weakThis.get();
+            if (!core || core->_IsClosing())
+            {
+                co_return;
+            }
+
+            const auto lock = core->_terminal->LockForWriting();
+
+            // Another resize happened in the meantime and started its own _continueReflow().
+            if (generation != core->_reflowGeneration)
+            {
+                co_return;
+            }
+
+            const auto pending = core->_terminal->ContinueReflow(rowBudget);
+
+            // Every chunk fills in rows that the search results and the patterns don't cover yet, and the last
+            // one may move all rows up. Refresh them right away, like outputIdle would, instead of after 100ms
+            // of inactivity. The search catches up on the changed rows via the buffer's mutation journal.
+            core->_terminal->UpdatePatternsUnderLock();
+            core->_dispatcher.TryEnqueue(DispatcherQueuePriority::Normal, [weakThis]() {
+                if (const auto self = weakThis.get(); self && !self->_IsClosing())
+                {
+                    self->OutputIdle.raise(*self, nullptr);
+                }
+            });
+
+            if (!pending)
+            {
+                co_return;
+            }
+        }
+    }
+
     void ControlCore::ClearSearch()
     {
         const auto lock = _terminal->LockForWriting();
+        ++_searchGeneration;
         _terminal->SetSearchHighlights({});
         _terminal->SetSearchHighlightFocused(0);
         _renderer->TriggerSearchHighlight(_searcher.Results());
@@ -2558,6 +2706,8 @@ namespace winrt::Microsoft::Terminal::Control::implementation
     {
         const auto lock = _terminal->LockForReading();
         const auto& markRows = _terminal->GetMarkRows();
+        // The scrollbar includes the rows that were spilled to disk. See Terminal::GetSpilledRowCount().
+        const auto spilledRowCount = _terminal->GetSpilledRowCount();
         std::vector<Control::ScrollMark> v;
 
         v.reserve(markRows.size());
@@ -2565,7 +2715,7 @@ namespace winrt::Microsoft::Terminal::Control::implementation
         for (const auto& mark : markRows)
         {
             v.emplace_back(
-                mark.row,
+                mark.row + spilledRowCount,
                 OptionalFromColor(_terminal->GetColorForMark(mark.data)));
         }
 
@@ -2604,7 +2754,14 @@ namespace winrt::Microsoft::Terminal::Control::implementation
     {
         const auto lock = _terminal->LockForWriting();
         const auto currentOffset = ScrollOffset();
-        const auto& marks{ _terminal->GetMarkExtents() };
+        auto marks{ _terminal->GetMarkExtents() };
+
+        // Like currentOffset, the marks need to be scrollbar positions. See Terminal::GetSpilledRowCount().
+        const auto spilledRowCount = _terminal->GetSpilledRowCount();
+        for (auto& mark : marks)
+        {
+            mark.start.y += spilledRowCount;
+        }
 
         std::optional<::MarkExtents> tgt;
 
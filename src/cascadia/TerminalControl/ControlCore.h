@@ -227,6 +227,7 @@ namespace winrt::Microsoft::Terminal::Control::implementation
 
         SearchResults Search(SearchRequest request);
         const std::vector<til::point_span>& SearchResultRows() const noexcept;
+        til::CoordType SpilledRowCount() const;
         void ClearSearch();
 
         void LeftClickOnTerminal(const til::point terminalPosition,
@@ -292,6 +293,7 @@ namespace winrt::Microsoft::Terminal::Control::implementation
         til::typed_event<IInspectable, Control::OpenHyperlinkEventArgs> OpenHyperlink;
         til::typed_event<IInspectable, Control::CompletionsChangedEventArgs> CompletionsChanged;
         til::typed_event<IInspectable, Control::SearchMissingCommandEventArgs> SearchMissingCommand;
+        til::typed_event<IInspectable, Control::SearchResultsUpdatedEventArgs> SearchResultsUpdated;
         til::typed_event<> RefreshQuickFixUI;
         til::typed_event<IInspectable, Control::WindowSizeChangedEventArgs> WindowSizeChanged;
 
@@ -330,6 +332,11 @@ namespace winrt::Microsoft::Terminal::Control::implementation
         std::unique_ptr<::Microsoft::Console::Render::Renderer> _renderer{ nullptr };
 
         ::Search _searcher;
+        // Incremented whenever a new search is started or the search is cleared,
+        // which cancels any _continueSearch() that is still running.
+        uint64_t _searchGeneration = 0;
+        // Incremented on every resize, which cancels any _continueReflow() that is still running.
+        uint64_t _reflowGeneration = 0;
         bool _snapSearchResultToSelection;
 
         winrt::handle _lastSwapChainHandle{ nullptr };
@@ -397,6 +404,9 @@ namespace winrt::Microsoft::Terminal::Control::implementation
 
 #pragma endregion
 
+        safe_void_coroutine _continueSearch(uint64_t generation);
+        safe_void_coroutine _continueReflow(uint64_t generation);
+
         MidiAudio _midiAudio;
         winrt::Windows::System::DispatcherQueueTimer _midiAudioSkipTimer{ nullptr };
 
@@ -19,4 +19,5 @@
 #include "CharSentEventArgs.g.cpp"
 #include "StringSentEventArgs.g.cpp"
 #include "SearchMissingCommandEventArgs.g.cpp"
+#include "SearchResultsUpdatedEventArgs.g.cpp"
 #include "WindowSizeChangedEventArgs.g.cpp"
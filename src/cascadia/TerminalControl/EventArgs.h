@@ -19,6 +19,7 @@
 #include "CharSentEventArgs.g.h"
 #include "StringSentEventArgs.g.h"
 #include "SearchMissingCommandEventArgs.g.h"
+#include "SearchResultsUpdatedEventArgs.g.h"
 #include "WindowSizeChangedEventArgs.g.h"
 
 namespace winrt::Microsoft::Terminal::Control::implementation
@@ -225,6 +226,19 @@ namespace winrt::Microsoft::Terminal::Control::implementation
         til::property<til::CoordType> BufferRow;
     };
 
+    struct SearchResultsUpdatedEventArgs : public SearchResultsUpdatedEventArgsT<SearchResultsUpdatedEventArgs>
+    {
+    public:
+        SearchResultsUpdatedEventArgs(int32_t totalMatches, int32_t currentMatch, bool complete) :
+            TotalMatches(totalMatches),
+            CurrentMatch(currentMatch),
+            Complete(complete) {}
+
+        til::property<int32_t> TotalMatches;
+        til::property<int32_t> CurrentMatch;
+        til::property<bool> Complete;
+    };
+
     struct WindowSizeChangedEventArgs : public WindowSizeChangedEventArgsT<WindowSizeChangedEventArgs>
     {
     public:
@@ -350,7 +350,10 @@ HRESULT HwndTerminal::Refresh(const til::size windowSize, _Out_ til::size* dimen
 
     _terminal->ClearSelection();
 
-    RETURN_IF_FAILED(_renderEngine->SetWindowSize(windowSize));
+    {
+        const auto engineLock = _renderer->LockEngines();
+        RETURN_IF_FAILED(_renderEngine->SetWindowSize(windowSize));
+    }
 
     // Invalidate everything
     _renderer->TriggerRedrawAll();
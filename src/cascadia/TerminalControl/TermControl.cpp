@@ -208,6 +208,7 @@ namespace winrt::Microsoft::Terminal::Control::implementation
         _revokers.RaiseNotice = _core.RaiseNotice(winrt::auto_revoke, { get_weak(), &TermControl::_coreRaisedNotice });
         _revokers.HoveredHyperlinkChanged = _core.HoveredHyperlinkChanged(winrt::auto_revoke, { get_weak(), &TermControl::_hoveredHyperlinkChanged });
         _revokers.OutputIdle = _core.OutputIdle(winrt::auto_revoke, { get_weak(), &TermControl::_coreOutputIdle });
+        _revokers.SearchResultsUpdated = _core.SearchResultsUpdated(winrt::auto_revoke, { get_weak(), &TermControl::_coreSearchResultsUpdated });
         _revokers.UpdateSelectionMarkers = _core.UpdateSelectionMarkers(winrt::auto_revoke, { get_weak(), &TermControl::_updateSelectionMarkers });
         _revokers.coreOpenHyperlink = _core.OpenHyperlink(winrt::auto_revoke, { get_weak(), &TermControl::_HyperlinkHandler });
         _revokers.interactivityOpenHyperlink = _interactivity.OpenHyperlink(winrt::auto_revoke, { get_weak(), &TermControl::_HyperlinkHandler });
@@ -535,6 +536,7 @@ namespace winrt::Microsoft::Terminal::Control::implementation
             {
                 const auto core = winrt::get_self<ControlCore>(_core);
                 const auto& searchMatches = core->SearchResultRows();
+                const auto spilledRowCount = core->SpilledRowCount();
                 const auto color = core->ForegroundColor();
                 const auto rightAlignedOffset = (scrollBarWidthInPx - pipWidth) * sizeof(til::color);
                 til::CoordType lastRow = til::CoordTypeMin;
@@ -544,7 +546,7 @@ namespace winrt::Microsoft::Terminal::Control::implementation
                     if (lastRow != span.start.y)
                     {
                         lastRow = span.start.y;
-                        const auto base = dataAt(lastRow) + rightAlignedOffset;
+                        const auto base = dataAt(lastRow + spilledRowCount) + rightAlignedOffset;
                         drawPip(base, color);
                     }
                 }
@@ -3911,6 +3913,24 @@ namespace winrt::Microsoft::Terminal::Control::implementation
         }
     }
 
+    // Called from a background thread while the core is still searching through the buffer.
+    safe_void_coroutine TermControl::_coreSearchResultsUpdated(IInspectable /*sender*/, Control::SearchResultsUpdatedEventArgs args)
+    {
+        const auto weakThis{ get_weak() };
+        co_await wil::resume_foreground(Dispatcher());
+
+        if (const auto self = weakThis.get(); self && !self->_IsClosing() && self->_searchBox && self->_searchBox->IsOpen())
+        {
+            self->_handleSearchResults({
+                .TotalMatches = args.TotalMatches(),
+                .CurrentMatch = args.CurrentMatch(),
+                // The scrollbar marks and the announcement are only updated once the results are complete.
+                .SearchInvalidated = args.Complete(),
+                .SearchRegexInvalid = false,
+            });
+        }
+    }
+
     void TermControl::_coreOutputIdle(const IInspectable& /*sender*/, const IInspectable& /*args*/)
     {
         _refreshSearch();
@@ -421,6 +421,7 @@ namespace winrt::Microsoft::Terminal::Control::implementation
         void _CloseSearchBoxControl(const winrt::Windows::Foundation::IInspectable& sender, const Windows::UI::Xaml::RoutedEventArgs& args);
         void _refreshSearch();
         void _handleSearchResults(SearchResults results);
+        safe_void_coroutine _coreSearchResultsUpdated(IInspectable sender, Control::SearchResultsUpdatedEventArgs args);
 
         void _hoveredHyperlinkChanged(const IInspectable& sender, const IInspectable& args);
         safe_void_coroutine _updateSelectionMarkers(IInspectable sender, Control::UpdateSelectionMarkersEventArgs args);
@@ -473,6 +474,7 @@ namespace winrt::Microsoft::Terminal::Control::implementation
             Control::ControlCore::CompletionsChanged_revoker CompletionsChanged;
             Control::ControlCore::RestartTerminalRequested_revoker RestartTerminalRequested;
             Control::ControlCore::SearchMissingCommand_revoker SearchMissingCommand;
+            Control::ControlCore::SearchResultsUpdated_revoker SearchResultsUpdated;
             Control::ControlCore::RefreshQuickFixUI_revoker RefreshQuickFixUI;
             Control::ControlCore::WindowSizeChanged_revoker WindowSizeChanged;
 
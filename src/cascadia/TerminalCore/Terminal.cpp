@@ -65,8 +65,14 @@ void Terminal::CreateFromSettings(ICoreSettings settings,
     const til::size viewportSize{ Utils::ClampToShortMax(settings.InitialCols(), 1),
                                   Utils::ClampToShortMax(settings.InitialRows(), 1) };
 
-    // TODO:MSFT:20642297 - Support infinite scrollback here, if HistorySize is -1
-    Create(viewportSize, Utils::ClampToShortMax(settings.HistorySize(), 0), renderer);
+    // A negative HistorySize requests unbounded scrollback. The buffer is made as large as it can be
+    // and the rows it evicts are spilled to disk, from where SearchText() etc. can still read them.
+    const auto historySize = settings.HistorySize();
+    Create(viewportSize, historySize < 0 ? SHRT_MAX : Utils::ClampToShortMax(historySize, 0), renderer);
+    if (historySize < 0)
+    {
+        _mainBuffer->EnableSpill();
+    }
 
     UpdateSettings(settings);
 }
@@ -299,7 +305,12 @@ try
         .visibleViewportTop = _VisibleStartIndex(),
     };
 
-    TextBuffer::Reflow(*_mainBuffer.get(), *newTextBuffer.get(), &_mutableViewport, &positionInfo);
+    // Reflowing a large scrollback takes a while. Only the rows around the viewport are reflowed now,
+    // so that resizing the window remains responsive. The rest is handled by ContinueReflow(),
+    // which fills the rows that are left blank at the top of the new buffer for that purpose.
+    const auto reflowStart = TextBuffer::GetLazyReflowStart(*_mainBuffer, std::min(positionInfo.mutableViewportTop, positionInfo.visibleViewportTop));
+    const auto reflowReserve = TextBuffer::GetLazyReflowReserve(*_mainBuffer, reflowStart, bufferSize);
+    TextBuffer::Reflow(*_mainBuffer.get(), *newTextBuffer.get(), &_mutableViewport, &positionInfo, reflowStart, til::CoordTypeMax, reflowReserve);
 
     // Restore the active text attributes
     newTextBuffer->SetCurrentAttributes(_mainBuffer->GetCurrentAttributes());
@@ -407,6 +418,10 @@ try
     _mutableViewport = Viewport::FromDimensions({ 0, proposedTop }, viewportSize);
 
     _mainBuffer.swap(newTextBuffer);
+    if (reflowStart > 0 || newTextBuffer->IsReflowPending())
+    {
+        _mainBuffer->DeferReflow(std::move(newTextBuffer), reflowStart);
+    }
 
     // GH#3494: Maintain scrollbar position during resize
     // Make sure that we don't scroll past the mutableViewport at the bottom of the buffer
@@ -429,6 +444,65 @@ void Terminal::Write(std::wstring_view stringView)
     _stateMachine->ProcessString(stringView);
 }
 
+// Returns true if UserResize() left parts of the scrollback to be reflowed by ContinueReflow().
+bool Terminal::IsReflowPending() const noexcept
+{
+    return _mainBuffer && _mainBuffer->IsReflowPending();
+}
+
+// Method Description:
+// - Reflows roughly rowBudget more rows of the scrollback that UserResize() deferred.
+//   They fill the blank rows UserResize() left at the top of the buffer, so nothing moves,
+//   except once it's done: The rows that remained blank are then removed, which moves
+//   the viewport, the selection and everything else up accordingly.
+// Return Value:
+// - true if there's more work left to do.
+bool Terminal::ContinueReflow(til::CoordType rowBudget)
+{
+    _assertLocked();
+
+    const auto removed = _mainBuffer->ContinueReflow(rowBudget);
+    if (removed > 0)
+    {
+        _mutableViewport = Viewport::FromDimensions({ 0, std::max(0, _mutableViewport.Top() - removed) }, _mutableViewport.Dimensions());
+
+        // While the alt buffer is active, the selection and the search belong to it.
+        if (!_inAltBuffer())
+        {
+            if (_selection->active)
+            {
+                auto selection{ _selection.write() };
+                wil::hide_name _selection;
+                // Same as in NotifyBufferRotation(). The spilled rows don't move, but they aren't selectable either.
+                if (selection->end.y < removed)
+                {
+                    selection->active = false;
+                }
+                else
+                {
+                    const auto pivotWasStart = selection->start == selection->pivot;
+                    selection->start.y = std::max(selection->start.y - removed, 0);
+                    selection->end.y = std::max(selection->end.y - removed, 0);
+                    selection->pivot = pivotWasStart ? selection->start : selection->end;
+                }
+            }
+
+            // The highlights are outdated now. The caller refreshes the search afterwards.
+            _searchHighlights.clear();
+            _searchHighlightFocused = 0;
+            _patternIntervalTree = {};
+        }
+    }
+
+    if (!_inAltBuffer())
+    {
+        _mainBuffer->TriggerRedrawAll();
+        _NotifyScrollEvent();
+    }
+
+    return _mainBuffer->IsReflowPending();
+}
+
 // Method Description:
 // - Attempts to snap to the bottom of the buffer, if SnapOnInput is true. Does
 //   nothing if SnapOnInput is set to false, or we're already at the bottom of
@@ -981,7 +1055,15 @@ Viewport Terminal::_GetMutableViewport() const noexcept
 
 til::CoordType Terminal::GetBufferHeight() const noexcept
 {
-    return _GetMutableViewport().BottomExclusive();
+    return _GetMutableViewport().BottomExclusive() + GetSpilledRowCount();
+}
+
+// Returns the number of rows above row 0 that were spilled to disk. See TextBuffer::EnableSpill().
+// The scrollbar includes them, which is why the scrollbar positions that GetScrollOffset(),
+// GetBufferHeight(), UserScrollViewport() etc. deal with are offset by this much from buffer rows.
+til::CoordType Terminal::GetSpilledRowCount() const noexcept
+{
+    return _inAltBuffer() || !_mainBuffer ? 0 : _mainBuffer->GetSpilledRowCount();
 }
 
 // ViewStartIndex is also the length of the scrollback
@@ -1022,12 +1104,12 @@ const TerminalInput& Terminal::_getTerminalInput() const noexcept
 // _VisibleStartIndex is the first visible line of the buffer
 int Terminal::_VisibleStartIndex() const noexcept
 {
-    return _inAltBuffer() ? 0 : std::max(0, _mutableViewport.Top() - _scrollOffset);
+    return _inAltBuffer() ? 0 : std::max(-GetSpilledRowCount(), _mutableViewport.Top() - _scrollOffset);
 }
 
 int Terminal::_VisibleEndIndex() const noexcept
 {
-    return _inAltBuffer() ? _altBufferSize.height - 1 : std::max(0, _mutableViewport.BottomInclusive() - _scrollOffset);
+    return _inAltBuffer() ? _altBufferSize.height - 1 : std::max(-GetSpilledRowCount(), _mutableViewport.BottomInclusive() - _scrollOffset);
 }
 
 Viewport Terminal::_GetVisibleViewport() const noexcept
@@ -1050,7 +1132,7 @@ void Terminal::_PreserveUserScrollOffset(const int viewportDelta) noexcept
     // by the same amount that we've just moved down.
     if (viewportDelta > 0 && (IsSelectionActive() || _scrollOffset != 0))
     {
-        const auto maxScrollOffset = _activeBuffer().GetSize().Height() - _mutableViewport.Height();
+        const auto maxScrollOffset = _activeBuffer().GetSize().Height() - _mutableViewport.Height() + GetSpilledRowCount();
         _scrollOffset = std::min(_scrollOffset + viewportDelta, maxScrollOffset);
     }
 }
@@ -1065,7 +1147,8 @@ void Terminal::UserScrollViewport(const int viewTop)
         return;
     }
 
-    const auto clampedNewTop = std::max(0, viewTop);
+    // viewTop is a scrollbar position. See GetSpilledRowCount().
+    const auto clampedNewTop = std::max(0, viewTop) - GetSpilledRowCount();
     const auto realTop = ViewStartIndex();
     const auto newDelta = realTop - clampedNewTop;
     // if viewTop > realTop, we want the offset to be 0.
@@ -1080,7 +1163,7 @@ void Terminal::UserScrollViewport(const int viewTop)
 
 int Terminal::GetScrollOffset() noexcept
 {
-    return _VisibleStartIndex();
+    return _VisibleStartIndex() + GetSpilledRowCount();
 }
 
 void Terminal::_NotifyScrollEvent()
@@ -1091,7 +1174,7 @@ void Terminal::_NotifyScrollEvent()
     if (_pfnScrollPositionChanged)
     {
         const auto visible = _GetVisibleViewport();
-        const auto top = visible.Top();
+        const auto top = visible.Top() + GetSpilledRowCount();
         const auto height = visible.Height();
         const auto bottom = this->GetBufferHeight();
         _pfnScrollPositionChanged(top, height, bottom);
@@ -1193,6 +1276,17 @@ void Terminal::UpdatePatternsUnderLock()
     _InvalidatePatternTree();
 }
 
+// Method Description:
+// - Packs the scrollback rows that are far away from the viewport. See TextBuffer::PackColdRows().
+// - This is called by TerminalControl (through a throttled function) once the output is idle,
+//   because it invalidates any ROW references into the buffer.
+// - INVARIANT: this function can only be called if the caller has the writing lock on the terminal
+void Terminal::PackColdRowsUnderLock()
+{
+    // The alt buffer has no scrollback, but the main buffer keeps its scrollback while it's inactive.
+    _mainBuffer->PackColdRows(_inAltBuffer() ? _mutableViewport : _GetVisibleViewport());
+}
+
 // Method Description:
 // - Clears and invalidates the interval pattern tree
 // - This is called to prevent the renderer from rendering patterns while the
@@ -1448,7 +1542,14 @@ PointTree Terminal::_getPatterns(til::CoordType beg, til::CoordType end) const
         return {};
     }
 
-    auto text = ICU::UTextFromTextBuffer(_activeBuffer(), beg, end + 1);
+    // A URL may continue past the given rows if they're part of a longer logical line, so search all of it.
+    // This is limited to as many rows as were given on either side, so that a huge logical line doesn't make this slow.
+    const auto& buffer = _activeBuffer();
+    const auto height = end - beg + 1;
+    const auto lineBeg = std::max(buffer.GetLogicalLineStart(beg), beg - height);
+    const auto lineEnd = std::min(buffer.GetLogicalLineEnd(end), end + 1 + height);
+
+    auto text = ICU::UTextFromTextBuffer(buffer, lineBeg, lineEnd);
     UErrorCode status = U_ZERO_ERROR;
     PointTree::interval_vector intervals;
 
@@ -1522,7 +1623,16 @@ std::vector<ScrollMark> Terminal::GetMarkRows() const
 {
     // We want to return _no_ marks when we're in the alt buffer, to effectively
     // hide them.
-    return _inAltBuffer() ? std::vector<ScrollMark>{} : _activeBuffer().GetMarkRows();
+    if (_inAltBuffer())
+    {
+        return {};
+    }
+
+    // The marks of the spilled rows have negative rows and come first.
+    auto marks = _mainBuffer->GetSpilledMarkRows();
+    const auto rows = _mainBuffer->GetMarkRows();
+    marks.insert(marks.end(), rows.begin(), rows.end());
+    return marks;
 }
 std::vector<MarkExtents> Terminal::GetMarkExtents() const
 {
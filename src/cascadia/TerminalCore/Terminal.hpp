@@ -103,6 +103,9 @@ public:
     // Write comes from the PTY and goes to our parser to be stored in the output buffer
     void Write(std::wstring_view stringView);
 
+    bool IsReflowPending() const noexcept;
+    bool ContinueReflow(til::CoordType rowBudget);
+
     void _assertLocked() const noexcept;
     void _assertUnlocked() const noexcept;
     [[nodiscard]] std::unique_lock<til::recursive_ticket_lock> LockForReading() const noexcept;
@@ -110,6 +113,7 @@ public:
     til::recursive_ticket_lock_suspension SuspendLock() noexcept;
 
     til::CoordType GetBufferHeight() const noexcept;
+    til::CoordType GetSpilledRowCount() const noexcept;
 
     int ViewStartIndex() const noexcept;
     int ViewEndIndex() const noexcept;
@@ -243,6 +247,7 @@ public:
     void SetCursorOn(const bool isOn) noexcept;
 
     void UpdatePatternsUnderLock();
+    void PackColdRowsUnderLock();
 
     const std::optional<til::color> GetTabColor() const;
 
@@ -154,6 +154,13 @@ DoBlinkingRenditionAndScroll:
 
 DoScroll:
     Scrolling::s_ScrollIfNecessary(ScreenInfo);
+
+    // This runs outside of any write, which makes it a safe time to pack the scrollback.
+    try
+    {
+        buffer.PackColdRows(ScreenInfo.GetViewport());
+    }
+    CATCH_LOG();
 }
 
 // Routine Description:
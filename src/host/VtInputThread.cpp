@@ -59,12 +59,20 @@ void VtInputThread::_InputThread()
     OVERLAPPED overlappedBuf{};
     wil::unique_event overlappedEvent;
     bool overlappedPending = false;
-    char buffer[4096];
+    std::unique_ptr<char[]> buffer;
+    DWORD capacity = 0;
     DWORD read = 0;
 
     til::u8state u8State;
     std::wstring wstr;
 
+    // Most of the time the input consists of a few keystrokes, but when the user pastes a lot of text
+    // or pipes a file into the pty, a single ReadFile() can return a lot more. The read size adapts to
+    // that: It doubles whenever a read fills the buffer and halves again when reads get small.
+    static constexpr DWORD minReadSize = 4 * 1024;
+    static constexpr DWORD maxReadSize = 256 * 1024;
+    DWORD readSize = minReadSize;
+
     if (Utils::HandleWantsOverlappedIo(_hFile.get()))
     {
         overlappedEvent.reset(CreateEventExW(nullptr, nullptr, CREATE_EVENT_MANUAL_RESET, EVENT_ALL_ACCESS));
@@ -81,12 +89,19 @@ void VtInputThread::_InputThread()
     // previous string, and finally converts the previous read to the next string.
     for (;;)
     {
+        // The previous read has already been converted into `wstr`, so the buffer is free to be replaced.
+        if (capacity != readSize)
+        {
+            buffer = std::make_unique_for_overwrite<char[]>(readSize);
+            capacity = readSize;
+        }
+
         // When we have a `wstr` that's ready for processing we must do so without blocking.
         // Otherwise, whatever the user typed will be delayed until the next IO operation.
         // With overlapped IO that's not a problem because the ReadFile() calls won't block.
         if (overlapped)
         {
-            if (!ReadFile(_hFile.get(), &buffer[0], sizeof(buffer), &read, overlapped))
+            if (!ReadFile(_hFile.get(), buffer.get(), readSize, &read, overlapped))
             {
                 if (GetLastError() != ERROR_IO_PENDING)
                 {
@@ -110,6 +125,8 @@ void VtInputThread::_InputThread()
                 //      that won't happen for 60s
                 LockConsole();
                 const auto unlock = wil::scope_exit([&] { UnlockConsole(); });
+                // Output in response to input, like the echo of a cooked read, shouldn't be held back.
+                const auto flush = ServiceLocator::LocateGlobals().getConsoleInformation().GetVtIo()->FlushImmediately();
 
                 _pInputStateMachine->ProcessString(wstr);
             }
@@ -133,7 +150,7 @@ void VtInputThread::_InputThread()
         }
         else
         {
-            if (!ReadFile(_hFile.get(), &buffer[0], sizeof(buffer), &read, overlapped))
+            if (!ReadFile(_hFile.get(), buffer.get(), readSize, &read, overlapped))
             {
                 break;
             }
@@ -151,12 +168,21 @@ void VtInputThread::_InputThread()
         TraceLoggingWrite(
             g_hConhostV2EventTraceProvider,
             "ConPTY ReadFile",
-            TraceLoggingCountedUtf8String(&buffer[0], read, "buffer"),
+            TraceLoggingCountedUtf8String(buffer.get(), read, "buffer"),
             TraceLoggingLevel(WINEVENT_LEVEL_VERBOSE),
             TraceLoggingKeyword(TIL_KEYWORD_TRACE));
 
+        if (read == readSize)
+        {
+            readSize = std::min(readSize * 2, maxReadSize);
+        }
+        else if (read < readSize / 16)
+        {
+            readSize = std::max(readSize / 2, minReadSize);
+        }
+
         // If we hit a parsing error, eat it. It's bad utf-8, we can't do anything with it.
-        FAILED_LOG(til::u8u16({ &buffer[0], gsl::narrow_cast<size_t>(read) }, wstr, u8State));
+        FAILED_LOG(til::u8u16({ buffer.get(), gsl::narrow_cast<size_t>(read) }, wstr, u8State));
     }
 }
 
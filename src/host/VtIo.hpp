@@ -52,6 +52,20 @@ namespace Microsoft::Console::VirtualTerminal
 
         friend struct Writer;
 
+        // Output is held back until either of the limits is reached, so that bursts of
+        // small writes result in fewer WriteFile calls. A maxLatency of 0 disables this.
+        struct FlushPolicy
+        {
+            size_t minBytes = 0;
+            std::chrono::milliseconds maxLatency{};
+        };
+
+        struct WriteStats
+        {
+            uint64_t writes = 0;
+            uint64_t bytes = 0;
+        };
+
         static void FormatAttributes(std::string& target, const TextAttribute& attributes);
         static void FormatAttributes(std::wstring& target, const TextAttribute& attributes);
         static wchar_t SanitizeUCS2(wchar_t ch);
@@ -68,11 +82,32 @@ namespace Microsoft::Console::VirtualTerminal
         void SendCloseEvent();
         void CreatePseudoWindow();
 
+        void SetFlushPolicy(const FlushPolicy& policy);
+        void Flush() noexcept;
+        WriteStats GetWriteStats() const noexcept;
+
+        // While the returned object is alive, output is flushed as soon as it's written.
+        // This is used while processing input, so that echoed input isn't delayed.
+        [[nodiscard]] auto FlushImmediately() noexcept
+        {
+            _flushImmediately = true;
+            return wil::scope_exit([this]() noexcept {
+                _flushImmediately = false;
+                Flush();
+            });
+        }
+
     private:
         [[nodiscard]] HRESULT _Initialize(const HANDLE InHandle, const HANDLE OutHandle, _In_opt_ const HANDLE SignalHandle);
 
+        static void CALLBACK s_flushTimerCallback(PTP_CALLBACK_INSTANCE instance, PVOID context, PTP_TIMER timer) noexcept;
+
         void _uncork();
+        void _finishBatch();
+        bool _shouldFlush() const noexcept;
+        void _scheduleFlush() noexcept;
         void _flushNow();
+        void _reportWriteStats();
 
         // After CreateIoHandlers is called, these will be invalid.
         wil::unique_hfile _hInput;
@@ -95,6 +130,18 @@ namespace Microsoft::Console::VirtualTerminal
         bool _overlappedPending = false;
         bool _writerRestoreCursor = false;
         bool _writerTainted = false;
+        // The size of _back when the outermost Writer was created.
+        size_t _batchStart = 0;
+
+        FlushPolicy _flushPolicy;
+        wil::unique_threadpool_timer_nowait _flushTimer;
+        std::chrono::steady_clock::time_point _flushScheduledAt;
+        bool _flushScheduled = false;
+        bool _flushImmediately = false;
+
+        WriteStats _writeStats;
+        WriteStats _writeStatsReported;
+        std::chrono::steady_clock::time_point _writeStatsReportedAt;
 
         bool _initialized = false;
         bool _lookingForCursorPosition = false;
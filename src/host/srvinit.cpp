@@ -259,6 +259,9 @@ static bool s_IsOnDesktop()
     const auto fRecomputeOwner = ProcessData->fRootProcess;
     gci.ProcessHandleList.FreeProcessData(ProcessData);
 
+    // The client may have just written its last output. We might exit soon, so don't hold it back.
+    gci.GetVtIo()->Flush();
+
     if (fRecomputeOwner)
     {
         auto pWindow = ServiceLocator::LocateConsoleWindow();
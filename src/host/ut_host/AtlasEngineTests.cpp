@@ -0,0 +1,185 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+#include "WexTestClass.h"
+#include "../../inc/consoletaeftemplates.hpp"
+
+#if TIL_FEATURE_CONHOSTATLASENGINE_ENABLED
+
+#include "../../renderer/atlas/AtlasEngine.h"
+
+using namespace WEX::Common;
+using namespace WEX::Logging;
+using namespace WEX::TestExecution;
+using namespace Microsoft::Console::Render;
+
+// The caches in AtlasEngine hold glyph indices, advances and font faces, all of which
+// depend on the font. These tests make sure that they don't survive a font change.
+class AtlasEngineTests
+{
+    TEST_CLASS(AtlasEngineTests);
+
+    TEST_METHOD(ShapedRowCacheHitsUnchangedText);
+    TEST_METHOD(ShapedRowCacheClearedOnFontChange);
+    TEST_METHOD(ShapedRowCacheClearedOnDpiChange);
+    TEST_METHOD(FontFallbackCacheClearedOnFontChange);
+    TEST_METHOD(GlyphAtlasResetOnFontChange);
+
+private:
+    static constexpr std::wstring_view text{ L"Hello, World!" };
+
+    static std::unique_ptr<AtlasEngine> _createEngine(const float fontSize)
+    {
+        auto engine = std::make_unique<AtlasEngine>();
+        VERIFY_SUCCEEDED(engine->SetWindowSize({ 800, 600 }));
+        VERIFY_SUCCEEDED(engine->UpdateDpi(USER_DEFAULT_SCREEN_DPI));
+        VERIFY_SUCCEEDED(engine->UpdateViewport({ 0, 0, 79, 24 }));
+        _updateFont(*engine, fontSize);
+        return engine;
+    }
+
+    static void _updateFont(AtlasEngine& engine, const float fontSize)
+    {
+        const FontInfoDesired fontInfoDesired{ L"Consolas", 0, FW_NORMAL, fontSize, CP_UTF8 };
+        FontInfo fontInfo{ L"Consolas", 0, FW_NORMAL, { 0, 0 }, CP_UTF8 };
+        VERIFY_SUCCEEDED(engine.UpdateFont(fontInfoDesired, fontInfo));
+    }
+
+    // Runs the parts of a frame that shape text. None of them require a graphics device.
+    static void _paintFrame(AtlasEngine& engine)
+    {
+        std::vector<Cluster> clusters;
+        for (size_t i = 0; i < text.size(); ++i)
+        {
+            clusters.emplace_back(text.substr(i, 1), 1);
+        }
+
+        VERIFY_SUCCEEDED(engine.StartPaint());
+        VERIFY_SUCCEEDED(engine.PaintBufferLine(clusters, { 0, 0 }, false, false));
+        VERIFY_SUCCEEDED(engine.EndPaint());
+    }
+};
+
+void AtlasEngineTests::ShapedRowCacheHitsUnchangedText()
+{
+    const auto engine = _createEngine(12.0f);
+
+    _paintFrame(*engine);
+    auto stats = engine->GetShapedRowCacheStats();
+    VERIFY_ARE_EQUAL(0ull, stats.hits);
+    VERIFY_ARE_EQUAL(1ull, stats.misses);
+
+    Log::Comment(L"Painting the same text again should reuse the shaped segment.");
+    _paintFrame(*engine);
+    stats = engine->GetShapedRowCacheStats();
+    VERIFY_ARE_EQUAL(1ull, stats.hits);
+    VERIFY_ARE_EQUAL(1ull, stats.misses);
+
+    Log::Comment(L"Resizing the window doesn't change the font, so the cache should be kept.");
+    VERIFY_SUCCEEDED(engine->SetWindowSize({ 1024, 768 }));
+    _paintFrame(*engine);
+    stats = engine->GetShapedRowCacheStats();
+    VERIFY_ARE_EQUAL(2ull, stats.hits);
+    VERIFY_ARE_EQUAL(1ull, stats.misses);
+}
+
+void AtlasEngineTests::ShapedRowCacheClearedOnFontChange()
+{
+    const auto engine = _createEngine(12.0f);
+
+    _paintFrame(*engine);
+    _paintFrame(*engine);
+    auto stats = engine->GetShapedRowCacheStats();
+    VERIFY_ARE_EQUAL(1ull, stats.hits);
+    VERIFY_ARE_EQUAL(1ull, stats.misses);
+
+    Log::Comment(L"The glyph advances depend on the font size. The text must be shaped again.");
+    _updateFont(*engine, 16.0f);
+    _paintFrame(*engine);
+    stats = engine->GetShapedRowCacheStats();
+    VERIFY_ARE_EQUAL(1ull, stats.hits);
+    VERIFY_ARE_EQUAL(2ull, stats.misses);
+
+    _paintFrame(*engine);
+    stats = engine->GetShapedRowCacheStats();
+    VERIFY_ARE_EQUAL(2ull, stats.hits);
+    VERIFY_ARE_EQUAL(2ull, stats.misses);
+}
+
+void AtlasEngineTests::ShapedRowCacheClearedOnDpiChange()
+{
+    const auto engine = _createEngine(12.0f);
+
+    _paintFrame(*engine);
+    _paintFrame(*engine);
+    auto stats = engine->GetShapedRowCacheStats();
+    VERIFY_ARE_EQUAL(1ull, stats.hits);
+    VERIFY_ARE_EQUAL(1ull, stats.misses);
+
+    Log::Comment(L"A DPI change scales the font, just like a font size change does.");
+    VERIFY_SUCCEEDED(engine->UpdateDpi(USER_DEFAULT_SCREEN_DPI * 2));
+    _paintFrame(*engine);
+    stats = engine->GetShapedRowCacheStats();
+    VERIFY_ARE_EQUAL(1ull, stats.hits);
+    VERIFY_ARE_EQUAL(2ull, stats.misses);
+}
+
+void AtlasEngineTests::FontFallbackCacheClearedOnFontChange()
+{
+    const auto engine = _createEngine(12.0f);
+    auto& cache = engine->_api.fontFallbackCache[0];
+    IDWriteFontFace2* fontFace = nullptr;
+
+    VERIFY_IS_FALSE(cache.Find(L"H", fontFace));
+
+    _paintFrame(*engine);
+    VERIFY_IS_TRUE(cache.Find(L"H", fontFace));
+    VERIFY_IS_NOT_NULL(fontFace);
+
+    Log::Comment(L"The cached font faces belong to the previous font and must not be handed out anymore.");
+    _updateFont(*engine, 16.0f);
+    VERIFY_SUCCEEDED(engine->StartPaint());
+    VERIFY_IS_FALSE(cache.Find(L"H", fontFace));
+    VERIFY_SUCCEEDED(engine->EndPaint());
+
+    _paintFrame(*engine);
+    VERIFY_IS_TRUE(cache.Find(L"H", fontFace));
+}
+
+void AtlasEngineTests::GlyphAtlasResetOnFontChange()
+{
+    // The glyph atlas only exists in the Direct3D backend. WARP makes this work without a GPU.
+    const auto engine = _createEngine(12.0f);
+    engine->SetSoftwareRendering(true);
+    engine->SetGraphicsAPI(Atlas::GraphicsAPI::Direct3D11);
+
+    _paintFrame(*engine);
+    VERIFY_SUCCEEDED(engine->Present());
+    auto stats = engine->GetGlyphAtlasStats();
+    VERIFY_ARE_EQUAL(1ull, stats.resets);
+
+    Log::Comment(L"Drawing the same glyphs again should neither reset the atlas nor evict any of its pages.");
+    _paintFrame(*engine);
+    VERIFY_SUCCEEDED(engine->Present());
+    stats = engine->GetGlyphAtlasStats();
+    VERIFY_ARE_EQUAL(1ull, stats.resets);
+    VERIFY_ARE_EQUAL(0ull, stats.pageEvictions);
+
+    Log::Comment(L"The rasterized glyphs depend on the font size. The atlas must be reset.");
+    _updateFont(*engine, 16.0f);
+    _paintFrame(*engine);
+    VERIFY_SUCCEEDED(engine->Present());
+    stats = engine->GetGlyphAtlasStats();
+    VERIFY_ARE_EQUAL(2ull, stats.resets);
+
+    Log::Comment(L"The same goes for the DPI.");
+    VERIFY_SUCCEEDED(engine->UpdateDpi(USER_DEFAULT_SCREEN_DPI * 2));
+    _paintFrame(*engine);
+    VERIFY_SUCCEEDED(engine->Present());
+    stats = engine->GetGlyphAtlasStats();
+    VERIFY_ARE_EQUAL(3ull, stats.resets);
+    VERIFY_ARE_EQUAL(0ull, stats.pageEvictions);
+}
+
+#endif
@@ -201,4 +201,78 @@ class SearchTests
         s.Reset(gci.renderData, L"(?i)ab", SearchFlag::RegularExpression, false);
         DoFoundChecks(s, {}, 1, false);
     }
+
+    TEST_METHOD(ResetUpdatesResultsInPlace)
+    {
+        auto& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
+        auto& textBuffer = gci.GetActiveOutputBuffer().GetTextBuffer();
+
+        static constexpr auto s = [](til::CoordType x, til::CoordType y) -> til::point_span {
+            return { { x, y }, { x + 1, y } };
+        };
+
+        Search search;
+        search.Reset(gci.renderData, L"AB", SearchFlag::None, false);
+        auto expected = std::vector{ s(0, 0), s(0, 1), s(0, 2), s(0, 3) };
+        VERIFY_IS_TRUE(expected == search.Results());
+
+        // Overwriting a match should only drop that one.
+        RowWriteState state{ .text = L"xx" };
+        textBuffer.Replace(1, TextAttribute{}, state);
+        VERIFY_IS_TRUE(search.IsStale(gci.renderData, L"AB", SearchFlag::None));
+        search.Reset(gci.renderData, L"AB", SearchFlag::None, false);
+        expected = std::vector{ s(0, 0), s(0, 2), s(0, 3) };
+        VERIFY_IS_TRUE(expected == search.Results());
+        VERIFY_IS_TRUE(std::vector{ s(0, 1) } == search.TakeStaleResults());
+
+        // New output should be appended to the existing results.
+        state = RowWriteState{ .text = L"..AB" };
+        textBuffer.Replace(6, TextAttribute{}, state);
+        search.Reset(gci.renderData, L"AB", SearchFlag::None, false);
+        expected = std::vector{ s(0, 0), s(0, 2), s(0, 3), s(2, 6) };
+        VERIFY_IS_TRUE(expected == search.Results());
+        VERIFY_IS_TRUE(search.TakeStaleResults().empty());
+
+        // ...and the results must be identical to a search from scratch.
+        Search fresh;
+        fresh.Reset(gci.renderData, L"AB", SearchFlag::None, false);
+        VERIFY_IS_TRUE(fresh.Results() == search.Results());
+    }
+
+    TEST_METHOD(ResetStreamingStartsAtViewport)
+    {
+        auto& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
+        auto& textBuffer = gci.GetActiveOutputBuffer().GetTextBuffer();
+
+        // Two matches far below the viewport.
+        RowWriteState state{ .text = L"..AB" };
+        textBuffer.Replace(150, TextAttribute{}, state);
+        state = RowWriteState{ .text = L"..AB" };
+        textBuffer.Replace(250, TextAttribute{}, state);
+
+        static constexpr auto s = [](til::CoordType x, til::CoordType y) -> til::point_span {
+            return { { x, y }, { x + 1, y } };
+        };
+
+        Search search;
+        search.ResetStreaming(gci.renderData, L"AB", SearchFlag::None, false);
+        auto expected = std::vector{ s(0, 0), s(0, 1), s(0, 2), s(0, 3) };
+        VERIFY_IS_TRUE(expected == search.Results());
+        VERIFY_IS_TRUE(search.IsStreaming());
+
+        // Starting the same search again must continue where we left off.
+        VERIFY_IS_TRUE(search.StreamNext(100));
+        search.ResetStreaming(gci.renderData, L"AB", SearchFlag::None, false);
+        expected = std::vector{ s(0, 0), s(0, 1), s(0, 2), s(0, 3), s(2, 150) };
+        VERIFY_IS_TRUE(expected == search.Results());
+
+        while (search.StreamNext(100))
+        {
+        }
+
+        Search fresh;
+        fresh.Reset(gci.renderData, L"AB", SearchFlag::None, false);
+        VERIFY_IS_TRUE(fresh.Results() == search.Results());
+        VERIFY_IS_FALSE(search.IsStale(gci.renderData, L"AB", SearchFlag::None));
+    }
 };
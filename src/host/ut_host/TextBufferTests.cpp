@@ -138,6 +138,8 @@ class TextBufferTests
     TEST_METHOD(TestOverwriteChars);
     TEST_METHOD(TestReplace);
     TEST_METHOD(TestInsert);
+    TEST_METHOD(TestDamage);
+    TEST_METHOD(TestGetTextRuns);
 
     TEST_METHOD(TestAppendRTFText);
 
@@ -153,6 +155,14 @@ class TextBufferTests
     TEST_METHOD(NoHyperlinkTrim);
 
     TEST_METHOD(ReflowPromptRegions);
+
+    TEST_METHOD(PackColdRows);
+    TEST_METHOD(CompactAttributePalette);
+    TEST_METHOD(SearchPackedRows);
+    TEST_METHOD(SpillEvictedRows);
+    TEST_METHOD(ContinueReflowMatchesReflow);
+    TEST_METHOD(LogicalLineIndex);
+    TEST_METHOD(MarkIndex);
 };
 
 void TextBufferTests::TestBufferCreate()
@@ -1981,6 +1991,126 @@ void TextBufferTests::TestInsert()
     VERIFY_ARE_EQUAL(expectedAttr, actualAttr);
 }
 
+void TextBufferTests::TestDamage()
+{
+    static constexpr til::size bufferSize{ 10, 5 };
+    static constexpr UINT cursorSize = 12;
+    const TextAttribute attr{ 0x7f };
+    TextBuffer buffer{ bufferSize, attr, cursorSize, true, &_renderer };
+    std::vector<til::rect> damage;
+
+    const auto write = [&](til::CoordType row, til::CoordType column, std::wstring_view text) {
+        RowWriteState state{
+            .text = text,
+            .columnBegin = column,
+            .columnLimit = bufferSize.width,
+        };
+        buffer.Replace(row, attr, state);
+    };
+
+    Log::Comment(L"Writes to the same row are merged into a single span");
+    write(1, 2, L"ab");
+    write(1, 6, L"c");
+    write(3, 0, L"d");
+    buffer.TakeDamage(damage);
+    VERIFY_ARE_EQUAL(2u, damage.size());
+    VERIFY_ARE_EQUAL((til::rect{ 2, 1, 7, 2 }), damage[0]);
+    VERIFY_ARE_EQUAL((til::rect{ 0, 3, 1, 4 }), damage[1]);
+
+    Log::Comment(L"Taking the damage marks everything clean");
+    damage.clear();
+    buffer.TakeDamage(damage);
+    VERIFY_ARE_EQUAL(0u, damage.size());
+
+    Log::Comment(L"Adjacent rows with identical spans are merged into a single rectangle");
+    buffer.FillRect({ 1, 0, 4, 3 }, L"x", attr);
+    buffer.TakeDamage(damage);
+    VERIFY_ARE_EQUAL(1u, damage.size());
+    VERIFY_ARE_EQUAL((til::rect{ 1, 0, 4, 3 }), damage[0]);
+
+    Log::Comment(L"Damage is reported relative to the first row after the buffer rotated");
+    damage.clear();
+    write(2, 0, L"e");
+    buffer.IncrementCircularBuffer(attr);
+    buffer.TakeDamage(damage);
+    VERIFY_ARE_EQUAL(1u, damage.size());
+    VERIFY_ARE_EQUAL((til::rect{ 0, 1, 1, 2 }), damage[0]);
+
+    Log::Comment(L"TriggerRedraw() is recorded as damage and clamped to the buffer");
+    damage.clear();
+    buffer.TriggerRedraw(Viewport::FromExclusive({ -2, 3, 20, 9 }));
+    buffer.TakeDamage(damage);
+    VERIFY_ARE_EQUAL(1u, damage.size());
+    VERIFY_ARE_EQUAL((til::rect{ 0, 3, 10, 5 }), damage[0]);
+
+    Log::Comment(L"Inactive buffers don't track damage");
+    damage.clear();
+    buffer.SetAsActiveBuffer(false);
+    write(0, 0, L"f");
+    buffer.TakeDamage(damage);
+    VERIFY_ARE_EQUAL(0u, damage.size());
+}
+
+void TextBufferTests::TestGetTextRuns()
+{
+    static constexpr til::size bufferSize{ 10, 1 };
+    static constexpr UINT cursorSize = 12;
+    static constexpr TextAttribute attr1{ 0x11111111, 0x00000000 };
+    static constexpr TextAttribute attr2{ 0x22222222, 0x00000000 };
+    static constexpr TextAttribute attr3{ 0x33333333, 0x00000000 };
+    TextBuffer buffer{ bufferSize, attr1, cursorSize, false, &_renderer };
+
+    const auto write = [&](til::CoordType column, std::wstring_view text, const TextAttribute& attr) {
+        RowWriteState state{
+            .text = text,
+            .columnBegin = column,
+            .columnLimit = bufferSize.width,
+        };
+        buffer.Replace(0, attr, state);
+    };
+
+    write(0, L"ab", attr1);
+    write(2, L"\U0001F604", attr2);
+    write(4, L"cd", attr1);
+    // The right half of the wide glyph has different attributes than its left half.
+    auto& row = buffer.GetMutableRowByOffset(0);
+    row.ReplaceAttributes(3, 4, attr3);
+
+    std::vector<RowTextRun> runs;
+
+    Log::Comment(L"A wide glyph belongs to the run of its left half");
+    row.GetTextRuns(0, bufferSize.width, runs);
+    VERIFY_ARE_EQUAL(3u, runs.size());
+    VERIFY_ARE_EQUAL(L"ab", runs[0].text);
+    VERIFY_ARE_EQUAL(0, runs[0].columnBegin);
+    VERIFY_ARE_EQUAL(2, runs[0].columnEnd);
+    VERIFY_ARE_EQUAL(attr1, runs[0].attr);
+    VERIFY_ARE_EQUAL(L"\U0001F604", runs[1].text);
+    VERIFY_ARE_EQUAL(2, runs[1].columnBegin);
+    VERIFY_ARE_EQUAL(4, runs[1].columnEnd);
+    VERIFY_ARE_EQUAL(attr2, runs[1].attr);
+    VERIFY_ARE_EQUAL(L"cd      ", runs[2].text);
+    VERIFY_ARE_EQUAL(4, runs[2].columnBegin);
+    VERIFY_ARE_EQUAL(10, runs[2].columnEnd);
+    VERIFY_ARE_EQUAL(attr1, runs[2].attr);
+
+    Log::Comment(L"Starting at the right half of a wide glyph includes its left half");
+    runs.clear();
+    row.GetTextRuns(3, 5, runs);
+    VERIFY_ARE_EQUAL(2u, runs.size());
+    VERIFY_ARE_EQUAL(L"\U0001F604", runs[0].text);
+    VERIFY_ARE_EQUAL(2, runs[0].columnBegin);
+    VERIFY_ARE_EQUAL(4, runs[0].columnEnd);
+    VERIFY_ARE_EQUAL(L"c", runs[1].text);
+    VERIFY_ARE_EQUAL(4, runs[1].columnBegin);
+    VERIFY_ARE_EQUAL(5, runs[1].columnEnd);
+
+    Log::Comment(L"An empty range yields no runs");
+    runs.clear();
+    row.GetTextRuns(5, 5, runs);
+    VERIFY_ARE_EQUAL(0u, runs.size());
+}
+
 void TextBufferTests::TestAppendRTFText()
 {
     {
@@ -2900,3 +3030,411 @@ void TextBufferTests::ReflowPromptRegions()
     Log::Comment(L"========== Checking the host buffer state (after) ==========");
     verifyBuffer(*newBuffer, si.GetViewport().ToExclusive(), false, true);
 }
+
+void TextBufferTests::PackColdRows()
+{
+    til::size bufferSize{ 20, 2000 };
+    TextBuffer buffer{ bufferSize, TextAttribute{ 0x7 }, 0, false, &_renderer };
+
+    TextAttribute red{ 0x4 };
+    TextAttribute blue{ 0x1 };
+
+    // A mix of rows that pack as Latin-1, as UTF-8 with wide glyphs and as attributes only.
+    const auto writeRow = [&](til::CoordType y) {
+        auto& row = buffer.GetMutableRowByOffset(y);
+        switch (y % 3)
+        {
+        case 0:
+            row.ReplaceCharacters(0, 1, L"\u00e9");
+            row.ReplaceCharacters(1, 1, std::to_wstring(y % 10));
+            break;
+        case 1:
+            row.ReplaceCharacters(2, 2, L"\u304b");
+            row.ReplaceAttributes(4, 8, red);
+            row.SetWrapForced(true);
+            break;
+        default:
+            row.SetAttrToEnd(10, blue);
+            break;
+        }
+    };
+    const auto verifyRow = [&](til::CoordType y) {
+        const auto& row = buffer.GetRowByOffset(y);
+        switch (y % 3)
+        {
+        case 0:
+            VERIFY_ARE_EQUAL(L"\u00e9" + std::to_wstring(y % 10) + std::wstring(18, L' '), row.GetText());
+            VERIFY_IS_FALSE(row.WasWrapForced());
+            break;
+        case 1:
+            VERIFY_ARE_EQUAL(L"  \u304b" + std::wstring(16, L' '), row.GetText());
+            VERIFY_ARE_EQUAL(TextAttribute{ 0x7 }, row.GetAttrByColumn(3));
+            VERIFY_ARE_EQUAL(red, row.GetAttrByColumn(4));
+            VERIFY_ARE_EQUAL(TextAttribute{ 0x7 }, row.GetAttrByColumn(8));
+            VERIFY_IS_TRUE(row.WasWrapForced());
+            break;
+        default:
+            VERIFY_ARE_EQUAL(std::wstring(20, L' '), row.GetText());
+            VERIFY_ARE_EQUAL(TextAttribute{ 0x7 }, row.GetAttrByColumn(9));
+            VERIFY_ARE_EQUAL(blue, row.GetAttrByColumn(19));
+            break;
+        }
+    };
+
+    for (til::CoordType y = 0; y < 256; ++y)
+    {
+        writeRow(y);
+    }
+
+    const auto bottom = Viewport::FromDimensions({ 0, 1984 }, { 20, 16 });
+
+    Log::Comment(L"Rows near the cursor must not be packed.");
+    buffer.GetCursor().SetYPosition(256);
+    buffer.PackColdRows(bottom);
+    VERIFY_ARE_EQUAL(0u, buffer._packedChunkCount);
+
+    Log::Comment(L"Rows near the viewport must not be packed either.");
+    buffer.GetCursor().SetYPosition(1999);
+    buffer.PackColdRows(Viewport::FromDimensions({ 0, 200 }, { 20, 16 }));
+    VERIFY_ARE_EQUAL(0u, buffer._packedChunkCount);
+
+    Log::Comment(L"Rows far away from both get packed. Reading them doesn't unpack them, but they retain their contents.");
+    buffer.PackColdRows(bottom);
+    VERIFY_IS_GREATER_THAN(buffer._packedChunkCount, 0u);
+    const auto packedChunkCount = buffer._packedChunkCount;
+
+    for (til::CoordType y = 0; y < 256; ++y)
+    {
+        verifyRow(y);
+    }
+    VERIFY_ARE_EQUAL(packedChunkCount, buffer._packedChunkCount);
+    VERIFY_ARE_EQUAL(256u, buffer._decodedRows.size());
+
+    Log::Comment(L"The decoded copies are freed by the next call.");
+    buffer.PackColdRows(bottom);
+    VERIFY_ARE_EQUAL(packedChunkCount, buffer._packedChunkCount);
+    VERIFY_ARE_EQUAL(0u, buffer._decodedRows.size());
+
+    Log::Comment(L"Writing to a row unpacks its chunk.");
+    buffer.GetMutableRowByOffset(0).SetWrapForced(false);
+    VERIFY_ARE_EQUAL(packedChunkCount - 1, buffer._packedChunkCount);
+    verifyRow(0);
+
+    Log::Comment(L"Scrolling the viewport back to the packed rows unpacks them.");
+    buffer.PackColdRows(Viewport::FromDimensions({ 0, 0 }, { 20, 16 }));
+    VERIFY_ARE_EQUAL(0u, buffer._packedChunkCount);
+
+    for (til::CoordType y = 0; y < 256; ++y)
+    {
+        verifyRow(y);
+    }
+}
+
+void TextBufferTests::CompactAttributePalette()
+{
+    til::size bufferSize{ 20, 2000 };
+    TextBuffer buffer{ bufferSize, TextAttribute{ 0x7 }, 0, false, &_renderer };
+
+    // Each row has a foreground color of its own in its second half.
+    const auto attrForRow = [](til::CoordType y) {
+        TextAttribute attr{ 0x7 };
+        attr.SetForeground(RGB(y & 0xff, y >> 8, 0x80));
+        return attr;
+    };
+    const auto verifyRow = [&](til::CoordType y) {
+        const auto& row = buffer.GetRowByOffset(y);
+        VERIFY_ARE_EQUAL(TextAttribute{ 0x7 }, row.GetAttrByColumn(9));
+        VERIFY_ARE_EQUAL(attrForRow(y), row.GetAttrByColumn(10));
+    };
+
+    // The rows that PackColdRows() packs with the cursor and viewport at the bottom: 15 chunks of 64 rows.
+    static constexpr til::CoordType rowCount = 960;
+    for (til::CoordType y = 0; y < rowCount; ++y)
+    {
+        buffer.GetMutableRowByOffset(y).SetAttrToEnd(10, attrForRow(y));
+    }
+
+    buffer.GetCursor().SetYPosition(1999);
+    buffer.PackColdRows(Viewport::FromDimensions({ 0, 1984 }, { 20, 16 }));
+    VERIFY_ARE_EQUAL(15u, buffer._packedChunkCount);
+    VERIFY_ARE_EQUAL(961u, buffer._attributePalette.Size());
+
+    Log::Comment(L"Unpacking rows doesn't shrink the palette, but compacting it does.");
+    for (til::CoordType y = 0; y < 512; y += 64)
+    {
+        buffer.GetMutableRowByOffset(y);
+    }
+    VERIFY_ARE_EQUAL(7u, buffer._packedChunkCount);
+    VERIFY_ARE_EQUAL(961u, buffer._attributePalette.Size());
+    buffer._compactAttributePalette();
+    VERIFY_ARE_EQUAL(449u, buffer._attributePalette.Size());
+
+    Log::Comment(L"All rows retain their attributes.");
+    for (til::CoordType y = 0; y < rowCount; ++y)
+    {
+        verifyRow(y);
+    }
+}
+
+void TextBufferTests::SearchPackedRows()
+{
+    til::size bufferSize{ 20, 2000 };
+    TextBuffer buffer{ bufferSize, TextAttribute{ 0x7 }, 0, false, &_renderer };
+
+    // The rows that PackColdRows() packs with the cursor and viewport at the bottom: 15 chunks of 64 rows.
+    static constexpr til::CoordType rowCount = 960;
+    for (til::CoordType y = 0; y < rowCount; ++y)
+    {
+        buffer.GetMutableRowByOffset(y).ReplaceCharacters(0, 3, L"abc");
+    }
+    buffer.GetMutableRowByOffset(100).ReplaceCharacters(4, 6, L"needle");
+
+    buffer.GetCursor().SetYPosition(1999);
+    buffer.PackColdRows(Viewport::FromDimensions({ 0, 1984 }, { 20, 16 }));
+    VERIFY_ARE_EQUAL(15u, buffer._packedChunkCount);
+
+    Log::Comment(L"Searching must find matches in packed rows, but only decode the rows that pass the filter.");
+    const auto results = buffer.SearchText(L"needle", SearchFlag::None);
+    VERIFY_IS_TRUE(results.has_value());
+    VERIFY_ARE_EQUAL(1u, results->size());
+    VERIFY_ARE_EQUAL(til::point(4, 100), results->front().start);
+    VERIFY_ARE_EQUAL(til::point(9, 100), results->front().end);
+    VERIFY_ARE_EQUAL(15u, buffer._packedChunkCount);
+    VERIFY_ARE_EQUAL(1u, buffer._decodedRows.size());
+
+    Log::Comment(L"Needles without a usable filter search every row, but leave them packed as well.");
+    VERIFY_ARE_EQUAL(rowCount, gsl::narrow_cast<til::CoordType>(buffer.SearchText(L"a", SearchFlag::None)->size()));
+    VERIFY_ARE_EQUAL(15u, buffer._packedChunkCount);
+}
+
+void TextBufferTests::SpillEvictedRows()
+{
+    til::size bufferSize{ 20, 4 };
+    TextBuffer buffer{ bufferSize, TextAttribute{ 0x7 }, 0, false, &_renderer };
+    buffer.EnableSpill();
+
+    // Writes "#N" into the bottom row and scrolls it up by one.
+    for (auto i = 0; i < 10; ++i)
+    {
+        auto& row = buffer.GetMutableRowByOffset(3);
+        row.ReplaceCharacters(0, 1, L"#");
+        row.ReplaceCharacters(1, 1, std::to_wstring(i));
+        if (i == 2)
+        {
+            row.SetScrollbarData(ScrollbarData{ .category = MarkCategory::Prompt });
+        }
+        buffer.SetWrapForced(3, i == 5);
+        buffer.IncrementCircularBuffer();
+    }
+
+    // The first 3 evicted rows are empty, followed by #0 to #6. #7 to #9 are still in the buffer.
+    VERIFY_ARE_EQUAL(10, buffer.GetSpilledRowCount());
+    VERIFY_ARE_EQUAL(L"#0", buffer.GetPlainText({ 0, -7 }, { 1, -7 }));
+    VERIFY_ARE_EQUAL(L"#6" + std::wstring(18, L' ') + L"#7", buffer.GetPlainText({ 0, -1 }, { 1, 0 }));
+
+    const auto marks = buffer.GetSpilledMarkRows();
+    VERIFY_ARE_EQUAL(1u, marks.size());
+    VERIFY_ARE_EQUAL(-5, marks[0].row);
+
+    // Everything that reads rows via GetRowByOffset(), like the renderer, can read the spilled ones as well.
+    // They're all in the same batch of the SpillLog, so they get decoded at once.
+    VERIFY_ARE_EQUAL(L'0', buffer.GetRowByOffset(-7).GetText()[1]);
+    VERIFY_ARE_EQUAL(L'6', buffer.GetRowByOffset(-1).GetText()[1]);
+    VERIFY_ARE_EQUAL(10u, buffer._decodedSpilledRows.size());
+    VERIFY_IS_TRUE(buffer.GetRowByOffset(-2).WasWrapForced());
+
+    // #5 is wrapped into #6. The logical lines of the spilled rows end at row 0.
+    VERIFY_ARE_EQUAL(-2, buffer.GetLogicalLineStart(-1));
+    VERIFY_ARE_EQUAL(0, buffer.GetLogicalLineEnd(-2));
+    VERIFY_ARE_EQUAL(-3, buffer.GetLogicalLineStart(-3));
+    VERIFY_ARE_EQUAL(-2, buffer.GetLogicalLineEnd(-3));
+    VERIFY_ARE_EQUAL(0, buffer.GetLogicalLineStart(0));
+
+    const auto results = buffer.SearchText(L"#4", SearchFlag::None, -buffer.GetSpilledRowCount(), 4);
+    VERIFY_IS_TRUE(results.has_value());
+    VERIFY_ARE_EQUAL(1u, results->size());
+    VERIFY_IS_TRUE((til::point_span{ { 0, -3 }, { 1, -3 } }) == results->at(0));
+    // Searching the entire buffer includes the spilled rows.
+    VERIFY_ARE_EQUAL(1u, buffer.SearchText(L"#4", SearchFlag::None)->size());
+
+    buffer.ClearScrollback(1, 1);
+    VERIFY_ARE_EQUAL(0, buffer.GetSpilledRowCount());
+    VERIFY_ARE_EQUAL(0u, buffer._decodedSpilledRows.size());
+}
+
+void TextBufferTests::ContinueReflowMatchesReflow()
+{
+    static constexpr til::CoordType rowCount = 2500;
+
+    // Every 7th row wraps into the next one.
+    const auto makeOldBuffer = [&]() {
+        auto buffer = std::make_unique<TextBuffer>(til::size{ 20, 3000 }, TextAttribute{ 0x7 }, 0, false, &_renderer);
+        for (til::CoordType y = 0; y < rowCount; ++y)
+        {
+            auto text = std::to_wstring(y);
+            text.resize(20, gsl::narrow_cast<wchar_t>(L'a' + y % 26));
+            RowWriteState state{ .text = text };
+            buffer->Replace(y, TextAttribute{ 0x7 }, state);
+            buffer->GetMutableRowByOffset(y).SetWrapForced(y % 7 == 0);
+        }
+        buffer->GetCursor().SetPosition({ 0, rowCount - 1 });
+        return buffer;
+    };
+
+    const til::size newSize{ 13, 8000 };
+
+    auto expected = std::make_unique<TextBuffer>(newSize, TextAttribute{ 0x7 }, 0, false, &_renderer);
+    TextBuffer::Reflow(*makeOldBuffer(), *expected);
+
+    auto oldBuffer = makeOldBuffer();
+    auto actual = std::make_unique<TextBuffer>(newSize, TextAttribute{ 0x7 }, 0, false, &_renderer);
+    const auto reflowStart = TextBuffer::GetLazyReflowStart(*oldBuffer, rowCount - 10);
+    VERIFY_IS_GREATER_THAN(reflowStart, 0);
+    const auto reflowReserve = TextBuffer::GetLazyReflowReserve(*oldBuffer, reflowStart, newSize);
+    VERIFY_ARE_EQUAL(reflowStart * 2, reflowReserve);
+    TextBuffer::Reflow(*oldBuffer, *actual, nullptr, nullptr, reflowStart, til::CoordTypeMax, reflowReserve);
+    actual->DeferReflow(std::move(oldBuffer), reflowStart);
+
+    // The rows that were reflowed right away are released from the old buffer.
+    const auto& pending = actual->_pendingReflow;
+    VERIFY_IS_LESS_THAN(pending.back().source->_estimateOffsetOfLastCommittedRow(), reflowStart + 64);
+
+    // Nothing moves until the reflow is complete, so the cursor stays put.
+    const auto cursorY = actual->GetCursor().GetPosition().y;
+    til::CoordType removed = 0;
+    while (actual->IsReflowPending())
+    {
+        VERIFY_ARE_EQUAL(0, removed);
+        VERIFY_ARE_EQUAL(cursorY, actual->GetCursor().GetPosition().y);
+        if (!pending.empty())
+        {
+            VERIFY_IS_LESS_THAN(pending.back().source->_estimateOffsetOfLastCommittedRow(), pending.back().end + 64);
+        }
+        removed = actual->ContinueReflow(100);
+    }
+
+    // The buffer was never rotated backwards, which would have committed it to the end of its arena.
+    VERIFY_IS_LESS_THAN(actual->_estimateOffsetOfLastCommittedRow(), newSize.height - 1);
+
+    const auto cursorPos = expected->GetCursor().GetPosition();
+    VERIFY_ARE_EQUAL(cursorPos, actual->GetCursor().GetPosition());
+
+    for (til::CoordType y = 0; y <= cursorPos.y; ++y)
+    {
+        const auto& expectedRow = expected->GetRowByOffset(y);
+        const auto& actualRow = actual->GetRowByOffset(y);
+        VERIFY_ARE_EQUAL(expectedRow.GetText(), actualRow.GetText());
+        VERIFY_ARE_EQUAL(expectedRow.WasWrapForced(), actualRow.WasWrapForced());
+    }
+}
+
+void TextBufferTests::LogicalLineIndex()
+{
+    static constexpr til::CoordType height = 300;
+    TextBuffer buffer{ { 10, height }, TextAttribute{ 0x7 }, 0, false, &_renderer };
+
+    // Rotate the buffer so that lines cross the end of the underlying storage.
+    for (auto i = 0; i < 150; ++i)
+    {
+        buffer.IncrementCircularBuffer(TextAttribute{ 0x7 });
+    }
+
+    // Lines of varying lengths, including some that span more than 64 rows.
+    til::CoordType y = 0;
+    for (auto length = 1; y < height; length = length * 3 % 97 + 1)
+    {
+        const auto end = std::min(height, y + length);
+        for (; y < end - 1; ++y)
+        {
+            buffer.SetWrapForced(y, true);
+        }
+        // The index must notice flags that are changed directly on the ROW as well.
+        buffer.GetMutableRowByOffset(y).SetWrapForced(false);
+        ++y;
+    }
+    buffer.GetMutableRowByOffset(height - 1).SetWrapForced(true);
+
+    for (y = 0; y < height; ++y)
+    {
+        auto beg = y;
+        for (; beg > 0 && buffer.GetRowByOffset(beg - 1).WasWrapForced(); --beg)
+        {
+        }
+        auto end = y + 1;
+        for (; end < height && buffer.GetRowByOffset(end - 1).WasWrapForced(); ++end)
+        {
+        }
+
+        VERIFY_ARE_EQUAL(beg, buffer.GetLogicalLineStart(y));
+        VERIFY_ARE_EQUAL(end, buffer.GetLogicalLineEnd(y));
+        VERIFY_ARE_EQUAL(buffer.GetRowByOffset(y).WasWrapForced(), buffer.WasWrapForced(y));
+    }
+
+    // The row that's recycled by the rotation is reset, but it continues the line of the wrapped row above it.
+    buffer.IncrementCircularBuffer(TextAttribute{ 0x7 });
+    VERIFY_IS_FALSE(buffer.GetRowByOffset(height - 1).WasWrapForced());
+    VERIFY_ARE_EQUAL(height, buffer.GetLogicalLineEnd(height - 2));
+    VERIFY_ARE_EQUAL(buffer.GetLogicalLineStart(height - 2), buffer.GetLogicalLineStart(height - 1));
+
+    // A ROW reference may be held onto across lookups, which must notice when it changes later on.
+    auto& row = buffer.GetMutableRowByOffset(10);
+    const auto wrapped = buffer.WasWrapForced(10);
+    row.SetWrapForced(!wrapped);
+    VERIFY_ARE_EQUAL(!wrapped, buffer.WasWrapForced(10));
+    row.SetScrollbarData(ScrollbarData{});
+    const auto marks = buffer.GetMarkRows();
+    VERIFY_ARE_EQUAL(1u, marks.size());
+    VERIFY_ARE_EQUAL(10, marks[0].row);
+}
+
+void TextBufferTests::MarkIndex()
+{
+    static constexpr til::CoordType height = 300;
+    TextBuffer buffer{ { 10, height }, TextAttribute{ 0x7 }, 0, false, &_renderer };
+
+    // Rotate the buffer so that the marks cross the end of the underlying storage.
+    for (auto i = 0; i < 250; ++i)
+    {
+        buffer.IncrementCircularBuffer(TextAttribute{ 0x7 });
+    }
+
+    std::vector<til::CoordType> expected;
+    for (til::CoordType y = 3; y < height; y += y % 5 * 17 + 1)
+    {
+        buffer.SetScrollbarData(ScrollbarData{ MarkCategory::Prompt }, y);
+        expected.emplace_back(y);
+    }
+
+    // The index must notice changes made directly on the ROW as well.
+    buffer.GetMutableRowByOffset(expected.back()).SetScrollbarData(std::nullopt);
+    expected.pop_back();
+
+    const auto rows = [&]() {
+        std::vector<til::CoordType> actual;
+        for (const auto& mark : buffer.GetMarkRows())
+        {
+            actual.emplace_back(mark.row);
+        }
+        return actual;
+    };
+    VERIFY_IS_TRUE(expected == rows());
+
+    // EndCurrentCommand() finds the closest mark above the cursor.
+    buffer.GetCursor().SetPosition({ 0, expected.at(2) + 1 });
+    buffer.EndCurrentCommand(1);
+    VERIFY_ARE_EQUAL(MarkCategory::Error, buffer.GetRowByOffset(expected.at(2)).GetScrollbarData()->category);
+    VERIFY_ARE_EQUAL(MarkCategory::Prompt, buffer.GetRowByOffset(expected.at(3)).GetScrollbarData()->category);
+
+    // Rotating the buffer moves all marks up and discards the one in the first row.
+    for (auto i = 0; i <= expected.front(); ++i)
+    {
+        buffer.IncrementCircularBuffer(TextAttribute{ 0x7 });
+    }
+    const auto shift = expected.front() + 1;
+    expected.erase(expected.begin());
+    for (auto& y : expected)
+    {
+        y -= shift;
+    }
+    VERIFY_IS_TRUE(expected == rows());
+}
@@ -115,6 +115,44 @@ class ::Microsoft::Console::VirtualTerminal::VtIoTests
         VERIFY_ARE_EQUAL(expected, actual);
     }
 
+    TEST_METHOD(FlushPolicy)
+    {
+        auto& io = *ServiceLocator::LocateGlobals().getConsoleInformation().GetVtIo();
+        // The latency budget is long enough that the timer never fires during the test.
+        io.SetFlushPolicy({ .minBytes = 24, .maxLatency = std::chrono::hours{ 1 } });
+        const auto cleanup = wil::scope_exit([&]() {
+            io.SetFlushPolicy({});
+        });
+
+        const auto statsBefore = io.GetWriteStats();
+
+        // Each CUP is 6 bytes long, so the 4th one reaches the threshold.
+        THROW_IF_FAILED(routines.SetConsoleCursorPositionImpl(*screenInfo, { 2, 3 }));
+        THROW_IF_FAILED(routines.SetConsoleCursorPositionImpl(*screenInfo, { 0, 0 }));
+        THROW_IF_FAILED(routines.SetConsoleCursorPositionImpl(*screenInfo, { 7, 3 }));
+        VERIFY_ARE_EQUAL(std::string_view{}, readOutput());
+        THROW_IF_FAILED(routines.SetConsoleCursorPositionImpl(*screenInfo, { 3, 2 }));
+        VERIFY_ARE_EQUAL(cup(4, 3) cup(1, 1) cup(4, 8) cup(3, 4), readOutput());
+
+        // Output written while processing input isn't held back.
+        THROW_IF_FAILED(routines.SetConsoleCursorPositionImpl(*screenInfo, { 2, 3 }));
+        VERIFY_ARE_EQUAL(std::string_view{}, readOutput());
+        {
+            const auto flush = io.FlushImmediately();
+            THROW_IF_FAILED(routines.SetConsoleCursorPositionImpl(*screenInfo, { 0, 0 }));
+            VERIFY_ARE_EQUAL(cup(4, 3) cup(1, 1), readOutput());
+        }
+
+        // Relaxing the policy flushes whatever is held back.
+        THROW_IF_FAILED(routines.SetConsoleCursorPositionImpl(*screenInfo, { 7, 3 }));
+        io.SetFlushPolicy({});
+        VERIFY_ARE_EQUAL(cup(4, 8), readOutput());
+
+        const auto statsAfter = io.GetWriteStats();
+        VERIFY_ARE_EQUAL(uint64_t{ 3 }, statsAfter.writes - statsBefore.writes);
+        VERIFY_ARE_EQUAL(uint64_t{ 42 }, statsAfter.bytes - statsBefore.bytes);
+    }
+
     TEST_METHOD(SetConsoleOutputMode)
     {
         const auto initialMode = screenInfo->OutputMode;
@@ -47,6 +47,179 @@ namespace til // Terminal Implementation Library. Also: "Today I Learned"
         }
     };
 
+    namespace details
+    {
+#pragma warning(push)
+#pragma warning(disable : 26429 26481 26490) // use not_null, pointer arithmetic, reinterpret_cast
+        // Copies the leading ASCII characters of in to out and returns their count. ASCII is the
+        // same in UTF-8 and UTF-16, so this converts it without going through the platform API.
+        inline size_t u8u16_ascii(const char* in, const size_t len, wchar_t* out) noexcept
+        {
+            auto it = in;
+
+#if defined(TIL_SSE_INTRINSICS)
+            for (const auto end = in + (len & ~size_t{ 15 }); it < end; it += 16, out += 16)
+            {
+                const auto ch = _mm_loadu_si128(reinterpret_cast<const __m128i*>(it));
+                // The MSB of a byte is only set if it's part of a multi-byte sequence.
+                if (_mm_movemask_epi8(ch))
+                {
+                    break;
+                }
+
+                const auto z = _mm_setzero_si128();
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm_unpacklo_epi8(ch, z));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 8), _mm_unpackhi_epi8(ch, z));
+            }
+#elif defined(TIL_ARM_NEON_INTRINSICS)
+            for (const auto end = in + (len & ~size_t{ 15 }); it < end; it += 16, out += 16)
+            {
+                const auto ch = vld1q_u8(reinterpret_cast<const uint8_t*>(it));
+                if (vmaxvq_u8(ch) >= 0x80)
+                {
+                    break;
+                }
+
+                vst1q_u16(reinterpret_cast<uint16_t*>(out), vmovl_u8(vget_low_u8(ch)));
+                vst1q_u16(reinterpret_cast<uint16_t*>(out + 8), vmovl_u8(vget_high_u8(ch)));
+            }
+#endif
+
+#pragma loop(no_vector)
+            for (const auto end = in + len; it < end && static_cast<uint8_t>(*it) < 0x80; ++it, ++out)
+            {
+                *out = static_cast<wchar_t>(*it);
+            }
+
+            return gsl::narrow_cast<size_t>(it - in);
+        }
+
+        // The counterpart of u8u16_ascii for UTF-16 to UTF-8.
+        inline size_t u16u8_ascii(const wchar_t* in, const size_t len, char* out) noexcept
+        {
+            auto it = in;
+
+#if defined(TIL_SSE_INTRINSICS)
+            for (const auto end = in + (len & ~size_t{ 15 }); it < end; it += 16, out += 16)
+            {
+                const auto a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(it));
+                const auto b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(it + 8));
+                const auto high = _mm_and_si128(_mm_or_si128(a, b), _mm_set1_epi16(static_cast<short>(0xff80)));
+                if (_mm_movemask_epi8(_mm_cmpeq_epi16(high, _mm_setzero_si128())) != 0xffff)
+                {
+                    break;
+                }
+
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm_packus_epi16(a, b));
+            }
+#elif defined(TIL_ARM_NEON_INTRINSICS)
+            for (const auto end = in + (len & ~size_t{ 15 }); it < end; it += 16, out += 16)
+            {
+                const auto a = vld1q_u16(reinterpret_cast<const uint16_t*>(it));
+                const auto b = vld1q_u16(reinterpret_cast<const uint16_t*>(it + 8));
+                if (vmaxvq_u16(vorrq_u16(a, b)) >= 0x80)
+                {
+                    break;
+                }
+
+                vst1q_u8(reinterpret_cast<uint8_t*>(out), vcombine_u8(vmovn_u16(a), vmovn_u16(b)));
+            }
+#endif
+
+#pragma loop(no_vector)
+            for (const auto end = in + len; it < end && *it < 0x80; ++it, ++out)
+            {
+                *out = static_cast<char>(*it);
+            }
+
+            return gsl::narrow_cast<size_t>(it - in);
+        }
+
+        // Returns the offset of the first run of at least 16 ASCII characters, or len if there's none.
+        // Shorter runs aren't worth interrupting the platform API call for.
+        template<typename T>
+        size_t find_ascii_run(const T* in, const size_t len) noexcept
+        {
+            size_t run = 0;
+            for (size_t i = 0; i < len; ++i)
+            {
+                run = static_cast<std::make_unsigned_t<T>>(in[i]) < 0x80 ? run + 1 : 0;
+                if (run == 16)
+                {
+                    return i + 1 - run;
+                }
+            }
+            return len;
+        }
+
+        // Converts UTF-8 to UTF-16, copying runs of ASCII directly and passing everything else
+        // to MultiByteToWideChar. Splitting the input at ASCII characters is safe, because they
+        // can't be part of a multi-byte sequence. If they follow an incomplete sequence, it
+        // turns into U+FFFD either way. Returns the number of written characters or 0 on failure.
+        inline int u8u16_runs(const char* in, const int len, wchar_t* out, const int capa) noexcept
+        {
+            const auto end = gsl::narrow_cast<size_t>(len);
+            size_t pos8 = 0;
+            size_t pos16 = 0;
+
+            for (;;)
+            {
+                const auto ascii = u8u16_ascii(in + pos8, end - pos8, out + pos16);
+                pos8 += ascii;
+                pos16 += ascii;
+                if (pos8 == end)
+                {
+                    break;
+                }
+
+                const auto other = find_ascii_run(in + pos8, end - pos8);
+                const auto conv = MultiByteToWideChar(CP_UTF8, 0UL, in + pos8, gsl::narrow_cast<int>(other), out + pos16, capa - gsl::narrow_cast<int>(pos16));
+                if (!conv)
+                {
+                    return 0;
+                }
+
+                pos8 += other;
+                pos16 += gsl::narrow_cast<size_t>(conv);
+            }
+
+            return gsl::narrow_cast<int>(pos16);
+        }
+
+        // The counterpart of u8u16_runs for UTF-16 to UTF-8. Lone surrogates
+        // in front of an ASCII character turn into U+FFFD either way.
+        inline int u16u8_runs(const wchar_t* in, const int len, char* out, const int capa) noexcept
+        {
+            const auto end = gsl::narrow_cast<size_t>(len);
+            size_t pos16 = 0;
+            size_t pos8 = 0;
+
+            for (;;)
+            {
+                const auto ascii = u16u8_ascii(in + pos16, end - pos16, out + pos8);
+                pos16 += ascii;
+                pos8 += ascii;
+                if (pos16 == end)
+                {
+                    break;
+                }
+
+                const auto other = find_ascii_run(in + pos16, end - pos16);
+                const auto conv = WideCharToMultiByte(CP_UTF8, 0UL, in + pos16, gsl::narrow_cast<int>(other), out + pos8, capa - gsl::narrow_cast<int>(pos8), nullptr, nullptr);
+                if (!conv)
+                {
+                    return 0;
+                }
+
+                pos16 += other;
+                pos8 += gsl::narrow_cast<size_t>(conv);
+            }
+
+            return gsl::narrow_cast<int>(pos8);
+        }
+#pragma warning(pop)
+    }
+
     // Routine Description:
     // - Takes a UTF-8 string and performs the conversion to UTF-16. NOTE: The function relies on getting complete UTF-8 characters at the string boundaries.
     // Arguments:
@@ -70,7 +243,7 @@ namespace til // Terminal Implementation Library. Also: "Today I Learned"
             // The worst ratio of UTF-8 code units to UTF-16 code units is 1 to 1 if UTF-8 consists of ASCII only.
             RETURN_HR_IF(E_ABORT, !base::MakeCheckedNum(in.length()).AssignIfValid(&lengthRequired));
             out.resize(in.length()); // avoid to call MultiByteToWideChar twice only to get the required size
-            const int lengthOut = MultiByteToWideChar(CP_UTF8, 0ul, in.data(), lengthRequired, out.data(), lengthRequired);
+            const int lengthOut = details::u8u16_runs(in.data(), lengthRequired, out.data(), lengthRequired);
             out.resize(gsl::narrow_cast<size_t>(lengthOut));
 
             return lengthOut == 0 ? E_UNEXPECTED : S_OK;
@@ -158,7 +331,7 @@ namespace til // Terminal Implementation Library. Also: "Today I Learned"
 
             if (len8)
             {
-                const auto convLen{ MultiByteToWideChar(CP_UTF8, 0UL, cursor8, len8, out.data() + len16, capa16) };
+                const auto convLen{ details::u8u16_runs(cursor8, len8, out.data() + len16, capa16) };
                 RETURN_HR_IF(E_UNEXPECTED, !convLen);
 
                 len16 += convLen;
@@ -197,7 +370,7 @@ namespace til // Terminal Implementation Library. Also: "Today I Learned"
             // Thus, the worst ratio of UTF-16 code units to UTF-8 code units is 1 to 3.
             RETURN_HR_IF(E_ABORT, !base::MakeCheckedNum(in.length()).AssignIfValid(&lengthIn) || !base::CheckMul(lengthIn, 3).AssignIfValid(&lengthRequired));
             out.resize(gsl::narrow_cast<size_t>(lengthRequired)); // avoid to call WideCharToMultiByte twice only to get the required size
-            const int lengthOut = WideCharToMultiByte(CP_UTF8, 0ul, in.data(), lengthIn, out.data(), lengthRequired, nullptr, nullptr);
+            const int lengthOut = details::u16u8_runs(in.data(), lengthIn, out.data(), lengthRequired);
             out.resize(gsl::narrow_cast<size_t>(lengthOut));
 
             return lengthOut == 0 ? E_UNEXPECTED : S_OK;
@@ -259,7 +432,7 @@ namespace til // Terminal Implementation Library. Also: "Today I Learned"
 
             if (len16)
             {
-                const auto convLen{ WideCharToMultiByte(CP_UTF8, 0UL, cursor16, len16, out.data() + len8, capa8, nullptr, nullptr) };
+                const auto convLen{ details::u16u8_runs(cursor16, len16, out.data() + len8, capa8) };
                 RETURN_HR_IF(E_UNEXPECTED, !convLen);
 
                 len8 += convLen;
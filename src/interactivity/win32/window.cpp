@@ -312,17 +312,21 @@ void Window::_UpdateSystemMetrics() const
         {
             _hWnd = hWnd;
 
-#if TIL_FEATURE_CONHOSTATLASENGINE_ENABLED
-            if (pAtlasEngine)
             {
-                const auto hr = pAtlasEngine->SetHwnd(hWnd);
-                status = NTSTATUS_FROM_HRESULT(hr);
-            }
-            else
+                // Painting is already enabled at this point, so the engine must be locked while it's modified.
+                const auto engineLock = g.pRender->LockEngines();
+#if TIL_FEATURE_CONHOSTATLASENGINE_ENABLED
+                if (pAtlasEngine)
+                {
+                    const auto hr = pAtlasEngine->SetHwnd(hWnd);
+                    status = NTSTATUS_FROM_HRESULT(hr);
+                }
+                else
 #endif
-            {
-                const auto hr = pGdiEngine->SetHwnd(hWnd);
-                status = NTSTATUS_FROM_HRESULT(hr);
+                {
+                    const auto hr = pGdiEngine->SetHwnd(hWnd);
+                    status = NTSTATUS_FROM_HRESULT(hr);
+                }
             }
 
             if (SUCCEEDED_NTSTATUS(status))
@@ -356,6 +356,18 @@ CATCH_RETURN()
     return Types::Viewport::FromDimensions(viewInCharacters.Origin(), { viewInCharacters.Width() * _api.s->font->cellSize.x, viewInCharacters.Height() * _api.s->font->cellSize.y });
 }
 
+// Returns how often _flushBufferLine() could reuse a previously shaped segment and how often it had to shape one.
+[[nodiscard]] AtlasEngine::ShapedRowCacheStats AtlasEngine::GetShapedRowCacheStats() const noexcept
+{
+    return _api.shapedRowCache.stats;
+}
+
+// Returns how often the backend's glyph atlas was reset or had to evict glyphs to make room for new ones.
+[[nodiscard]] GlyphAtlasStats AtlasEngine::GetGlyphAtlasStats() const noexcept
+{
+    return _b ? _b->GetGlyphAtlasStats() : GlyphAtlasStats{};
+}
+
 #pragma endregion
 
 #pragma region setter
@@ -4,6 +4,7 @@
 #include "pch.h"
 #include "AtlasEngine.h"
 
+#include <til/hash.h>
 #include <til/unicode.h>
 
 #include "Backend.h"
@@ -711,6 +712,13 @@ void AtlasEngine::_handleSettingsUpdate()
 
 void AtlasEngine::_recreateFontDependentResources()
 {
+    // The glyph indices, advances and font faces all depend on the font.
+    _api.shapedRowCache.Clear();
+    for (auto& cache : _api.fontFallbackCache)
+    {
+        cache.Clear();
+    }
+
     _api.replacementCharacterFontFace.reset();
     _api.replacementCharacterGlyphIndex = 0;
     _api.replacementCharacterLookedUp = false;
@@ -814,6 +822,23 @@ void AtlasEngine::_flushBufferLine()
     // This would seriously blow us up otherwise.
     Expects(_api.bufferLineColumn.size() == _api.bufferLine.size() + 1);
 
+    // The segment is shaped with columns relative to its start, so that
+    // the cache finds the same text again, no matter where it is in the row.
+    const auto x = _api.bufferLineColumn.front();
+    for (auto& column : _api.bufferLineColumn)
+    {
+        column -= x;
+    }
+
+    auto& row = *_p.rows[_api.lastPaintBufferLineCoord.y];
+    if (const auto cached = _api.shapedRowCache.Find(_api.attributes, _api.bufferLine, _api.bufferLineColumn))
+    {
+        _appendShapedSegment(row, *cached, x);
+        return;
+    }
+
+    _api.shapedSegment.Clear();
+
     const auto builtinGlyphs = _p.s->font->builtinGlyphs;
     const auto beg = _api.bufferLine.data();
     const auto len = _api.bufferLine.size();
@@ -857,26 +882,107 @@ void AtlasEngine::_flushBufferLine()
         segmentBeg = segmentEnd;
         custom = !custom;
     }
+
+    _api.shapedRowCache.Insert(_api.attributes, _api.bufferLine, _api.bufferLineColumn, _api.shapedSegment);
+    _appendShapedSegment(row, _api.shapedSegment, x);
+}
+
+// Appends the glyphs of a segment that starts at column x to the row and colors them.
+void AtlasEngine::_appendShapedSegment(ShapedRow& row, const ShapedSegment& segment, const u16 x)
+{
+    const auto offset = row.glyphIndices.size();
+
+    for (const auto& m : segment.mappings)
+    {
+        row.mappings.emplace_back(m.fontFace, offset + m.glyphsFrom, offset + m.glyphsTo);
+    }
+
+    row.glyphIndices.insert(row.glyphIndices.end(), segment.glyphIndices.begin(), segment.glyphIndices.end());
+    row.glyphAdvances.insert(row.glyphAdvances.end(), segment.glyphAdvances.begin(), segment.glyphAdvances.end());
+    row.glyphOffsets.insert(row.glyphOffsets.end(), segment.glyphOffsets.begin(), segment.glyphOffsets.end());
+
+    // The colors aren't part of the segment, because they'd make cache hits a lot less likely.
+    const auto shift = gsl::narrow_cast<u8>(row.lineRendition != LineRendition::SingleWidth);
+    const auto colors = _p.foregroundBitmap.begin() + _p.colorBitmapRowStride * _api.lastPaintBufferLineCoord.y;
+    for (const auto column : segment.glyphColumns)
+    {
+        row.colors.emplace_back(colors[static_cast<size_t>(x + column) << shift]);
+    }
+}
+
+// Returns the cached segment for the given text, if any, and marks it as the most recently used one.
+const AtlasEngine::ShapedSegment* AtlasEngine::ShapedRowCache::Find(const FontRelevantAttributes attributes, const std::vector<wchar_t>& text, const std::vector<u16>& columns)
+{
+    const auto it = _map.find(_hash(attributes, text, columns));
+    if (it != _map.end())
+    {
+        const auto entry = it->second;
+        if (entry->attributes == attributes && entry->text == text && entry->columns == columns)
+        {
+            _lru.splice(_lru.begin(), _lru, entry);
+            stats.hits++;
+            return &entry->segment;
+        }
+    }
+
+    stats.misses++;
+    return nullptr;
+}
+
+// Stores a copy of the segment, evicting the least recently used one if the cache is full.
+void AtlasEngine::ShapedRowCache::Insert(const FontRelevantAttributes attributes, const std::vector<wchar_t>& text, const std::vector<u16>& columns, const ShapedSegment& segment)
+{
+    const auto hash = _hash(attributes, text, columns);
+
+    // On a hash collision the old entry is replaced, since the map only holds one entry per hash.
+    if (const auto it = _map.find(hash); it != _map.end())
+    {
+        _lru.erase(it->second);
+        _map.erase(it);
+    }
+    else if (_lru.size() >= capacity)
+    {
+        _map.erase(_lru.back().hash);
+        _lru.pop_back();
+    }
+
+    _lru.emplace_front(Entry{ hash, attributes, text, columns, segment });
+    _map.emplace(hash, _lru.begin());
+}
+
+void AtlasEngine::ShapedRowCache::Clear() noexcept
+{
+    _map.clear();
+    _lru.clear();
+}
+
+size_t AtlasEngine::ShapedRowCache::_hash(const FontRelevantAttributes attributes, const std::vector<wchar_t>& text, const std::vector<u16>& columns) noexcept
+{
+    til::hasher h;
+    h.write(static_cast<u8>(attributes));
+    h.write(text.data(), text.size());
+    h.write(columns.data(), columns.size());
+    return h.finalize();
 }
 
 void AtlasEngine::_mapRegularText(size_t offBeg, size_t offEnd)
 {
-    auto& row = *_p.rows[_api.lastPaintBufferLineCoord.y];
+    auto& segment = _api.shapedSegment;
 
     for (u32 idx = gsl::narrow_cast<u32>(offBeg), mappedEnd = 0; idx < offEnd; idx = mappedEnd)
     {
         u32 mappedLength = 0;
         wil::com_ptr<IDWriteFontFace2> mappedFontFace;
-        _mapCharacters(_api.bufferLine.data() + idx, gsl::narrow_cast<u32>(offEnd - idx), &mappedLength, mappedFontFace.addressof());
+        _mapCharactersCached(idx, gsl::narrow_cast<u32>(offEnd), &mappedLength, mappedFontFace.addressof());
         mappedEnd = idx + mappedLength;
 
         if (!mappedFontFace)
         {
-            _mapReplacementCharacter(idx, mappedEnd, row);
+            _mapReplacementCharacter(idx, mappedEnd, segment);
             continue;
         }
 
-        const auto initialIndicesCount = row.glyphIndices.size();
+        const auto initialIndicesCount = segment.glyphIndices.size();
 
         // GetTextComplexity() returns as many glyph indices as its textLength parameter (here: mappedLength).
         // This block ensures that the buffer has sufficient capacity. It also initializes the glyphProps buffer because it and
@@ -901,44 +1007,40 @@ void AtlasEngine::_mapRegularText(size_t offBeg, size_t offEnd)
 
                 if (isTextSimple)
                 {
-                    const auto shift = gsl::narrow_cast<u8>(row.lineRendition != LineRendition::SingleWidth);
-                    const auto colors = _p.foregroundBitmap.begin() + _p.colorBitmapRowStride * _api.lastPaintBufferLineCoord.y;
-
                     for (size_t i = 0; i < complexityLength; ++i)
                     {
                         const auto col1 = _api.bufferLineColumn[idx + i + 0];
                         const auto col2 = _api.bufferLineColumn[idx + i + 1];
                         const auto glyphAdvance = (col2 - col1) * _p.s->font->cellSize.x;
-                        const auto fg = colors[static_cast<size_t>(col1) << shift];
-                        row.glyphIndices.emplace_back(_api.glyphIndices[i]);
-                        row.glyphAdvances.emplace_back(static_cast<f32>(glyphAdvance));
-                        row.glyphOffsets.emplace_back();
-                        row.colors.emplace_back(fg);
+                        segment.glyphIndices.emplace_back(_api.glyphIndices[i]);
+                        segment.glyphAdvances.emplace_back(static_cast<f32>(glyphAdvance));
+                        segment.glyphOffsets.emplace_back();
+                        segment.glyphColumns.emplace_back(col1);
                     }
                 }
                 else
                 {
-                    _mapComplex(mappedFontFace.get(), idx, complexityLength, row);
+                    _mapComplex(mappedFontFace.get(), idx, complexityLength, segment);
                 }
             }
         }
         else
         {
-            _mapComplex(mappedFontFace.get(), idx, mappedLength, row);
+            _mapComplex(mappedFontFace.get(), idx, mappedLength, segment);
         }
 
-        const auto indicesCount = row.glyphIndices.size();
+        const auto indicesCount = segment.glyphIndices.size();
         if (indicesCount > initialIndicesCount)
         {
             // IDWriteFontFallback::MapCharacters() isn't just awfully slow,
             // it can also repeatedly return the same font face again and again. :)
-            if (row.mappings.empty() || row.mappings.back().fontFace != mappedFontFace)
+            if (segment.mappings.empty() || segment.mappings.back().fontFace != mappedFontFace)
             {
-                row.mappings.emplace_back(std::move(mappedFontFace), gsl::narrow_cast<u32>(initialIndicesCount), gsl::narrow_cast<u32>(indicesCount));
+                segment.mappings.emplace_back(std::move(mappedFontFace), gsl::narrow_cast<u32>(initialIndicesCount), gsl::narrow_cast<u32>(indicesCount));
             }
             else
             {
-                row.mappings.back().glyphsTo = gsl::narrow_cast<u32>(indicesCount);
+                segment.mappings.back().glyphsTo = gsl::narrow_cast<u32>(indicesCount);
             }
         }
     }
@@ -946,24 +1048,153 @@ void AtlasEngine::_mapRegularText(size_t offBeg, size_t offEnd)
 
 void AtlasEngine::_mapBuiltinGlyphs(size_t offBeg, size_t offEnd)
 {
-    auto& row = *_p.rows[_api.lastPaintBufferLineCoord.y];
-    auto initialIndicesCount = row.glyphIndices.size();
-    const auto shift = gsl::narrow_cast<u8>(row.lineRendition != LineRendition::SingleWidth);
-    const auto colors = _p.foregroundBitmap.begin() + _p.colorBitmapRowStride * _api.lastPaintBufferLineCoord.y;
+    auto& segment = _api.shapedSegment;
+    auto initialIndicesCount = segment.glyphIndices.size();
     const auto base = reinterpret_cast<const u16*>(_api.bufferLine.data());
     const auto len = offEnd - offBeg;
 
-    row.glyphIndices.insert(row.glyphIndices.end(), base + offBeg, base + offEnd);
-    row.glyphAdvances.insert(row.glyphAdvances.end(), len, static_cast<f32>(_p.s->font->cellSize.x));
-    row.glyphOffsets.insert(row.glyphOffsets.end(), len, {});
+    segment.glyphIndices.insert(segment.glyphIndices.end(), base + offBeg, base + offEnd);
+    segment.glyphAdvances.insert(segment.glyphAdvances.end(), len, static_cast<f32>(_p.s->font->cellSize.x));
+    segment.glyphOffsets.insert(segment.glyphOffsets.end(), len, {});
+    segment.glyphColumns.insert(segment.glyphColumns.end(), _api.bufferLineColumn.begin() + offBeg, _api.bufferLineColumn.begin() + offEnd);
+
+    segment.mappings.emplace_back(nullptr, gsl::narrow_cast<u32>(initialIndicesCount), gsl::narrow_cast<u32>(segment.glyphIndices.size()));
+}
+
+// Same as _mapCharacters() for _api.bufferLine[idx,end), except that the results are cached per cluster.
+// A run of clusters that are all cached and map to the same font face doesn't call into DirectWrite at all.
+void AtlasEngine::_mapCharactersCached(const u32 idx, const u32 end, u32* mappedLength, IDWriteFontFace2** mappedFontFace)
+{
+    auto& cache = _api.fontFallbackCache[static_cast<size_t>(_api.attributes)];
+    const auto text = _api.bufferLine.data();
+
+    // All characters of a cluster share the same column, because _api.bufferLineColumn
+    // stores the column of the cluster they belong to. This returns the end of the cluster at pos.
+    const auto clusterEnd = [&](u32 pos) noexcept {
+        const auto column = _api.bufferLineColumn[pos];
+        do
+        {
+            ++pos;
+        } while (pos < end && _api.bufferLineColumn[pos] == column);
+        return pos;
+    };
+
+    IDWriteFontFace2* runFontFace = nullptr;
+    auto pos = idx;
+
+    while (pos < end)
+    {
+        const auto next = clusterEnd(pos);
+        IDWriteFontFace2* fontFace = nullptr;
+        if (!cache.Find({ text + pos, next - pos }, fontFace) || (pos != idx && fontFace != runFontFace))
+        {
+            break;
+        }
+        runFontFace = fontFace;
+        pos = next;
+    }
+
+    if (pos != idx)
+    {
+        *mappedLength = pos - idx;
+        *mappedFontFace = wil::com_ptr<IDWriteFontFace2>{ runFontFace }.detach();
+        return;
+    }
+
+    _mapCharacters(text + idx, end - idx, mappedLength, mappedFontFace);
+
+    // MapCharacters() may stop in the middle of a cluster. Only whole clusters are remembered.
+    const auto mappedEnd = idx + *mappedLength;
+    while (pos < mappedEnd)
+    {
+        const auto next = clusterEnd(pos);
+        if (next > mappedEnd)
+        {
+            break;
+        }
+        cache.Insert({ text + pos, next - pos }, *mappedFontFace);
+        pos = next;
+    }
+}
+
+// Returns true if the cluster is cached. fontFace may be nullptr if no font covers the cluster.
+bool AtlasEngine::FontFallbackCache::Find(const std::wstring_view cluster, IDWriteFontFace2*& fontFace) const
+{
+    if (const auto cp = _codepoint(cluster); cp != invalidCodepoint)
+    {
+        const auto& plane = _primaryCoverage[cp >> 16];
+        if (!plane.empty() && (plane[(cp & 0xffff) >> 6] >> (cp & 63)) & 1)
+        {
+            fontFace = _primary.get();
+            return true;
+        }
+    }
+
+    const auto it = _clusters.find(cluster);
+    if (it == _clusters.end())
+    {
+        return false;
+    }
+
+    fontFace = it->second.get();
+    return true;
+}
+
+void AtlasEngine::FontFallbackCache::Insert(const std::wstring_view cluster, IDWriteFontFace2* fontFace)
+{
+    if (!_primary && fontFace)
+    {
+        _primary = fontFace;
+    }
+
+    const auto cp = _codepoint(cluster);
+
+    if (cp != invalidCodepoint && fontFace && fontFace == _primary.get())
+    {
+        auto& plane = _primaryCoverage[cp >> 16];
+        if (plane.empty())
+        {
+            plane.resize(0x10000 / 64);
+        }
+        plane[(cp & 0xffff) >> 6] |= u64{ 1 } << (cp & 63);
+        return;
+    }
+
+    if (cp == invalidCodepoint && _clusters.size() >= clusterCapacity)
+    {
+        return;
+    }
+
+    _clusters.insert_or_assign(std::wstring{ cluster }, fontFace);
+}
 
-    for (size_t i = offBeg; i < offEnd; ++i)
+void AtlasEngine::FontFallbackCache::Clear() noexcept
+{
+    _primary.reset();
+    for (auto& plane : _primaryCoverage)
     {
-        const auto col = _api.bufferLineColumn[i];
-        row.colors.emplace_back(colors[static_cast<size_t>(col) << shift]);
+        plane = {};
     }
+    _clusters.clear();
+}
 
-    row.mappings.emplace_back(nullptr, gsl::narrow_cast<u32>(initialIndicesCount), gsl::narrow_cast<u32>(row.glyphIndices.size()));
+size_t AtlasEngine::FontFallbackCache::ClusterHash::operator()(const std::wstring_view str) const noexcept
+{
+    return til::hasher{}.write(str.data(), str.size()).finalize();
+}
+
+// Returns the codepoint if the cluster consists of exactly one, and invalidCodepoint otherwise.
+char32_t AtlasEngine::FontFallbackCache::_codepoint(const std::wstring_view cluster) noexcept
+{
+    if (cluster.size() == 1 && !til::is_surrogate(cluster[0]))
+    {
+        return cluster[0];
+    }
+    if (cluster.size() == 2 && til::is_leading_surrogate(cluster[0]) && til::is_trailing_surrogate(cluster[1]))
+    {
+        return til::combine_surrogates(cluster[0], cluster[1]);
+    }
+    return invalidCodepoint;
 }
 
 void AtlasEngine::_mapCharacters(const wchar_t* text, const u32 textLength, u32* mappedLength, IDWriteFontFace2** mappedFontFace) const
@@ -1019,7 +1250,7 @@ void AtlasEngine::_mapCharacters(const wchar_t* text, const u32 textLength, u32*
     assert(scale == 1);
 }
 
-void AtlasEngine::_mapComplex(IDWriteFontFace2* mappedFontFace, u32 idx, u32 length, ShapedRow& row)
+void AtlasEngine::_mapComplex(IDWriteFontFace2* mappedFontFace, u32 idx, u32 length, ShapedSegment& segment)
 {
     _api.analysisResults.clear();
 
@@ -1129,8 +1360,6 @@ void AtlasEngine::_mapComplex(IDWriteFontFace2* mappedFontFace, u32 idx, u32 len
 
         _api.clusterMap[a.textLength] = gsl::narrow_cast<u16>(actualGlyphCount);
 
-        const auto shift = gsl::narrow_cast<u8>(row.lineRendition != LineRendition::SingleWidth);
-        const auto colors = _p.foregroundBitmap.begin() + _p.colorBitmapRowStride * _api.lastPaintBufferLineCoord.y;
         auto prevCluster = _api.clusterMap[0];
         size_t beg = 0;
 
@@ -1142,9 +1371,8 @@ void AtlasEngine::_mapComplex(IDWriteFontFace2* mappedFontFace, u32 idx, u32 len
                 continue;
             }
 
-            const size_t col1 = _api.bufferLineColumn[a.textPosition + beg];
-            const size_t col2 = _api.bufferLineColumn[a.textPosition + i];
-            const auto fg = colors[col1 << shift];
+            const auto col1 = _api.bufferLineColumn[a.textPosition + beg];
+            const auto col2 = _api.bufferLineColumn[a.textPosition + i];
 
             const auto expectedAdvance = (col2 - col1) * _p.s->font->cellSize.x;
             f32 actualAdvance = 0;
@@ -1154,19 +1382,19 @@ void AtlasEngine::_mapComplex(IDWriteFontFace2* mappedFontFace, u32 idx, u32 len
             }
             _api.glyphAdvances[nextCluster - 1] += expectedAdvance - actualAdvance;
 
-            row.colors.insert(row.colors.end(), nextCluster - prevCluster, fg);
+            segment.glyphColumns.insert(segment.glyphColumns.end(), nextCluster - prevCluster, col1);
 
             prevCluster = nextCluster;
             beg = i;
         }
 
-        row.glyphIndices.insert(row.glyphIndices.end(), _api.glyphIndices.begin(), _api.glyphIndices.begin() + actualGlyphCount);
-        row.glyphAdvances.insert(row.glyphAdvances.end(), _api.glyphAdvances.begin(), _api.glyphAdvances.begin() + actualGlyphCount);
-        row.glyphOffsets.insert(row.glyphOffsets.end(), _api.glyphOffsets.begin(), _api.glyphOffsets.begin() + actualGlyphCount);
+        segment.glyphIndices.insert(segment.glyphIndices.end(), _api.glyphIndices.begin(), _api.glyphIndices.begin() + actualGlyphCount);
+        segment.glyphAdvances.insert(segment.glyphAdvances.end(), _api.glyphAdvances.begin(), _api.glyphAdvances.begin() + actualGlyphCount);
+        segment.glyphOffsets.insert(segment.glyphOffsets.end(), _api.glyphOffsets.begin(), _api.glyphOffsets.begin() + actualGlyphCount);
     }
 }
 
-void AtlasEngine::_mapReplacementCharacter(u32 from, u32 to, ShapedRow& row)
+void AtlasEngine::_mapReplacementCharacter(u32 from, u32 to, ShapedSegment& segment)
 {
     if (!_api.replacementCharacterLookedUp)
     {
@@ -1197,9 +1425,7 @@ void AtlasEngine::_mapReplacementCharacter(u32 from, u32 to, ShapedRow& row)
 
     auto pos = from;
     auto col1 = _api.bufferLineColumn[from];
-    auto initialIndicesCount = row.glyphIndices.size();
-    const auto shift = gsl::narrow_cast<u8>(row.lineRendition != LineRendition::SingleWidth);
-    const auto colors = _p.foregroundBitmap.begin() + _p.colorBitmapRowStride * _api.lastPaintBufferLineCoord.y;
+    auto initialIndicesCount = segment.glyphIndices.size();
 
     while (pos < to)
     {
@@ -1209,21 +1435,21 @@ void AtlasEngine::_mapReplacementCharacter(u32 from, u32 to, ShapedRow& row)
             continue;
         }
 
-        row.glyphIndices.emplace_back(_api.replacementCharacterGlyphIndex);
-        row.glyphAdvances.emplace_back(static_cast<f32>((col2 - col1) * _p.s->font->cellSize.x));
-        row.glyphOffsets.emplace_back();
-        row.colors.emplace_back(colors[static_cast<size_t>(col1) << shift]);
+        segment.glyphIndices.emplace_back(_api.replacementCharacterGlyphIndex);
+        segment.glyphAdvances.emplace_back(static_cast<f32>((col2 - col1) * _p.s->font->cellSize.x));
+        segment.glyphOffsets.emplace_back();
+        segment.glyphColumns.emplace_back(col1);
 
         col1 = col2;
     }
 
     {
-        const auto indicesCount = row.glyphIndices.size();
+        const auto indicesCount = segment.glyphIndices.size();
         const auto fontFace = _api.replacementCharacterFontFace.get();
 
         if (indicesCount > initialIndicesCount)
         {
-            row.mappings.emplace_back(fontFace, gsl::narrow_cast<u32>(initialIndicesCount), gsl::narrow_cast<u32>(indicesCount));
+            segment.mappings.emplace_back(fontFace, gsl::narrow_cast<u32>(initialIndicesCount), gsl::narrow_cast<u32>(indicesCount));
         }
     }
 }
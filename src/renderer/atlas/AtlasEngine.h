@@ -9,6 +9,10 @@
 
 #include "common.h"
 
+#ifdef UNIT_TESTING
+class AtlasEngineTests;
+#endif
+
 namespace Microsoft::Console::Render::Atlas
 {
     struct TextAnalysisSinkResult;
@@ -58,11 +62,19 @@ namespace Microsoft::Console::Render::Atlas
         [[nodiscard]] HRESULT UpdateTitle(std::wstring_view newTitle) noexcept override;
         void UpdateHyperlinkHoveredId(uint16_t hoveredId) noexcept override;
 
+        struct ShapedRowCacheStats
+        {
+            u64 hits = 0;
+            u64 misses = 0;
+        };
+
         // getter
         [[nodiscard]] std::wstring_view GetPixelShaderPath() noexcept;
         [[nodiscard]] bool GetRetroTerminalEffect() const noexcept;
         [[nodiscard]] Types::Viewport GetViewportInCharacters(const Types::Viewport& viewInPixels) const noexcept;
         [[nodiscard]] Types::Viewport GetViewportInPixels(const Types::Viewport& viewInCharacters) const noexcept;
+        [[nodiscard]] ShapedRowCacheStats GetShapedRowCacheStats() const noexcept;
+        [[nodiscard]] GlyphAtlasStats GetGlyphAtlasStats() const noexcept;
         // setter
         void SetAntialiasingMode(D2D1_TEXT_ANTIALIAS_MODE antialiasingMode) noexcept;
         void SetCallback(std::function<void(HANDLE)> pfn) noexcept;
@@ -79,16 +91,99 @@ namespace Microsoft::Console::Render::Atlas
         [[nodiscard]] HRESULT UpdateFont(const FontInfoDesired& pfiFontInfoDesired, FontInfo& fiFontInfo, const std::unordered_map<std::wstring_view, float>& features, const std::unordered_map<std::wstring_view, float>& axes) noexcept;
 
     private:
+        // The glyphs that _flushBufferLine() produced for a segment of a row. It's the same as the corresponding part of a
+        // ShapedRow, except that the mappings and columns are relative to the start of the segment and that it stores
+        // the column each glyph takes its color from instead of the color itself. This allows ShapedRowCache to reuse it.
+        struct ShapedSegment
+        {
+            void Clear() noexcept
+            {
+                mappings.clear();
+                glyphIndices.clear();
+                glyphAdvances.clear();
+                glyphOffsets.clear();
+                glyphColumns.clear();
+            }
+
+            std::vector<FontMapping> mappings;
+            std::vector<u16> glyphIndices;
+            std::vector<f32> glyphAdvances;
+            std::vector<DWRITE_GLYPH_OFFSET> glyphOffsets;
+            std::vector<u16> glyphColumns;
+        };
+
+        // An LRU cache of recently shaped segments, keyed by their text, columns and font attributes.
+        // Scrolling and repainting mostly shows text that was shaped in a previous frame. A hit skips
+        // font fallback and shaping entirely. It must be cleared whenever the font changes.
+        struct ShapedRowCache
+        {
+            const ShapedSegment* Find(FontRelevantAttributes attributes, const std::vector<wchar_t>& text, const std::vector<u16>& columns);
+            void Insert(FontRelevantAttributes attributes, const std::vector<wchar_t>& text, const std::vector<u16>& columns, const ShapedSegment& segment);
+            void Clear() noexcept;
+
+            ShapedRowCacheStats stats;
+
+        private:
+            struct Entry
+            {
+                size_t hash = 0;
+                FontRelevantAttributes attributes = FontRelevantAttributes::None;
+                std::vector<wchar_t> text;
+                std::vector<u16> columns;
+                ShapedSegment segment;
+            };
+
+            // A segment is usually an entire row, so this is enough to cover a few screens worth of text.
+            static constexpr size_t capacity = 1024;
+
+            static size_t _hash(FontRelevantAttributes attributes, const std::vector<wchar_t>& text, const std::vector<u16>& columns) noexcept;
+
+            // Ordered from the most to the least recently used entry.
+            std::list<Entry> _lru;
+            std::unordered_map<size_t, std::list<Entry>::iterator> _map;
+        };
+
+        // Remembers which font face IDWriteFontFallback::MapCharacters() picked for each cluster. There's one per
+        // FontRelevantAttributes. Clusters that map to the primary font are tracked in a bitmap per Unicode plane
+        // and everything else in a hash map. It must be cleared whenever the font changes.
+        struct FontFallbackCache
+        {
+            bool Find(std::wstring_view cluster, IDWriteFontFace2*& fontFace) const;
+            void Insert(std::wstring_view cluster, IDWriteFontFace2* fontFace);
+            void Clear() noexcept;
+
+        private:
+            struct ClusterHash
+            {
+                using is_transparent = void;
+                size_t operator()(std::wstring_view str) const noexcept;
+            };
+
+            static constexpr char32_t invalidCodepoint = 0xffffffff;
+            // Bounds the memory that unique combining sequences can use up. Single codepoints are always cached.
+            static constexpr size_t clusterCapacity = 16 * 1024;
+
+            static char32_t _codepoint(std::wstring_view cluster) noexcept;
+
+            // The first font face that was inserted. In practice that's the primary font.
+            wil::com_ptr<IDWriteFontFace2> _primary;
+            // 1 bit per codepoint. A plane is only allocated once one of its codepoints maps to _primary.
+            std::array<std::vector<u64>, 17> _primaryCoverage;
+            std::unordered_map<std::wstring, wil::com_ptr<IDWriteFontFace2>, ClusterHash, std::equal_to<>> _clusters;
+        };
+
         // AtlasEngine.cpp
         ATLAS_ATTR_COLD void _handleSettingsUpdate();
         void _recreateFontDependentResources();
         void _recreateCellCountDependentResources();
         void _flushBufferLine();
+        void _appendShapedSegment(ShapedRow& row, const ShapedSegment& segment, u16 x);
         void _mapRegularText(size_t offBeg, size_t offEnd);
         void _mapBuiltinGlyphs(size_t offBeg, size_t offEnd);
+        void _mapCharactersCached(u32 idx, u32 end, u32* mappedLength, IDWriteFontFace2** mappedFontFace);
         void _mapCharacters(const wchar_t* text, u32 textLength, u32* mappedLength, IDWriteFontFace2** mappedFontFace) const;
-        void _mapComplex(IDWriteFontFace2* mappedFontFace, u32 idx, u32 length, ShapedRow& row);
-        ATLAS_ATTR_COLD void _mapReplacementCharacter(u32 from, u32 to, ShapedRow& row);
+        void _mapComplex(IDWriteFontFace2* mappedFontFace, u32 idx, u32 length, ShapedSegment& segment);
+        ATLAS_ATTR_COLD void _mapReplacementCharacter(u32 from, u32 to, ShapedSegment& segment);
         void _fillColorBitmap(const size_t y, const size_t x1, const size_t x2, const u32 fgColor, const u32 bgColor) noexcept;
         [[nodiscard]] HRESULT _drawHighlighted(std::span<const til::point_span>& highlights, const u16 row, const u16 begX, const u16 endX, const u32 fgColor, const u32 bgColor) noexcept;
 
@@ -150,6 +245,9 @@ namespace Microsoft::Console::Render::Atlas
             Buffer<DWRITE_SHAPING_GLYPH_PROPERTIES> glyphProps;
             Buffer<f32> glyphAdvances;
             Buffer<DWRITE_GLYPH_OFFSET> glyphOffsets;
+            ShapedSegment shapedSegment;
+            ShapedRowCache shapedRowCache;
+            std::array<FontFallbackCache, 4> fontFallbackCache;
 
             wil::com_ptr<IDWriteFontFallback> systemFontFallback;
             wil::com_ptr<IDWriteFontFace2> replacementCharacterFontFace;
@@ -182,6 +280,10 @@ namespace Microsoft::Console::Render::Atlas
             // The position of the viewport inside the text buffer (in cells).
             u16x2 viewportOffset{ 0, 0 };
         } _api;
+
+#ifdef UNIT_TESTING
+        friend class ::AtlasEngineTests;
+#endif
     };
 }
 
@@ -74,6 +74,12 @@ bool BackendD2D::RequiresContinuousRedraw() noexcept
     return false;
 }
 
+// Direct2D caches glyphs on its own. There's no glyph atlas in this backend.
+GlyphAtlasStats BackendD2D::GetGlyphAtlasStats() const noexcept
+{
+    return {};
+}
+
 void BackendD2D::_handleSettingsUpdate(const RenderingPayload& p)
 {
     const auto renderTargetChanged = !_renderTarget;
@@ -15,6 +15,7 @@ namespace Microsoft::Console::Render::Atlas
         void ReleaseResources() noexcept override;
         void Render(RenderingPayload& payload) override;
         bool RequiresContinuousRedraw() noexcept override;
+        GlyphAtlasStats GetGlyphAtlasStats() const noexcept override;
 
     private:
         ATLAS_ATTR_COLD void _handleSettingsUpdate(const RenderingPayload& p);
@@ -63,6 +63,41 @@ static u64 queryPerfCount() noexcept
     return std::bit_cast<u64>(li.QuadPart);
 }
 
+// til::linear_flat_set can't erase individual items, so this rebuilds the set without those for which pred() returns true.
+// key() must return the key that an item was inserted with. Returns the number of erased items.
+template<typename T, typename Traits, typename Pred, typename Key>
+static size_t eraseIf(til::linear_flat_set<T, Traits>& set, Pred&& pred, Key&& key)
+{
+    std::vector<T> kept;
+    size_t erased = 0;
+
+    for (const auto& item : set.container())
+    {
+        if (Traits::occupied(item))
+        {
+            if (pred(item))
+            {
+                ++erased;
+            }
+            else
+            {
+                kept.emplace_back(item);
+            }
+        }
+    }
+
+    if (erased)
+    {
+        set.clear();
+        for (const auto& item : kept)
+        {
+            *set.insert(key(item)).first = item;
+        }
+    }
+
+    return erased;
+}
+
 BackendD3D::BackendD3D(const RenderingPayload& p)
 {
     THROW_IF_FAILED(p.device->CreateVertexShader(&shader_vs[0], sizeof(shader_vs), nullptr, _vertexShader.addressof()));
@@ -245,6 +280,11 @@ bool BackendD3D::RequiresContinuousRedraw() noexcept
     return _requiresContinuousRedraw;
 }
 
+GlyphAtlasStats BackendD3D::GetGlyphAtlasStats() const noexcept
+{
+    return _glyphAtlasStats;
+}
+
 void BackendD3D::_handleSettingsUpdate(const RenderingPayload& p)
 {
     if (!_renderTargetView)
@@ -739,7 +779,9 @@ void BackendD3D::_d2dEndDrawing()
     }
 }
 
-void BackendD3D::_resetGlyphAtlas(const RenderingPayload& p, u32 minWidth, u32 minHeight)
+// Returns the size the glyph atlas should have, given that it needs to fit a glyph of minWidth x minPageHeight
+// on a single page. If this returns the current size, the atlas can't grow any further.
+u16x2 BackendD3D::_glyphAtlasTargetSize(const RenderingPayload& p, u32 minWidth, u32 minPageHeight) const noexcept
 {
     // The index returned by _BitScanReverse is undefined when the input is 0. We can simultaneously guard
     // against that and avoid unreasonably small textures, by clamping the min. texture size to `minArea`.
@@ -751,7 +793,7 @@ void BackendD3D::_resetGlyphAtlas(const RenderingPayload& p, u32 minWidth, u32 m
     const auto targetArea = static_cast<u32>(p.s->targetSize.x) * p.s->targetSize.y;
 
     const auto minAreaByFont = cellArea * 95; // Covers all printable ASCII characters
-    const auto minAreaByGrowth = static_cast<u32>(_rectPacker.width) * _rectPacker.height * 2;
+    const auto minAreaByGrowth = static_cast<u32>(_glyphAtlasSize.x) * _glyphAtlasSize.y * 2;
 
     // It's hard to say what the max. size of the cache should be. Optimally I think we should use as much
     // memory as is available, but the rendering code in this project is a big mess and so integrating
@@ -771,6 +813,9 @@ void BackendD3D::_resetGlyphAtlas(const RenderingPayload& p, u32 minWidth, u32 m
     auto u = static_cast<u16>(1u << ((index + 2) / 2));
     auto v = static_cast<u16>(1u << ((index + 1) / 2));
 
+    // Every page should at least fit a double-height (DECDHL) row of glyphs.
+    const auto minHeight = std::max<u32>(minPageHeight, 2u * p.s->font->cellSize.y) * glyphAtlasPageCount;
+
     // However, if we're asked for a specific minimum size, round up the u/v to the next power of 2 of the given size.
     // Because u/v cannot ever be less than sqrt(minArea), the _BitScanReverse() calls below cannot fail.
     if (u < minWidth)
@@ -781,15 +826,32 @@ void BackendD3D::_resetGlyphAtlas(const RenderingPayload& p, u32 minWidth, u32 m
     if (v < minHeight)
     {
         _BitScanReverse(&index, minHeight - 1);
-        v = 1u << (index + 1);
+        v = static_cast<u16>(std::min<u32>(1u << (index + 1), D3D10_REQ_TEXTURE2D_U_OR_V_DIMENSION));
     }
 
-    if (u != _rectPacker.width || v != _rectPacker.height)
+    return { u, v };
+}
+
+void BackendD3D::_resetGlyphAtlas(const RenderingPayload& p, u32 minWidth, u32 minPageHeight)
+{
+    const auto size = _glyphAtlasTargetSize(p, minWidth, minPageHeight);
+    if (size != _glyphAtlasSize)
     {
-        _resizeGlyphAtlas(p, u, v);
+        _resizeGlyphAtlas(p, size.x, size.y);
     }
 
-    stbrp_init_target(&_rectPacker, u, v, _rectPackerData.data(), _rectPackerData.size());
+    // The atlas height is a power of 2 and so is the page height.
+    const auto pageHeight = size.y / glyphAtlasPageCount;
+    unsigned long index;
+    _BitScanReverse(&index, pageHeight);
+    _glyphAtlasPageShift = static_cast<u8>(index);
+
+    for (size_t i = 0; i < glyphAtlasPageCount; ++i)
+    {
+        auto& page = _glyphAtlasPages[i];
+        stbrp_init_target(&page.packer, size.x, pageHeight, _rectPackerData.data() + i * size.x, size.x);
+        page.lastUsed = 0;
+    }
 
     // This is a little imperfect, because it only releases the memory of the glyph mappings, not the memory held by
     // any DirectWrite fonts. On the other side, the amount of fonts on a system is always finite, where "finite"
@@ -812,6 +874,7 @@ void BackendD3D::_resetGlyphAtlas(const RenderingPayload& p, u32 minWidth, u32 m
     _d2dRenderTarget->Clear();
 
     _fontChangedResetGlyphAtlas = false;
+    _glyphAtlasStats.resets++;
 }
 
 void BackendD3D::_resizeGlyphAtlas(const RenderingPayload& p, const u16 u, const u16 v)
@@ -886,7 +949,66 @@ void BackendD3D::_resizeGlyphAtlas(const RenderingPayload& p, const u16 u, const
     ID3D11ShaderResourceView* resources[]{ _backgroundBitmapView.get(), _glyphAtlasView.get() };
     p.deviceContext->PSSetShaderResources(0, 2, &resources[0]);
 
-    _rectPackerData = Buffer<stbrp_node>{ u };
+    _rectPackerData = Buffer<stbrp_node>{ size_t{ u } * glyphAtlasPageCount };
+    _glyphAtlasSize = { u, v };
+}
+
+// Drops all glyphs and bitmaps on the given page and clears its area of the atlas. The caller
+// must have flushed all quads beforehand, since some of them might still refer to the page.
+void BackendD3D::_evictGlyphAtlasPage(const size_t index)
+{
+    const auto isOnPage = [&](u16 texcoordY) {
+        return static_cast<size_t>(texcoordY >> _glyphAtlasPageShift) == index;
+    };
+    const auto isGlyphOnPage = [&](const AtlasGlyphEntry& entry) {
+        // Whitespace glyphs don't occupy any space in the atlas.
+        return entry.shadingType != ShadingType::Default && isOnPage(entry.texcoord.y);
+    };
+    const auto glyphKey = [](const AtlasGlyphEntry& entry) {
+        return entry.glyphIndex;
+    };
+
+    size_t evicted = 0;
+    for (auto& slot : _glyphAtlasMap.container())
+    {
+        for (auto& glyphs : slot.glyphs)
+        {
+            evicted += eraseIf(glyphs, isGlyphOnPage, glyphKey);
+        }
+    }
+    for (auto& glyphs : _builtinGlyphs.glyphs)
+    {
+        evicted += eraseIf(glyphs, isGlyphOnPage, glyphKey);
+    }
+    evicted += eraseIf(
+        _glyphAtlasBitmaps,
+        [&](const AtlasBitmap& bitmap) { return isOnPage(bitmap.texcoord.y); },
+        [](const AtlasBitmap& bitmap) { return bitmap.key; });
+
+    const auto pageHeight = 1u << _glyphAtlasPageShift;
+    auto& page = _glyphAtlasPages[index];
+    stbrp_init_target(&page.packer, _glyphAtlasSize.x, pageHeight, _rectPackerData.data() + index * _glyphAtlasSize.x, _glyphAtlasSize.x);
+    page.lastUsed = _glyphAtlasFrame;
+
+    // _drawGlyph() may have set a transform for line renditions already, which would apply to the clip rect.
+    D2D1_MATRIX_3X2_F transform;
+    _d2dBeginDrawing();
+    _d2dRenderTarget->GetTransform(&transform);
+    _d2dRenderTarget->SetTransform(&identityTransform);
+
+    const D2D1_RECT_F rect{
+        0,
+        static_cast<f32>(index * pageHeight),
+        static_cast<f32>(_glyphAtlasSize.x),
+        static_cast<f32>((index + 1) * pageHeight),
+    };
+    _d2dRenderTarget->PushAxisAlignedClip(&rect, D2D1_ANTIALIAS_MODE_ALIASED);
+    _d2dRenderTarget->Clear();
+    _d2dRenderTarget->PopAxisAlignedClip();
+    _d2dRenderTarget->SetTransform(&transform);
+
+    _glyphAtlasStats.pageEvictions++;
+    _glyphAtlasStats.evictedGlyphs += evicted;
 }
 
 // MacType is a popular 3rd party system to give the font rendering on Windows a softer look.
@@ -1102,6 +1224,8 @@ void BackendD3D::_drawText(RenderingPayload& p)
         _resetGlyphAtlas(p, 0, 0);
     }
 
+    _glyphAtlasFrame++;
+
     til::CoordType dirtyTop = til::CoordTypeMax;
     til::CoordType dirtyBottom = til::CoordTypeMin;
 
@@ -1166,6 +1290,8 @@ void BackendD3D::_drawText(RenderingPayload& p)
                 // A shadingType of 0 (ShadingType::Default) indicates a glyph that is whitespace.
                 if (glyphEntry->shadingType != ShadingType::Default)
                 {
+                    _glyphAtlasPages[glyphEntry->texcoord.y >> _glyphAtlasPageShift].lastUsed = _glyphAtlasFrame;
+
                     auto l = static_cast<til::CoordType>(lrintf((baselineX + row->glyphOffsets[x].advanceOffset) * scaleX));
                     auto t = static_cast<til::CoordType>(lrintf((baselineY - row->glyphOffsets[x].ascenderOffset) * scaleY));
 
@@ -1694,21 +1820,56 @@ BackendD3D::ShadingType BackendD3D::_drawSoftFontGlyph(const RenderingPayload& p
 
 void BackendD3D::_drawGlyphAtlasAllocate(const RenderingPayload& p, stbrp_rect& rect)
 {
-    if (stbrp_pack_rects(&_rectPacker, &rect, 1))
+    if (_drawGlyphAtlasPack(rect))
     {
         return;
     }
 
     _d2dEndDrawing();
     _flushQuads(p);
-    _resetGlyphAtlas(p, rect.w, rect.h);
 
-    if (!stbrp_pack_rects(&_rectPacker, &rect, 1))
+    // While the atlas can still grow, it's reset at twice the size, which is cheap at that point and means that
+    // most sessions never evict anything. After that only the least recently used page is dropped, so that
+    // output cycling through lots of distinct glyphs doesn't re-rasterize all of them over and over again.
+    if (_glyphAtlasTargetSize(p, rect.w, rect.h) == _glyphAtlasSize)
+    {
+        size_t lru = 0;
+        for (size_t i = 1; i < glyphAtlasPageCount; ++i)
+        {
+            if (_glyphAtlasPages[i].lastUsed < _glyphAtlasPages[lru].lastUsed)
+            {
+                lru = i;
+            }
+        }
+        _evictGlyphAtlasPage(lru);
+    }
+    else
+    {
+        _resetGlyphAtlas(p, rect.w, rect.h);
+    }
+
+    if (!_drawGlyphAtlasPack(rect))
     {
         THROW_HR(HRESULT_FROM_WIN32(ERROR_POSSIBLE_DEADLOCK));
     }
 }
 
+// Packs the rect into the first page with enough space and translates it into atlas coordinates.
+bool BackendD3D::_drawGlyphAtlasPack(stbrp_rect& rect) noexcept
+{
+    for (size_t i = 0; i < glyphAtlasPageCount; ++i)
+    {
+        auto& page = _glyphAtlasPages[i];
+        if (stbrp_pack_rects(&page.packer, &rect, 1))
+        {
+            rect.y += static_cast<int>(i << _glyphAtlasPageShift);
+            page.lastUsed = _glyphAtlasFrame;
+            return true;
+        }
+    }
+    return false;
+}
+
 BackendD3D::AtlasGlyphEntry* BackendD3D::_drawGlyphAllocateEntry(const ShapedRow& row, AtlasFontFaceEntry& fontFaceEntry, u32 glyphIndex)
 {
     const auto glyphEntry = fontFaceEntry.glyphs[WI_EnumValue(row.lineRendition)].insert(glyphIndex).first;
@@ -1906,6 +2067,10 @@ void BackendD3D::_drawBitmap(const RenderingPayload& p, const ShapedRow* row, u1
         ab->texcoord.x = static_cast<u16>(rect.x);
         ab->texcoord.y = static_cast<u16>(rect.y);
     }
+    else
+    {
+        _glyphAtlasPages[ab->texcoord.y >> _glyphAtlasPageShift].lastUsed = _glyphAtlasFrame;
+    }
 
     const auto left = p.s->font->cellSize.x * (b.targetOffset - p.scrollOffsetX);
     const auto top = p.s->font->cellSize.y * y;
@@ -18,6 +18,7 @@ namespace Microsoft::Console::Render::Atlas
         void ReleaseResources() noexcept override;
         void Render(RenderingPayload& payload) override;
         bool RequiresContinuousRedraw() noexcept override;
+        GlyphAtlasStats GetGlyphAtlasStats() const noexcept override;
 
         // NOTE: D3D constant buffers sizes must be a multiple of 16 bytes.
         struct alignas(16) VSConstBuffer
@@ -216,6 +217,13 @@ namespace Microsoft::Console::Render::Atlas
         };
 
     private:
+        struct AtlasPage
+        {
+            stbrp_context packer;
+            // The value of _glyphAtlasFrame when a glyph on this page was last drawn.
+            u64 lastUsed;
+        };
+
         struct CursorRect
         {
             i16x2 position;
@@ -237,8 +245,10 @@ namespace Microsoft::Console::Render::Atlas
         void _debugDumpRenderTarget(const RenderingPayload& p);
         void _d2dBeginDrawing() noexcept;
         void _d2dEndDrawing();
-        ATLAS_ATTR_COLD void _resetGlyphAtlas(const RenderingPayload& p, u32 minWidth, u32 minHeight);
+        u16x2 _glyphAtlasTargetSize(const RenderingPayload& p, u32 minWidth, u32 minPageHeight) const noexcept;
+        ATLAS_ATTR_COLD void _resetGlyphAtlas(const RenderingPayload& p, u32 minWidth, u32 minPageHeight);
         ATLAS_ATTR_COLD void _resizeGlyphAtlas(const RenderingPayload& p, u16 u, u16 v);
+        ATLAS_ATTR_COLD void _evictGlyphAtlasPage(size_t index);
         static bool _checkMacTypeVersion(const RenderingPayload& p);
         QuadInstance& _getLastQuad() noexcept;
         QuadInstance& _appendQuad();
@@ -253,6 +263,7 @@ namespace Microsoft::Console::Render::Atlas
         AtlasGlyphEntry* _drawBuiltinGlyph(const RenderingPayload& p, const ShapedRow& row, AtlasFontFaceEntry& fontFaceEntry, u32 glyphIndex);
         ShadingType _drawSoftFontGlyph(const RenderingPayload& p, const D2D1_RECT_F& rect, u32 glyphIndex);
         void _drawGlyphAtlasAllocate(const RenderingPayload& p, stbrp_rect& rect);
+        bool _drawGlyphAtlasPack(stbrp_rect& rect) noexcept;
         static AtlasGlyphEntry* _drawGlyphAllocateEntry(const ShapedRow& row, AtlasFontFaceEntry& fontFaceEntry, u32 glyphIndex);
         static void _splitDoubleHeightGlyph(const RenderingPayload& p, const ShapedRow& row, AtlasFontFaceEntry& fontFaceEntry, AtlasGlyphEntry* glyphEntry);
         ATLAS_ATTR_COLD void _drawGridlines(const RenderingPayload& p, u16 y);
@@ -298,8 +309,15 @@ namespace Microsoft::Console::Render::Atlas
         til::linear_flat_set<AtlasFontFaceEntry, AtlasFontFaceEntryHashTrait> _glyphAtlasMap;
         til::linear_flat_set<AtlasBitmap, AtlasBitmapHashTrait> _glyphAtlasBitmaps;
         AtlasFontFaceEntry _builtinGlyphs;
+        // The glyph atlas is split into horizontal pages of equal height with one rect packer each.
+        // Once the atlas can't grow anymore, the least recently used page is evicted, instead of clearing everything.
+        static constexpr size_t glyphAtlasPageCount = 8;
+        std::array<AtlasPage, glyphAtlasPageCount> _glyphAtlasPages{};
         Buffer<stbrp_node> _rectPackerData;
-        stbrp_context _rectPacker{};
+        u16x2 _glyphAtlasSize{};
+        u8 _glyphAtlasPageShift = 0; // log2 of the page height
+        u64 _glyphAtlasFrame = 0;
+        GlyphAtlasStats _glyphAtlasStats;
         til::CoordType _ligatureOverhangTriggerLeft = 0;
         til::CoordType _ligatureOverhangTriggerRight = 0;
 
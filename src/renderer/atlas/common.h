@@ -593,11 +593,21 @@ namespace Microsoft::Console::Render::Atlas
         }
     };
 
+    struct GlyphAtlasStats
+    {
+        // How often the glyph atlas was cleared entirely, because the font changed or because it had to grow.
+        u64 resets = 0;
+        // How often a single page of the glyph atlas was evicted, and how many glyphs and bitmaps were dropped that way.
+        u64 pageEvictions = 0;
+        u64 evictedGlyphs = 0;
+    };
+
     struct IBackend
     {
         virtual ~IBackend() = default;
         virtual void ReleaseResources() noexcept = 0;
         virtual void Render(RenderingPayload& payload) = 0;
         virtual bool RequiresContinuousRedraw() noexcept = 0;
+        virtual GlyphAtlasStats GetGlyphAtlasStats() const noexcept = 0;
     };
 }
@@ -8,6 +8,7 @@
 
 #include <filesystem>
 #include <functional>
+#include <list>
 #include <optional>
 #include <shared_mutex>
 #include <span>
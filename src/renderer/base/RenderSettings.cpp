@@ -277,6 +277,14 @@ COLORREF RenderSettings::GetAttributeUnderlineColor(const TextAttribute& attr) c
     return ul;
 }
 
+// Routine Description:
+// - Records that blinking cells are in view. GetAttributeColors() does this implicitly,
+//   but the renderer may call it on a copy of these settings. See Renderer::_snapshotFrame().
+void RenderSettings::SetBlinkInUse() const noexcept
+{
+    _blinkIsInUse = true;
+}
+
 // Routine Description:
 // - Increments the position in the blink cycle, toggling the blink rendition
 //   state on every second call, potentially triggering a redraw of the given
@@ -112,30 +112,100 @@ IRenderData* Renderer::GetRenderData() const noexcept
 
 [[nodiscard]] HRESULT Renderer::_PaintFrame() noexcept
 {
+    _pData->LockConsole();
+    auto unlock = wil::scope_exit([&]() {
+        _pData->UnlockConsole();
+    });
+
+    // The console lock is only held until the frame was snapshotted, while _engineLock is held until the
+    // engines are done painting. Anyone who wants to call into the engines in the meantime has to wait.
+    auto engineLock = _lockEngines();
+    auto releaseEngines = wil::scope_exit([&]() {
+        // Apply the notifications that were deferred while we were painting, before anyone else gets to call into the engines.
+        const auto deferredLock = _deferredLock.lock_exclusive();
+        _applyDeferredNotifications();
+        engineLock.reset();
+    });
+
+    // Last chance check if anything scrolled without an explicit invalidate notification since the last frame.
+    _CheckViewportAndScroll();
+
+    // Text written since the last frame. This has to happen after scrolling the engines,
+    // because the damage is in buffer coordinates and doesn't move along with their contents.
+    _damage.clear();
+    _pData->GetTextBuffer().TakeDamage(_damage);
+    for (const auto& rect : _damage)
     {
-        _pData->LockConsole();
-        auto unlock = wil::scope_exit([&]() {
-            _pData->UnlockConsole();
-        });
+        _invalidateBufferRegion(rect);
+    }
 
-        // Last chance check if anything scrolled without an explicit invalidate notification since the last frame.
-        _CheckViewportAndScroll();
+    _invalidateCurrentCursor(); // Invalidate the previous cursor position.
+    _invalidateOldComposition();
 
-        _invalidateCurrentCursor(); // Invalidate the previous cursor position.
-        _invalidateOldComposition();
+    _updateCursorInfo();
+    _compositionCache.reset();
 
-        _updateCursorInfo();
-        _compositionCache.reset();
+    _invalidateCurrentCursor(); // Invalidate the new cursor position.
+    _prepareNewComposition();
 
-        _invalidateCurrentCursor(); // Invalidate the new cursor position.
-        _prepareNewComposition();
+    // Try to start painting a frame.
+    // The engines' dirty areas are final after this, which tells us which rows _snapshotFrame() needs to copy.
+    _frame.engines.clear();
+    FOREACH_ENGINE(pEngine)
+    {
+        const auto hr = pEngine->StartPaint();
+        if (FAILED(hr))
+        {
+            for (const auto started : _frame.engines)
+            {
+                LOG_IF_FAILED(started->EndPaint());
+            }
+            return hr;
+        }
 
-        FOREACH_ENGINE(pEngine)
+        // S_FALSE means that there's nothing to paint.
+        // The renderer itself tracks if there's something to do with the title, the engine won't know that.
+        if (hr == S_OK)
         {
-            RETURN_IF_FAILED(_PaintFrameForEngine(pEngine));
+            _frame.engines.emplace_back(pEngine);
         }
     }
 
+    auto endPaint = wil::scope_exit([&]() {
+        for (const auto pEngine : _frame.engines)
+        {
+            LOG_IF_FAILED(pEngine->EndPaint());
+
+            // If the engine tells us it really wants to redraw immediately,
+            // tell the thread so it doesn't go to sleep and ticks again
+            // at the next opportunity.
+            if (pEngine->RequiresContinuousRedraw())
+            {
+                NotifyPaintFrame();
+            }
+        }
+    });
+
+    try
+    {
+        _snapshotFrame();
+    }
+    CATCH_RETURN();
+
+    unlock.reset();
+
+    // Every engine that started painting gets to finish its frame, even if a previous one failed.
+    auto hr = S_OK;
+    for (const auto pEngine : _frame.engines)
+    {
+        const auto engineHr = _PaintFrameForEngine(pEngine);
+        hr = FAILED(hr) ? hr : engineHr;
+    }
+
+    endPaint.reset();
+    releaseEngines.reset();
+    RETURN_IF_FAILED(hr);
+
     FOREACH_ENGINE(pEngine)
     {
         RETURN_IF_FAILED(pEngine->Present());
@@ -149,29 +219,8 @@ try
 {
     FAIL_FAST_IF_NULL(pEngine); // This is a programming error. Fail fast.
 
-    // Try to start painting a frame
-    const auto hr = pEngine->StartPaint();
-    RETURN_IF_FAILED(hr);
-
-    // Return early if there's nothing to paint.
-    // The renderer itself tracks if there's something to do with the title, the
-    //      engine won't know that.
-    if (S_FALSE == hr)
-    {
-        return S_OK;
-    }
-
-    auto endPaint = wil::scope_exit([&]() {
-        LOG_IF_FAILED(pEngine->EndPaint());
-
-        // If the engine tells us it really wants to redraw immediately,
-        // tell the thread so it doesn't go to sleep and ticks again
-        // at the next opportunity.
-        if (pEngine->RequiresContinuousRedraw())
-        {
-            NotifyPaintFrame();
-        }
-    });
+    // StartPaint() and EndPaint() are called by _PaintFrame().
+    // Everything in here must only read from _frame, since the console isn't locked anymore.
 
     // A. Prep Colors
     RETURN_IF_FAILED(_UpdateDrawingBrushes(pEngine, {}, false, true));
@@ -197,14 +246,192 @@ try
     // 6. Paint window title
     RETURN_IF_FAILED(_PaintTitle(pEngine));
 
-    // Force scope exit end paint to finish up collecting information and possibly painting
-    endPaint.reset();
-
-    // As we leave the scope, EndPaint will be called (declared above)
     return S_OK;
 }
 CATCH_RETURN()
 
+// Routine Description:
+// - Copies everything that painting a frame requires out of _pData into _frame.
+// - Only the rows that are dirty in at least one of the engines are copied.
+void Renderer::_snapshotFrame()
+{
+    const auto& buffer = _pData->GetTextBuffer();
+    const auto view = _pData->GetViewport();
+    const til::size size{ buffer.GetSize().Width(), view.Height() };
+
+    if (!_frame.buffer || _frame.buffer->GetSize().Dimensions() != size)
+    {
+        _frame.buffer = std::make_unique<TextBuffer>(size, TextAttribute{}, 0, false, nullptr);
+    }
+
+    _frame.viewport = view;
+    _frame.renderSettings = _renderSettings;
+    _frame.cursor = _currentCursorOptions;
+    _frame.selectionRects = _lastSelectionRectsByViewport;
+
+    const auto selectionSpans = _pData->GetSelectionSpans();
+    _frame.selectionSpans.assign(selectionSpans.begin(), selectionSpans.end());
+    const auto searchHighlights = _pData->GetSearchHighlights();
+    _frame.searchHighlights.assign(searchHighlights.begin(), searchHighlights.end());
+    const auto searchHighlightFocused = _pData->GetSearchHighlightFocused();
+    _frame.searchHighlightFocused = searchHighlightFocused ? std::optional{ *searchHighlightFocused } : std::nullopt;
+
+    _frame.title = _pData->GetConsoleTitle();
+    _frame.gridLinesAllowed = _pData->IsGridLineDrawingAllowed();
+    _frame.patternIds.clear();
+
+    std::vector<bool> dirtyRows(gsl::narrow_cast<size_t>(size.height));
+    for (const auto pEngine : _frame.engines)
+    {
+        std::span<const til::rect> dirtyAreas;
+        LOG_IF_FAILED(pEngine->GetDirtyArea(dirtyAreas));
+
+        for (const auto& dirtyRect : dirtyAreas)
+        {
+            for (auto y = std::max(dirtyRect.top, 0); y < std::min(dirtyRect.bottom, size.height); ++y)
+            {
+                dirtyRows[gsl::narrow_cast<size_t>(y)] = true;
+            }
+        }
+    }
+
+    const auto compositionRow = _compositionCache ? _compositionCache->absoluteOrigin.y : -1;
+    auto blinking = false;
+
+    for (til::CoordType y = 0; y < size.height; ++y)
+    {
+        if (!dirtyRows[gsl::narrow_cast<size_t>(y)])
+        {
+            continue;
+        }
+
+        const auto& src = buffer.GetRowByOffset(view.Top() + y);
+        auto& dst = _frame.buffer->GetMutableRowByOffset(y);
+        dst.Reset(TextAttribute{});
+        dst.CopyFrom(src);
+        ImageSlice::CopyRow(src, dst);
+
+        if (view.Top() + y == compositionRow)
+        {
+            _overlayComposition(dst);
+        }
+
+        for (const auto& run : dst.Attributes().runs())
+        {
+            blinking = blinking || run.value.IsBlinking();
+        }
+
+        // GetPatternId() is called with the same coordinates that the painting code uses:
+        // The x coordinate is a buffer column and the y coordinate is relative to the viewport.
+        for (til::CoordType x = 0; x < size.width; ++x)
+        {
+            auto ids = _pData->GetPatternId({ x, y });
+            if (!ids.empty())
+            {
+                _frame.patternIds.resize(gsl::narrow_cast<size_t>(size.area()));
+                _frame.patternIds[gsl::narrow_cast<size_t>(y * size.width + x)] = std::move(ids);
+            }
+        }
+    }
+
+    // GetAttributeColors() tracks whether any blinking content is visible, but the engines
+    // call it on _frame.renderSettings. RenderSettings::ToggleBlinkRendition() needs to know.
+    if (blinking)
+    {
+        _renderSettings.SetBlinkInUse();
+    }
+}
+
+// Routine Description:
+// - Writes the active composition into the given row (a copy of the row at the cursor in the snapshot).
+void Renderer::_overlayComposition(ROW& row) const
+{
+    const auto& activeComposition = _pData->GetActiveComposition();
+    std::wstring_view text{ activeComposition.text };
+    RowWriteState state{
+        .columnLimit = row.GetReadableColumnCount(),
+        .columnEnd = _compositionCache->absoluteOrigin.x,
+    };
+
+    size_t off = 0;
+    for (const auto& range : activeComposition.attributes)
+    {
+        const auto len = range.len;
+        auto attr = range.attr;
+
+        // Use the color at the cursor if TSF didn't specify any explicit color.
+        if (attr.GetBackground().IsDefault())
+        {
+            attr.SetBackground(_compositionCache->baseAttribute.GetBackground());
+        }
+        if (attr.GetForeground().IsDefault())
+        {
+            attr.SetForeground(_compositionCache->baseAttribute.GetForeground());
+        }
+
+        state.text = text.substr(off, len);
+        state.columnBegin = state.columnEnd;
+        row.ReplaceText(state);
+        row.ReplaceAttributes(state.columnBegin, state.columnEnd, attr);
+        off += len;
+    }
+}
+
+// Routine Description:
+// - Returns the pattern IDs of the given cell of the snapshot. See _snapshotFrame().
+const std::vector<size_t>& Renderer::_framePatternId(const til::point target) const noexcept
+{
+    static const std::vector<size_t> none;
+    const auto width = _frame.buffer->GetSize().Width();
+    const auto index = gsl::narrow_cast<size_t>(target.y * width + target.x);
+    if (target.x < 0 || target.x >= width || target.y < 0 || index >= _frame.patternIds.size())
+    {
+        return none;
+    }
+    return til::at(_frame.patternIds, index);
+}
+
+// Routine Description:
+// - Acquires _engineLock, which must be held while calling into the engines.
+// - This blocks while a frame is being painted. Deferred notifications are applied first,
+//   so that the engines receive all notifications in the order they were made.
+wil::rwlock_release_exclusive_scope_exit Renderer::_lockEngines() noexcept
+{
+    auto lock = _engineLock.lock_exclusive();
+    const auto deferredLock = _deferredLock.lock_exclusive();
+    _applyDeferredNotifications();
+    return lock;
+}
+
+// Routine Description:
+// - Passes the notifications that were deferred while _engineLock was held on to the engines.
+// - The caller must hold both _engineLock and _deferredLock.
+void Renderer::_applyDeferredNotifications() noexcept
+{
+    if (const auto delta = std::exchange(_deferredScrollDelta, {}); delta != til::point{})
+    {
+        FOREACH_ENGINE(pEngine)
+        {
+            LOG_IF_FAILED(pEngine->InvalidateScroll(&delta));
+        }
+
+        try
+        {
+            _ScrollPreviousSelection(delta);
+        }
+        CATCH_LOG();
+    }
+
+    for (const auto& text : _deferredNewText)
+    {
+        FOREACH_ENGINE(pEngine)
+        {
+            LOG_IF_FAILED(pEngine->NotifyNewText(text));
+        }
+    }
+    _deferredNewText.clear();
+}
+
 void Renderer::NotifyPaintFrame() noexcept
 {
     // If we're running in the unittests, we might not have a render thread.
@@ -223,9 +450,12 @@ void Renderer::NotifyPaintFrame() noexcept
 // - <none>
 void Renderer::TriggerSystemRedraw(const til::rect* const prcDirtyClient)
 {
-    FOREACH_ENGINE(pEngine)
     {
-        LOG_IF_FAILED(pEngine->InvalidateSystem(prcDirtyClient));
+        const auto lock = _lockEngines();
+        FOREACH_ENGINE(pEngine)
+        {
+            LOG_IF_FAILED(pEngine->InvalidateSystem(prcDirtyClient));
+        }
     }
 
     NotifyPaintFrame();
@@ -239,8 +469,23 @@ void Renderer::TriggerSystemRedraw(const til::rect* const prcDirtyClient)
 // - <none>
 void Renderer::TriggerRedraw(const Viewport& region)
 {
-    auto view = _pData->GetViewport();
-    auto srUpdateRegion = region.ToExclusive();
+    const auto lock = _lockEngines();
+    if (_invalidateBufferRegion(region.ToExclusive()))
+    {
+        NotifyPaintFrame();
+    }
+}
+
+// Routine Description:
+// - Invalidates the given buffer region in all engines, without scheduling a frame.
+// - The caller must hold _engineLock. The region is relative to the viewport the engines were last told about.
+// Arguments:
+// - srUpdateRegion: The buffer region that has changed.
+// Return Value:
+// - true if any part of the region is within the viewport.
+bool Renderer::_invalidateBufferRegion(til::rect srUpdateRegion)
+{
+    auto view = _viewport;
 
     // If the dirty region has double width lines, we need to double the size of
     // the right margin to make sure all the affected cells are invalidated.
@@ -262,8 +507,10 @@ void Renderer::TriggerRedraw(const Viewport& region)
             LOG_IF_FAILED(pEngine->Invalidate(&srUpdateRegion));
         }
 
-        NotifyPaintFrame();
+        return true;
     }
+
+    return false;
 }
 
 // Routine Description:
@@ -287,9 +534,12 @@ void Renderer::TriggerRedraw(const til::point* const pcoord)
 // - <none>
 void Renderer::TriggerRedrawAll(const bool backgroundChanged, const bool frameChanged)
 {
-    FOREACH_ENGINE(pEngine)
     {
-        LOG_IF_FAILED(pEngine->InvalidateAll());
+        const auto lock = _lockEngines();
+        FOREACH_ENGINE(pEngine)
+        {
+            LOG_IF_FAILED(pEngine->InvalidateAll());
+        }
     }
 
     NotifyPaintFrame();
@@ -327,6 +577,7 @@ void Renderer::TriggerTeardown() noexcept
 void Renderer::TriggerSelection()
 try
 {
+    const auto lock = _lockEngines();
     const auto spans = _pData->GetSelectionSpans();
     if (spans.size() != _lastSelectionPaintSize || (!spans.empty() && _lastSelectionPaintSpan != til::point_span{ spans.front().start, spans.back().end }))
     {
@@ -381,6 +632,7 @@ try
     }
 
     const auto& buffer = _pData->GetTextBuffer();
+    const auto lock = _lockEngines();
 
     FOREACH_ENGINE(pEngine)
     {
@@ -453,10 +705,20 @@ bool Renderer::_CheckViewportAndScroll()
 // - <none>
 void Renderer::TriggerScroll()
 {
-    if (_CheckViewportAndScroll())
+    // If a frame is being painted right now, the next one will pick up the viewport change in _PaintFrame().
     {
-        NotifyPaintFrame();
+        const auto deferredLock = _deferredLock.lock_exclusive();
+        if (const auto lock = _engineLock.try_lock_exclusive())
+        {
+            _applyDeferredNotifications();
+            if (!_CheckViewportAndScroll())
+            {
+                return;
+            }
+        }
     }
+
+    NotifyPaintFrame();
 }
 
 // Routine Description:
@@ -470,13 +732,17 @@ void Renderer::TriggerScroll()
 // - <none>
 void Renderer::TriggerScroll(const til::point* const pcoordDelta)
 {
-    FOREACH_ENGINE(pEngine)
+    // This is called for every line of output that scrolls the buffer. Instead of waiting for the
+    // current frame to finish painting, the delta is accumulated and passed on once it's done.
     {
-        LOG_IF_FAILED(pEngine->InvalidateScroll(pcoordDelta));
+        const auto deferredLock = _deferredLock.lock_exclusive();
+        _deferredScrollDelta += *pcoordDelta;
+        if (const auto lock = _engineLock.try_lock_exclusive())
+        {
+            _applyDeferredNotifications();
+        }
     }
 
-    _ScrollPreviousSelection(*pcoordDelta);
-
     NotifyPaintFrame();
 }
 
@@ -490,18 +756,31 @@ void Renderer::TriggerScroll(const til::point* const pcoordDelta)
 void Renderer::TriggerTitleChange()
 {
     const auto newTitle = _pData->GetConsoleTitle();
-    FOREACH_ENGINE(pEngine)
     {
-        LOG_IF_FAILED(pEngine->InvalidateTitle(newTitle));
+        const auto lock = _lockEngines();
+        FOREACH_ENGINE(pEngine)
+        {
+            LOG_IF_FAILED(pEngine->InvalidateTitle(newTitle));
+        }
     }
     NotifyPaintFrame();
 }
 
 void Renderer::TriggerNewTextNotification(const std::wstring_view newText)
 {
-    FOREACH_ENGINE(pEngine)
+    // Like TriggerScroll(), this must not wait for the current frame to finish painting.
+    const auto deferredLock = _deferredLock.lock_exclusive();
+    if (const auto lock = _engineLock.try_lock_exclusive())
+    {
+        _applyDeferredNotifications();
+        FOREACH_ENGINE(pEngine)
+        {
+            LOG_IF_FAILED(pEngine->NotifyNewText(newText));
+        }
+    }
+    else
     {
-        LOG_IF_FAILED(pEngine->NotifyNewText(newText));
+        _deferredNewText.emplace_back(newText);
     }
 }
 
@@ -513,8 +792,7 @@ void Renderer::TriggerNewTextNotification(const std::wstring_view newText)
 // - the HRESULT of the underlying engine's UpdateTitle call.
 HRESULT Renderer::_PaintTitle(IRenderEngine* const pEngine)
 {
-    const auto newTitle = _pData->GetConsoleTitle();
-    return pEngine->UpdateTitle(newTitle);
+    return pEngine->UpdateTitle(_frame.title);
 }
 
 // Routine Description:
@@ -527,10 +805,13 @@ HRESULT Renderer::_PaintTitle(IRenderEngine* const pEngine)
 // - <none>
 void Renderer::TriggerFontChange(const int iDpi, const FontInfoDesired& FontInfoDesired, _Out_ FontInfo& FontInfo)
 {
-    FOREACH_ENGINE(pEngine)
     {
-        LOG_IF_FAILED(pEngine->UpdateDpi(iDpi));
-        LOG_IF_FAILED(pEngine->UpdateFont(FontInfoDesired, FontInfo));
+        const auto lock = _lockEngines();
+        FOREACH_ENGINE(pEngine)
+        {
+            LOG_IF_FAILED(pEngine->UpdateDpi(iDpi));
+            LOG_IF_FAILED(pEngine->UpdateFont(FontInfoDesired, FontInfo));
+        }
     }
 
     NotifyPaintFrame();
@@ -551,11 +832,14 @@ void Renderer::UpdateSoftFont(const std::span<const uint16_t> bitPattern, const
     // bitPattern. If it's empty (i.e. no soft font is set), then nothing will
     // match, and those code points will be treated the same as everything else.
     const auto softFontCharCount = cellSize.height ? bitPattern.size() / cellSize.height : 0;
-    _lastSoftFontChar = _firstSoftFontChar + softFontCharCount - 1;
-
-    FOREACH_ENGINE(pEngine)
     {
-        LOG_IF_FAILED(pEngine->UpdateSoftFont(bitPattern, cellSize, centeringHint));
+        const auto lock = _lockEngines();
+        _lastSoftFontChar = _firstSoftFontChar + softFontCharCount - 1;
+
+        FOREACH_ENGINE(pEngine)
+        {
+            LOG_IF_FAILED(pEngine->UpdateSoftFont(bitPattern, cellSize, centeringHint));
+        }
     }
     TriggerRedrawAll();
 }
@@ -583,6 +867,7 @@ bool Renderer::s_IsSoftFontChar(const std::wstring_view& v, const size_t firstSo
     //      renderer. We won't know which is which, so iterate over them.
     //      Only return the result of the successful one if it's not S_FALSE (which is the VT renderer)
     // TODO: 14560740 - The Window might be able to get at this info in a more sane manner
+    const auto lock = _lockEngines();
     FOREACH_ENGINE(pEngine)
     {
         const auto hr = LOG_IF_FAILED(pEngine->GetProposedFont(FontInfoDesired, FontInfo, iDpi));
@@ -614,6 +899,7 @@ bool Renderer::IsGlyphWideByFont(const std::wstring_view glyph)
     //      renderer. We won't know which is which, so iterate over them.
     //      Only return the result of the successful one if it's not S_FALSE (which is the VT renderer)
     // TODO: 14560740 - The Window might be able to get at this info in a more sane manner
+    const auto lock = _lockEngines();
     FOREACH_ENGINE(pEngine)
     {
         const auto hr = LOG_IF_FAILED(pEngine->IsGlyphWideByFont(glyph, &fIsFullWidth));
@@ -637,7 +923,10 @@ void Renderer::EnablePainting()
 {
     // When the renderer is constructed, the initial viewport won't be available yet,
     // but once EnablePainting is called it should be safe to retrieve.
-    _viewport = _pData->GetViewport();
+    {
+        const auto lock = _lockEngines();
+        _viewport = _pData->GetViewport();
+    }
 
     // When running the unit tests, we may be using a render without a render thread.
     if (_pThread)
@@ -683,9 +972,7 @@ void Renderer::_PaintBufferOutput(_In_ IRenderEngine* const pEngine)
     // This is the subsection of the entire screen buffer that is currently being presented.
     // It can move left/right or top/bottom depending on how the viewport is scrolled
     // relative to the entire buffer.
-    const auto view = _pData->GetViewport();
-    const auto compositionRow = _compositionCache ? _compositionCache->absoluteOrigin.y : -1;
-    const auto& activeComposition = _pData->GetActiveComposition();
+    const auto view = _frame.viewport;
 
     // This is effectively the number of cells on the visible screen that need to be redrawn.
     // The origin is always 0, 0 because it represents the screen itself, not the underlying buffer.
@@ -715,65 +1002,19 @@ void Renderer::_PaintBufferOutput(_In_ IRenderEngine* const pEngine)
         // we need to walk through line-by-line and repaint onto the screen.
         const auto redraw = Viewport::Intersect(dirty, view);
 
-        // Retrieve the text buffer so we can read information out of it.
-        auto& buffer = _pData->GetTextBuffer();
+        // The snapshot only holds the rows of the viewport: Row 0 of it is row view.Top() of the text buffer.
+        const auto& buffer = *_frame.buffer;
         // Now walk through each row of text that we need to redraw.
         for (auto row = redraw.Top(); row < redraw.BottomExclusive(); row++)
         {
             // Calculate the boundaries of a single line. This is from the left to right edge of the dirty
             // area in width and exactly 1 tall.
             const auto screenLine = til::inclusive_rect{ redraw.Left(), row, redraw.RightInclusive(), row };
-            const auto& r = buffer.GetRowByOffset(row);
-
-            // Draw the active composition.
-            // We have to use some tricks here with const_cast, because the code after it relies on TextBufferCellIterator,
-            // which isn't compatible with the scratchpad row. This forces us to back up and modify the actual row `r`.
-            ROW* rowBackup = nullptr;
-            if (row == compositionRow)
-            {
-                auto& scratch = buffer.GetScratchpadRow();
-                scratch.CopyFrom(r);
-                rowBackup = &scratch;
-
-                std::wstring_view text{ activeComposition.text };
-                RowWriteState state{
-                    .columnLimit = r.GetReadableColumnCount(),
-                    .columnEnd = _compositionCache->absoluteOrigin.x,
-                };
-
-                size_t off = 0;
-                for (const auto& range : activeComposition.attributes)
-                {
-                    const auto len = range.len;
-                    auto attr = range.attr;
-
-                    // Use the color at the cursor if TSF didn't specify any explicit color.
-                    if (attr.GetBackground().IsDefault())
-                    {
-                        attr.SetBackground(_compositionCache->baseAttribute.GetBackground());
-                    }
-                    if (attr.GetForeground().IsDefault())
-                    {
-                        attr.SetForeground(_compositionCache->baseAttribute.GetForeground());
-                    }
-
-                    state.text = text.substr(off, len);
-                    state.columnBegin = state.columnEnd;
-                    const_cast<ROW&>(r).ReplaceText(state);
-                    const_cast<ROW&>(r).ReplaceAttributes(state.columnBegin, state.columnEnd, attr);
-                    off += len;
-                }
-            }
-            const auto restore = wil::scope_exit([&] {
-                if (rowBackup)
-                {
-                    const_cast<ROW&>(r).CopyFrom(*rowBackup);
-                }
-            });
+            const auto& r = buffer.GetRowByOffset(row - view.Top());
 
             // Convert the screen coordinates of the line to an equivalent
             // range of buffer cells, taking line rendition into account.
-            const auto lineRendition = buffer.GetLineRendition(row);
+            const auto lineRendition = r.GetLineRendition();
             const auto bufferLine = Viewport::FromInclusive(ScreenToBufferLine(screenLine, lineRendition));
 
             // Find where on the screen we should place this line information. This requires us to re-map
@@ -783,24 +1024,21 @@ void Renderer::_PaintBufferOutput(_In_ IRenderEngine* const pEngine)
             // of the backing buffer to fill in line 1 of the screen.
             const auto screenPosition = bufferLine.Origin() - til::point{ 0, view.Top() };
 
-            // Retrieve the cell information iterator limited to just this line we want to redraw.
-            auto it = buffer.GetCellDataAt(bufferLine.Origin(), bufferLine);
-
             // Calculate if two things are true:
             // 1. this row wrapped
             // 2. We're painting the last col of the row.
             // In that case, set lineWrapped=true for the _PaintBufferOutputHelper call.
-            const auto lineWrapped = (buffer.GetRowByOffset(bufferLine.Origin().y).WasWrapForced()) &&
+            const auto lineWrapped = r.WasWrapForced() &&
                                      (bufferLine.RightExclusive() == buffer.GetSize().Width());
 
             // Prepare the appropriate line transform for the current row and viewport offset.
             LOG_IF_FAILED(pEngine->PrepareLineTransform(lineRendition, screenPosition.y, view.Left()));
 
             // Ask the helper to paint through this specific line.
-            _PaintBufferOutputHelper(pEngine, it, screenPosition, lineWrapped);
+            _PaintBufferOutputHelper(pEngine, r, bufferLine.Left(), bufferLine.RightExclusive(), screenPosition, lineWrapped);
 
             // Paint any image content on top of the text.
-            const auto imageSlice = buffer.GetRowByOffset(row).GetImageSlice();
+            const auto imageSlice = r.GetImageSlice();
             if (imageSlice) [[unlikely]]
             {
                 LOG_IF_FAILED(pEngine->PaintImageSlice(*imageSlice, screenPosition.y, view.Left()));
@@ -816,155 +1054,108 @@ static bool _IsAllSpaces(const std::wstring_view v)
 }
 
 void Renderer::_PaintBufferOutputHelper(_In_ IRenderEngine* const pEngine,
-                                        TextBufferCellIterator it,
+                                        const ROW& row,
+                                        const til::CoordType columnBegin,
+                                        const til::CoordType columnEnd,
                                         const til::point target,
                                         const bool lineWrapped)
 {
-    auto globalInvert{ _renderSettings.GetRenderMode(RenderSettings::Mode::ScreenReversed) };
-
-    // If we have valid data, let's figure out how to draw it.
-    if (it)
+    // The attributes are only looked at once per run. The glyphs are only looked at to build the clusters.
+    _textRuns.clear();
+    row.GetTextRuns(columnBegin, columnEnd, _textRuns);
+    if (_textRuns.empty())
     {
-        // TODO: MSFT: 20961091 -  This is a perf issue. Instead of rebuilding this and allocing memory to hold the reinterpretation,
-        // we should have an iterator/view adapter for the rendering.
-        // That would probably also eliminate the RenderData needing to give us the entire TextBuffer as well...
-        // Retrieve the iterator for one line of information.
-        til::CoordType cols = 0;
-
-        // Retrieve the first color.
-        auto color = it->TextAttr();
-        // Retrieve the first pattern id
-        auto patternIds = _pData->GetPatternId(target);
-        // Determine whether we're using a soft font.
-        auto usingSoftFont = s_IsSoftFontChar(it->Chars(), _firstSoftFontChar, _lastSoftFontChar);
-
-        // And hold the point where we should start drawing.
-        auto screenPoint = target;
+        return;
+    }
 
-        // This outer loop will continue until we reach the end of the text we are trying to draw.
-        while (it)
+    const auto globalInvert = _frame.renderSettings.GetRenderMode(RenderSettings::Mode::ScreenReversed);
+    // Pattern IDs are per cell, but most frames don't have any. Skip looking them up in that case.
+    const auto hasPatterns = !_frame.patternIds.empty();
+    const auto& firstRun = _textRuns.front();
+
+    // The state of the clusters accumulated in _clusterBuffer. They're painted together
+    // whenever the color, pattern or font usage changes or at the end of the line.
+    auto color = firstRun.attr;
+    auto patternIds = hasPatterns ? _framePatternId(target) : std::vector<size_t>{};
+    auto usingSoftFont = s_IsSoftFontChar(row.GlyphAt(firstRun.columnBegin), _firstSoftFontChar, _lastSoftFontChar);
+    auto batchBegin = firstRun.columnBegin;
+    // If we're supposed to start at the right half of a two-column character, the run starts 1 column
+    // to the left of columnBegin. Tell the engine to trim off the left half of it.
+    auto trimLeft = firstRun.columnBegin < columnBegin;
+    // Batch contains wide character (>1 columns)
+    auto containsWideCharacter = false;
+
+    _clusterBuffer.clear();
+
+    const auto paintBatch = [&](const til::CoordType batchEnd) {
+        const til::point screenPoint{ target.x + batchBegin - columnBegin, target.y };
+
+        THROW_IF_FAILED(_UpdateDrawingBrushes(pEngine, color, usingSoftFont, false));
+        THROW_IF_FAILED(pEngine->PaintBufferLine({ _clusterBuffer.data(), _clusterBuffer.size() }, screenPoint, trimLeft, lineWrapped));
+
+        // If we're allowed to do grid drawing, draw that now too (since it will be coupled with the color data)
+        // We're only allowed to draw the grid lines under certain circumstances.
+        if (_frame.gridLinesAllowed)
         {
-            // Hold onto the current run color right here for the length of the outer loop.
-            // We'll be changing the persistent one as we run through the inner loops to detect
-            // when a run changes, but we will still need to know this color at the bottom
-            // when we go to draw gridlines for the length of the run.
-            const auto currentRunColor = color;
-
-            // Hold onto the current pattern id as well
-            const auto currentPatternId = patternIds;
-
-            // Update the drawing brushes with our color and font usage.
-            THROW_IF_FAILED(_UpdateDrawingBrushes(pEngine, currentRunColor, usingSoftFont, false));
-
-            // Advance the point by however many columns we've just outputted and reset the accumulator.
-            screenPoint.x += cols;
-            cols = 0;
-
-            // Hold onto the start of this run iterator and the target location where we started
-            // in case we need to do some special work to paint the line drawing characters.
-            const auto currentRunItStart = it;
-            const auto currentRunTargetStart = screenPoint;
-
-            // Ensure that our cluster vector is clear.
-            _clusterBuffer.clear();
-
-            // Reset our flag to know when we're in the special circumstance
-            // of attempting to draw only the right-half of a two-column character
-            // as the first item in our run.
-            auto trimLeft = false;
-
-            // Run contains wide character (>1 columns)
-            auto containsWideCharacter = false;
-
-            // This inner loop will accumulate clusters until the color changes.
-            // When the color changes, it will save the new color off and break.
-            // We also accumulate clusters according to regex patterns
-            do
+            // See GH: 803
+            // A wide character is batched by the attributes of its left half, but it's possible (like with the IME)
+            // that its right half has different line information. Paint the lines column by column in that case.
+            if (containsWideCharacter)
             {
-                til::point thisPoint{ screenPoint.x + cols, screenPoint.y };
-                const auto thisPointPatterns = _pData->GetPatternId(thisPoint);
-                const auto thisUsingSoftFont = s_IsSoftFontChar(it->Chars(), _firstSoftFontChar, _lastSoftFontChar);
-                const auto changedPatternOrFont = patternIds != thisPointPatterns || usingSoftFont != thisUsingSoftFont;
-                if (color != it->TextAttr() || changedPatternOrFont)
+                for (auto x = std::max(batchBegin, columnBegin); x < batchEnd; ++x)
                 {
-                    auto newAttr{ it->TextAttr() };
-                    // foreground doesn't matter for runs of spaces (!)
-                    // if we trick it . . . we call Paint far fewer times for cmatrix
-                    if (!_IsAllSpaces(it->Chars()) || !newAttr.HasIdenticalVisualRepresentationForBlankSpace(color, globalInvert) || changedPatternOrFont)
-                    {
-                        color = newAttr;
-                        patternIds = thisPointPatterns;
-                        usingSoftFont = thisUsingSoftFont;
-                        break; // vend this run
-                    }
+                    _PaintBufferOutputGridLineHelper(pEngine, row.GetAttrByColumn(x), 1, { target.x + x - columnBegin, target.y });
                 }
+            }
+            else
+            {
+                // If nothing exciting is going on, draw the lines in bulk.
+                _PaintBufferOutputGridLineHelper(pEngine, color, gsl::narrow_cast<size_t>(batchEnd - batchBegin), screenPoint);
+            }
+        }
 
-                // Walk through the text data and turn it into rendering clusters.
-                // Keep the columnCount as we go to improve performance over digging it out of the vector at the end.
-                auto columnCount = it->Columns();
-
-                // If we're on the first cluster to be added and it's marked as "trailing"
-                // (a.k.a. the right half of a two column character), then we need some special handling.
-                if (_clusterBuffer.empty() && it->DbcsAttr() == DbcsAttribute::Trailing)
-                {
-                    // Move left to the one so the whole character can be struck correctly.
-                    --screenPoint.x;
-                    // And tell the next function to trim off the left half of it.
-                    trimLeft = true;
-                    // And add one to the number of columns we expect it to take as we insert it.
-                    ++columnCount;
-                }
+        _clusterBuffer.clear();
+        batchBegin = batchEnd;
+        trimLeft = false;
+        containsWideCharacter = false;
+    };
 
-                if (columnCount > 1)
+    for (const auto& run : _textRuns)
+    {
+        for (auto column = run.columnBegin; column < run.columnEnd;)
+        {
+            const auto glyph = row.GlyphAt(column);
+            const auto glyphEnd = row.AdjustToGlyphEnd(column + 1);
+            const auto columnCount = glyphEnd - column;
+            const auto thisUsingSoftFont = s_IsSoftFontChar(glyph, _firstSoftFontChar, _lastSoftFontChar);
+            const auto changedPattern = hasPatterns && patternIds != _framePatternId({ target.x + column - columnBegin, target.y });
+            const auto changedPatternOrFont = changedPattern || usingSoftFont != thisUsingSoftFont;
+
+            // foreground doesn't matter for runs of spaces (!)
+            // if we trick it . . . we call Paint far fewer times for cmatrix
+            if (!_clusterBuffer.empty() &&
+                (changedPatternOrFont || (color != run.attr && (!_IsAllSpaces(glyph) || !run.attr.HasIdenticalVisualRepresentationForBlankSpace(color, globalInvert)))))
+            {
+                paintBatch(column);
+                color = run.attr;
+                if (hasPatterns)
                 {
-                    containsWideCharacter = true;
+                    patternIds = _framePatternId({ target.x + column - columnBegin, target.y });
                 }
+                usingSoftFont = thisUsingSoftFont;
+            }
 
-                // Advance the cluster and column counts.
-                _clusterBuffer.emplace_back(it->Chars(), columnCount);
-                it += std::max(it->Columns(), 1); // prevent infinite loop for no visible columns
-                cols += columnCount;
-
-            } while (it);
-
-            // Do the painting.
-            THROW_IF_FAILED(pEngine->PaintBufferLine({ _clusterBuffer.data(), _clusterBuffer.size() }, screenPoint, trimLeft, lineWrapped));
-
-            // If we're allowed to do grid drawing, draw that now too (since it will be coupled with the color data)
-            // We're only allowed to draw the grid lines under certain circumstances.
-            if (_pData->IsGridLineDrawingAllowed())
+            if (columnCount > 1)
             {
-                // See GH: 803
-                // If we found a wide character while we looped above, it's possible we skipped over the right half
-                // attribute that could have contained different line information than the left half.
-                if (containsWideCharacter)
-                {
-                    // Start from the original position in this run.
-                    auto lineIt = currentRunItStart;
-                    // Start from the original target in this run.
-                    auto lineTarget = currentRunTargetStart;
-
-                    // We need to go through the iterators again to ensure we get the lines associated with each
-                    // exact column. The code above will condense two-column characters into one, but it is possible
-                    // (like with the IME) that the line drawing characters will vary from the left to right half
-                    // of a wider character.
-                    // We could theoretically pre-pass for this in the loop above to be more efficient about walking
-                    // the iterator, but I fear it would make the code even more confusing than it already is.
-                    // Do that in the future if some WPR trace points you to this spot as super bad.
-                    for (til::CoordType colsPainted = 0; colsPainted < cols; ++colsPainted, ++lineIt, ++lineTarget.x)
-                    {
-                        auto lines = lineIt->TextAttr();
-                        _PaintBufferOutputGridLineHelper(pEngine, lines, 1, lineTarget);
-                    }
-                }
-                else
-                {
-                    // If nothing exciting is going on, draw the lines in bulk.
-                    _PaintBufferOutputGridLineHelper(pEngine, currentRunColor, cols, screenPoint);
-                }
+                containsWideCharacter = true;
             }
+
+            _clusterBuffer.emplace_back(glyph, columnCount);
+            column = glyphEnd;
         }
     }
+
+    paintBatch(_textRuns.back().columnEnd);
 }
 
 // Method Description:
@@ -1065,8 +1256,8 @@ void Renderer::_PaintBufferOutputGridLineHelper(_In_ IRenderEngine* const pEngin
     if (lines.any())
     {
         // Get the current foreground and underline colors to render the lines.
-        const auto fg = _renderSettings.GetAttributeColors(textAttribute).first;
-        const auto underlineColor = _renderSettings.GetAttributeUnderlineColor(textAttribute);
+        const auto fg = _frame.renderSettings.GetAttributeColors(textAttribute).first;
+        const auto underlineColor = _frame.renderSettings.GetAttributeUnderlineColor(textAttribute);
         // Draw the lines
         LOG_IF_FAILED(pEngine->PaintBufferGridLines(lines, fg, underlineColor, cchLine, coordTarget));
     }
@@ -1081,7 +1272,7 @@ bool Renderer::_isInHoveredInterval(const til::point coordTarget) const noexcept
 {
     return _hoveredInterval &&
            _hoveredInterval->start <= coordTarget && coordTarget <= _hoveredInterval->stop &&
-           _pData->GetPatternId(coordTarget).size() > 0;
+           _framePatternId(coordTarget).size() > 0;
 }
 
 // Routine Description:
@@ -1253,9 +1444,9 @@ void Renderer::_prepareNewComposition()
 // - <none>
 void Renderer::_PaintCursor(_In_ IRenderEngine* const pEngine)
 {
-    if (_currentCursorOptions.inViewport && _currentCursorOptions.isVisible)
+    if (_frame.cursor.inViewport && _frame.cursor.isVisible)
     {
-        LOG_IF_FAILED(pEngine->PaintCursor(_currentCursorOptions));
+        LOG_IF_FAILED(pEngine->PaintCursor(_frame.cursor));
     }
 }
 
@@ -1273,10 +1464,10 @@ void Renderer::_PaintCursor(_In_ IRenderEngine* const pEngine)
 [[nodiscard]] HRESULT Renderer::_PrepareRenderInfo(_In_ IRenderEngine* const pEngine)
 {
     RenderFrameInfo info;
-    info.searchHighlights = _pData->GetSearchHighlights();
-    info.searchHighlightFocused = _pData->GetSearchHighlightFocused();
-    info.selectionSpans = _pData->GetSelectionSpans();
-    info.selectionBackground = _renderSettings.GetColorTableEntry(TextColor::SELECTION_BACKGROUND);
+    info.searchHighlights = _frame.searchHighlights;
+    info.searchHighlightFocused = _frame.searchHighlightFocused ? &*_frame.searchHighlightFocused : nullptr;
+    info.selectionSpans = _frame.selectionSpans;
+    info.selectionBackground = _frame.renderSettings.GetColorTableEntry(TextColor::SELECTION_BACKGROUND);
     return pEngine->PrepareRenderInfo(std::move(info));
 }
 
@@ -1295,7 +1486,7 @@ void Renderer::_PaintSelection(_In_ IRenderEngine* const pEngine)
 
         for (auto&& dirtyRect : dirtyAreas)
         {
-            for (const auto& rect : _lastSelectionRectsByViewport)
+            for (const auto& rect : _frame.selectionRects)
             {
                 if (const auto rectCopy{ rect & dirtyRect })
                 {
@@ -1326,7 +1517,7 @@ void Renderer::_PaintSelection(_In_ IRenderEngine* const pEngine)
 {
     // The last color needs to be each engine's responsibility. If it's local to this function,
     //      then on the next engine we might not update the color.
-    return pEngine->UpdateDrawingBrushes(textAttributes, _renderSettings, _pData, usingSoftFont, isSettingDefaultBrushes);
+    return pEngine->UpdateDrawingBrushes(textAttributes, _frame.renderSettings, _pData, usingSoftFont, isSettingDefaultBrushes);
 }
 
 // Routine Description:
@@ -1377,6 +1568,7 @@ void Renderer::AddRenderEngine(_In_ IRenderEngine* const pEngine)
 {
     THROW_HR_IF_NULL(E_INVALIDARG, pEngine);
 
+    const auto lock = _lockEngines();
     for (auto& p : _engines)
     {
         if (!p)
@@ -1394,6 +1586,7 @@ void Renderer::RemoveRenderEngine(_In_ IRenderEngine* const pEngine)
 {
     THROW_HR_IF_NULL(E_INVALIDARG, pEngine);
 
+    const auto lock = _lockEngines();
     for (auto& p : _engines)
     {
         if (p == pEngine)
@@ -1404,6 +1597,18 @@ void Renderer::RemoveRenderEngine(_In_ IRenderEngine* const pEngine)
     }
 }
 
+// Method Description:
+// - Locks the engines against being painted. Frames are painted without the console lock,
+//   so the hosts must hold this while calling into an engine directly, for instance to
+//   change its font, DPI or window size. The renderer's own methods lock it themselves,
+//   so they must not be called while holding it.
+// Return Value:
+// - The lock, which is released when it goes out of scope.
+wil::rwlock_release_exclusive_scope_exit Renderer::LockEngines() noexcept
+{
+    return _lockEngines();
+}
+
 // Method Description:
 // - Registers a callback for when the background color is changed
 // Arguments:
@@ -1448,6 +1653,7 @@ void Renderer::ResetErrorStateAndResume()
 
 void Renderer::UpdateHyperlinkHoveredId(uint16_t id) noexcept
 {
+    const auto lock = _lockEngines();
     _hyperlinkHoveredId = id;
     FOREACH_ENGINE(pEngine)
     {
@@ -1457,6 +1663,7 @@ void Renderer::UpdateHyperlinkHoveredId(uint16_t id) noexcept
 
 void Renderer::UpdateLastHoveredInterval(const std::optional<PointTree::interval>& newInterval)
 {
+    const auto lock = _lockEngines();
     _hoveredInterval = newInterval;
 }
 
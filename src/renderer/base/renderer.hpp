@@ -76,6 +76,7 @@ namespace Microsoft::Console::Render
 
         void AddRenderEngine(_In_ IRenderEngine* const pEngine);
         void RemoveRenderEngine(_In_ IRenderEngine* const pEngine);
+        [[nodiscard]] wil::rwlock_release_exclusive_scope_exit LockEngines() noexcept;
 
         void SetBackgroundColorChangedCallback(std::function<void()> pfn);
         void SetFrameColorChangedCallback(std::function<void()> pfn);
@@ -94,15 +95,42 @@ namespace Microsoft::Console::Render
             TextAttribute baseAttribute;
         };
 
+        // Everything that _PaintFrameForEngine() needs to paint a frame. It's copied out of
+        // _pData by _snapshotFrame(), so that the engines can paint without the console lock.
+        struct FrameSnapshot
+        {
+            // The engines that have something to paint.
+            til::small_vector<IRenderEngine*, 2> engines;
+            // The rows of the viewport, where row 0 is viewport.Top(). Only the dirty ones are up to date.
+            std::unique_ptr<TextBuffer> buffer;
+            Microsoft::Console::Types::Viewport viewport;
+            RenderSettings renderSettings;
+            CursorOptions cursor;
+            std::vector<til::rect> selectionRects;
+            std::vector<til::point_span> selectionSpans;
+            std::vector<til::point_span> searchHighlights;
+            std::optional<til::point_span> searchHighlightFocused;
+            // The pattern IDs of each cell, indexed by y * width + x. Empty if there are none.
+            std::vector<std::vector<size_t>> patternIds;
+            std::wstring title;
+            bool gridLinesAllowed = false;
+        };
+
         static GridLineSet s_GetGridlines(const TextAttribute& textAttribute) noexcept;
         static bool s_IsSoftFontChar(const std::wstring_view& v, const size_t firstSoftFontChar, const size_t lastSoftFontChar);
 
         [[nodiscard]] HRESULT _PaintFrame() noexcept;
         [[nodiscard]] HRESULT _PaintFrameForEngine(_In_ IRenderEngine* const pEngine) noexcept;
+        void _snapshotFrame();
+        void _overlayComposition(ROW& row) const;
+        const std::vector<size_t>& _framePatternId(const til::point target) const noexcept;
+        wil::rwlock_release_exclusive_scope_exit _lockEngines() noexcept;
+        void _applyDeferredNotifications() noexcept;
         bool _CheckViewportAndScroll();
+        bool _invalidateBufferRegion(til::rect region);
         [[nodiscard]] HRESULT _PaintBackground(_In_ IRenderEngine* const pEngine);
         void _PaintBufferOutput(_In_ IRenderEngine* const pEngine);
-        void _PaintBufferOutputHelper(_In_ IRenderEngine* const pEngine, TextBufferCellIterator it, const til::point target, const bool lineWrapped);
+        void _PaintBufferOutputHelper(_In_ IRenderEngine* const pEngine, const ROW& row, const til::CoordType columnBegin, const til::CoordType columnEnd, const til::point target, const bool lineWrapped);
         void _PaintBufferOutputGridLineHelper(_In_ IRenderEngine* const pEngine, const TextAttribute textAttribute, const size_t cchLine, const til::point coordTarget);
         bool _isHoveredHyperlink(const TextAttribute& textAttribute) const noexcept;
         void _PaintSelection(_In_ IRenderEngine* const pEngine);
@@ -130,6 +158,9 @@ namespace Microsoft::Console::Render
         CursorOptions _currentCursorOptions;
         std::optional<CompositionCache> _compositionCache;
         std::vector<Cluster> _clusterBuffer;
+        std::vector<RowTextRun> _textRuns;
+        std::vector<til::rect> _damage;
+        FrameSnapshot _frame;
         std::function<void()> _pfnBackgroundColorChanged;
         std::function<void()> _pfnFrameColorChanged;
         std::function<void()> _pfnRendererEnteredErrorState;
@@ -139,5 +170,15 @@ namespace Microsoft::Console::Render
         til::point_span _lastSelectionPaintSpan{};
         size_t _lastSelectionPaintSize{};
         std::vector<til::rect> _lastSelectionRectsByViewport{};
+
+        // Must be held while calling into the engines. _PaintFrame() holds it until the frame
+        // is painted, but releases the console lock as soon as the frame was snapshotted.
+        // The hosts acquire it through LockEngines() to change an engine's font, DPI, size, etc.
+        wil::srwlock _engineLock;
+        // Notifications that couldn't acquire _engineLock are collected here instead of
+        // blocking the caller. See _applyDeferredNotifications().
+        wil::srwlock _deferredLock;
+        til::point _deferredScrollDelta;
+        std::vector<std::wstring> _deferredNewText;
     };
 }
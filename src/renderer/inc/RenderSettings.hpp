@@ -44,6 +44,7 @@ namespace Microsoft::Console::Render
         std::pair<COLORREF, COLORREF> GetAttributeColors(const TextAttribute& attr) const noexcept;
         std::pair<COLORREF, COLORREF> GetAttributeColorsWithAlpha(const TextAttribute& attr) const noexcept;
         COLORREF GetAttributeUnderlineColor(const TextAttribute& attr) const noexcept;
+        void SetBlinkInUse() const noexcept;
         void ToggleBlinkRendition(class Renderer* renderer) noexcept;
 
     private:
@@ -175,23 +175,31 @@ bool FontBuffer::SetStartChar(const VTParameter startChar,
     return true;
 }
 
-void FontBuffer::AddSixelData(const wchar_t ch)
+void FontBuffer::AddSixelData(const std::wstring_view data)
 {
-    if (!_charsetIdInitialized)
-    {
-        _buildCharsetId(ch);
-    }
-    else if (ch >= L'?' && ch <= L'~')
-    {
-        _addSixelValue(ch - L'?');
-    }
-    else if (ch == L'/')
+    auto it = data.begin();
+    const auto end = data.end();
+
+    for (; it != end && !_charsetIdInitialized; ++it)
     {
-        _endOfSixelLine();
+        _buildCharsetId(*it);
     }
-    else if (ch == L';')
+
+    for (; it != end; ++it)
     {
-        _endOfCharacter();
+        const auto ch = *it;
+        if (ch >= L'?' && ch <= L'~')
+        {
+            _addSixelValue(ch - L'?');
+        }
+        else if (ch == L'/')
+        {
+            _endOfSixelLine();
+        }
+        else if (ch == L';')
+        {
+            _endOfCharacter();
+        }
     }
 }
 
@@ -44,9 +44,10 @@ namespace Microsoft::Console::VirtualTerminal
         void InvokeMacro(const size_t macroId, StateMachine& stateMachine);
         void ClearMacrosIfInUse();
         bool InitParser(const size_t macroId, const DispatchTypes::MacroDeleteControl deleteControl, const DispatchTypes::MacroEncoding encoding);
-        bool ParseDefinition(const wchar_t ch);
+        bool ParseDefinition(const std::wstring_view data);
 
     private:
+        bool _parseDefinitionChar(const wchar_t ch);
         bool _decodeHexDigit(const wchar_t ch) noexcept;
         bool _appendToActiveMacro(const wchar_t ch);
         std::wstring& _activeMacro();
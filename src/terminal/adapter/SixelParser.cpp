@@ -80,7 +80,7 @@ void SixelParser::SetDisplayMode(const bool enabled) noexcept
     }
 }
 
-std::function<bool(wchar_t)> SixelParser::DefineImage(const VTInt macroParameter, const DispatchTypes::SixelBackground backgroundSelect, const VTParameter backgroundColor)
+std::function<bool(std::wstring_view)> SixelParser::DefineImage(const VTInt macroParameter, const DispatchTypes::SixelBackground backgroundSelect, const VTParameter backgroundColor)
 {
     if (_initTextBufferBoundaries())
     {
@@ -89,8 +89,27 @@ std::function<bool(wchar_t)> SixelParser::DefineImage(const VTInt macroParameter
         _initImageBuffer();
         _state = States::Normal;
         _parameters.clear();
-        return [&](const auto ch) {
-            _parseCommandChar(ch);
+        return [&](const std::wstring_view str) {
+            for (size_t i = 0; i < str.size();)
+            {
+                // Sixel values make up the bulk of an image, so when there's no
+                // pending command to apply, we decode entire runs of them at once.
+                if (_state == States::Normal)
+                {
+                    const auto beg = i;
+                    while (i < str.size() && til::at(str, i) >= L'?' && til::at(str, i) <= L'~')
+                    {
+                        i++;
+                    }
+                    if (i > beg)
+                    {
+                        _writeSixelRunToImageBuffer(str.substr(beg, i - beg));
+                        continue;
+                    }
+                }
+                _parseCommandChar(til::at(str, i));
+                i++;
+            }
             return true;
         };
     }
@@ -710,6 +729,83 @@ void SixelParser::_writeToImageBuffer(int sixelValue, int repeatCount)
     _imageCursor.x += repeatCount;
 }
 
+void SixelParser::_writeSixelRunToImageBuffer(const std::wstring_view sixels)
+{
+    // This is equivalent to calling _writeToImageBuffer for every sixel with a
+    // repeat count of 1, but since it writes one pixel row at a time, rather
+    // than one column, the memory access is sequential and can be vectorized.
+    _fillImageBackground();
+
+    const auto count = std::min(sixels.size(), gsl::narrow_cast<size_t>(_imageMaxWidth - _imageCursor.x));
+    const auto targetOffset = _imageCursor.y * _imageMaxWidth + _imageCursor.x;
+    auto imageBufferPtr = std::next(_imageBuffer.data(), targetOffset);
+    for (auto bit = 0; bit < 6; bit++)
+    {
+        for (auto i = 0; i < _pixelAspectRatio; i++)
+        {
+            _expandSixelBit(sixels.data(), count, bit, imageBufferPtr, _foregroundPixel);
+            std::advance(imageBufferPtr, _imageMaxWidth);
+        }
+    }
+    _imageCursor.x += gsl::narrow_cast<til::CoordType>(count);
+}
+
+#pragma warning(push)
+#pragma warning(disable : 26481) // Don't use pointer arithmetic. Use span instead (bounds.1).
+#pragma warning(disable : 26490) // Don't use reinterpret_cast (type.1).
+
+// Sets every pixel in dst to the given one, for which the corresponding sixel has the given bit set.
+// Pixels are 16 bits large, just like the sixel characters, so they can be processed in the same lanes.
+void SixelParser::_expandSixelBit(const wchar_t* sixels, const size_t count, const int bit, IndexedPixel* dst, const IndexedPixel pixel) noexcept
+{
+    static_assert(sizeof(IndexedPixel) == sizeof(uint16_t));
+    size_t i = 0;
+
+#if defined(TIL_SSE_INTRINSICS)
+
+    uint16_t pixelBits;
+    memcpy(&pixelBits, &pixel, sizeof(pixelBits));
+    const auto offset = _mm_set1_epi16(L'?');
+    const auto mask = _mm_set1_epi16(gsl::narrow_cast<short>(1 << bit));
+    const auto fill = _mm_set1_epi16(static_cast<short>(pixelBits));
+
+    for (; i + 8 <= count; i += 8)
+    {
+        const auto values = _mm_sub_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(sixels + i)), offset);
+        const auto set = _mm_cmpeq_epi16(_mm_and_si128(values, mask), mask);
+        const auto old = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_or_si128(_mm_and_si128(set, fill), _mm_andnot_si128(set, old)));
+    }
+
+#elif defined(TIL_ARM_NEON_INTRINSICS)
+
+    uint16_t pixelBits;
+    memcpy(&pixelBits, &pixel, sizeof(pixelBits));
+    const auto offset = vdupq_n_u16(L'?');
+    const auto mask = vdupq_n_u16(gsl::narrow_cast<uint16_t>(1 << bit));
+    const auto fill = vdupq_n_u16(pixelBits);
+
+    for (; i + 8 <= count; i += 8)
+    {
+        const auto values = vsubq_u16(vld1q_u16(reinterpret_cast<const uint16_t*>(sixels + i)), offset);
+        const auto set = vtstq_u16(values, mask);
+        const auto old = vld1q_u16(reinterpret_cast<const uint16_t*>(dst + i));
+        vst1q_u16(reinterpret_cast<uint16_t*>(dst + i), vbslq_u16(set, fill, old));
+    }
+
+#endif
+
+    for (; i < count; i++)
+    {
+        if ((sixels[i] - L'?') & (1 << bit))
+        {
+            dst[i] = pixel;
+        }
+    }
+}
+
+#pragma warning(pop)
+
 void SixelParser::_eraseImageBufferRows(const int rowCount, const til::CoordType rowOffset) noexcept
 {
     const auto pixelCount = rowCount * _cellSize.height;
@@ -779,6 +875,11 @@ void SixelParser::_maybeFlushImageBuffer(const bool endOfSequence)
         // so the only visible change will be the scrolling.
         if (_imageWidth > 0)
         {
+            // Looking up the color table and converting the result for every
+            // pixel is comparatively expensive, so we convert the table upfront.
+            std::array<RGBQUAD, MAX_COLORS> palette;
+            std::transform(_colorTable.begin(), _colorTable.end(), palette.begin(), _makeRGBQUAD);
+
             const auto columnBegin = _imageOriginCell.x;
             const auto columnEnd = _imageOriginCell.x + (_imageWidth + _cellSize.width - 1) / _cellSize.width;
             auto rowOffset = _imageOriginCell.y;
@@ -802,8 +903,7 @@ void SixelParser::_maybeFlushImageBuffer(const bool endOfSequence)
                             const auto srcPixel = til::at(srcIterator, pixelColumn);
                             if (!srcPixel.transparent)
                             {
-                                const auto srcColor = _colorFromIndex(srcPixel.colorIndex);
-                                til::at(dstIterator, pixelColumn) = _makeRGBQUAD(srcColor);
+                                til::at(dstIterator, pixelColumn) = til::at(palette, srcPixel.colorIndex);
                             }
                         }
                         std::advance(srcIterator, _imageMaxWidth);
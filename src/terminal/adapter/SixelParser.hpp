@@ -34,7 +34,7 @@ namespace Microsoft::Console::VirtualTerminal
         SixelParser(AdaptDispatch& dispatcher, const StateMachine& stateMachine, const VTInt conformanceLevel = DefaultConformance) noexcept;
         void SoftReset();
         void SetDisplayMode(const bool enabled) noexcept;
-        std::function<bool(wchar_t)> DefineImage(const VTInt macroParameter, const DispatchTypes::SixelBackground backgroundSelect, const VTParameter backgroundColor);
+        std::function<bool(std::wstring_view)> DefineImage(const VTInt macroParameter, const DispatchTypes::SixelBackground backgroundSelect, const VTParameter backgroundColor);
 
     private:
         // NB: If we want to support more than 256 colors, we'll also need to
@@ -110,6 +110,8 @@ namespace Microsoft::Console::VirtualTerminal
         void _resizeImageBuffer(const til::CoordType requiredHeight);
         void _fillImageBackground();
         void _writeToImageBuffer(const int sixelValue, const int repeatCount);
+        void _writeSixelRunToImageBuffer(const std::wstring_view sixels);
+        static void _expandSixelBit(const wchar_t* sixels, const size_t count, const int bit, IndexedPixel* dst, const IndexedPixel pixel) noexcept;
         void _eraseImageBufferRows(const int rowCount, const til::CoordType startRow = 0) noexcept;
         void _maybeFlushImageBuffer(const bool endOfSequence = false);
 
@@ -37,6 +37,23 @@ static constexpr std::array<XtermResourceColorTableEntry, 10> XtermResourceColor
     /* 19 */ { -1, -1 },
 } };
 
+// The report parsers are most easily written as a function of a single character.
+// This adapts them to the StringHandler interface, which receives runs of characters.
+template<typename T>
+static ITermDispatch::StringHandler _perCharacterHandler(T handler)
+{
+    return [handler = std::move(handler)](const std::wstring_view str) mutable {
+        for (const auto ch : str)
+        {
+            if (!handler(ch))
+            {
+                return false;
+            }
+        }
+        return true;
+    };
+}
+
 AdaptDispatch::AdaptDispatch(ITerminalApi& api, Renderer* renderer, RenderSettings& renderSettings, TerminalInput& terminalInput) noexcept :
     _api{ api },
     _renderer{ renderer },
@@ -3814,16 +3831,14 @@ ITermDispatch::StringHandler AdaptDispatch::DownloadDRCS(const VTInt fontNumber,
         return nullptr;
     }
 
-    return [=](const auto ch) {
+    return [=](const std::wstring_view str) {
         // We pass the data string straight through to the font buffer class
         // until we receive an ESC, indicating the end of the string. At that
         // point we can finalize the buffer, and if valid, update the renderer
         // with the constructed bit pattern.
-        if (ch != AsciiChars::ESC)
-        {
-            _fontBuffer->AddSixelData(ch);
-        }
-        else if (_fontBuffer->FinalizeSixelData())
+        const auto esc = str.find(AsciiChars::ESC);
+        _fontBuffer->AddSixelData(str.substr(0, esc));
+        if (esc != std::wstring_view::npos && _fontBuffer->FinalizeSixelData())
         {
             // We also need to inform the character set mapper of the ID that
             // will map to this font (we only support one font buffer so there
@@ -3867,7 +3882,7 @@ void AdaptDispatch::RequestUserPreferenceCharset()
 // - a function to parse the character set ID
 ITermDispatch::StringHandler AdaptDispatch::AssignUserPreferenceCharset(const DispatchTypes::CharsetSize charsetSize)
 {
-    return [this, charsetSize, idBuilder = VTIDBuilder{}](const auto ch) mutable {
+    return _perCharacterHandler([this, charsetSize, idBuilder = VTIDBuilder{}](const auto ch) mutable {
         if (ch >= L'\x20' && ch <= L'\x2f')
         {
             idBuilder.AddIntermediate(ch);
@@ -3887,7 +3902,7 @@ ITermDispatch::StringHandler AdaptDispatch::AssignUserPreferenceCharset(const Di
             return false;
         }
         return true;
-    };
+    });
 }
 
 // Method Description:
@@ -3910,8 +3925,8 @@ ITermDispatch::StringHandler AdaptDispatch::DefineMacro(const VTInt macroId,
 
     if (_macroBuffer->InitParser(macroId, deleteControl, encoding))
     {
-        return [&](const auto ch) {
-            return _macroBuffer->ParseDefinition(ch);
+        return [&](const std::wstring_view str) {
+            return _macroBuffer->ParseDefinition(str);
         };
     }
 
@@ -4031,7 +4046,7 @@ void AdaptDispatch::_ReportColorTable(const DispatchTypes::ColorModel colorModel
 // - a function to parse the report data.
 ITermDispatch::StringHandler AdaptDispatch::_RestoreColorTable()
 {
-    return [this, parameter = VTInt{}, parameters = std::vector<VTParameter>{}](const auto ch) mutable {
+    return _perCharacterHandler([this, parameter = VTInt{}, parameters = std::vector<VTParameter>{}](const auto ch) mutable {
         if (ch >= L'0' && ch <= L'9')
         {
             parameter *= 10;
@@ -4070,7 +4085,7 @@ ITermDispatch::StringHandler AdaptDispatch::_RestoreColorTable()
             parameter = 0;
         }
         return (ch != AsciiChars::ESC);
-    };
+    });
 }
 
 // Method Description:
@@ -4089,7 +4104,7 @@ ITermDispatch::StringHandler AdaptDispatch::RequestSetting()
     // this is the opposite of what is documented in most DEC manuals, which
     // say that 0 is for a valid response, and 1 is for an error. The correct
     // interpretation is documented in the DEC STD 070 reference.
-    return [this, parameter = VTInt{}, idBuilder = VTIDBuilder{}](const auto ch) mutable {
+    return _perCharacterHandler([this, parameter = VTInt{}, idBuilder = VTIDBuilder{}](const auto ch) mutable {
         const auto isFinal = ch >= L'\x40' && ch <= L'\x7e';
         if (isFinal)
         {
@@ -4144,7 +4159,7 @@ ITermDispatch::StringHandler AdaptDispatch::RequestSetting()
             }
             return true;
         }
-    };
+    });
 }
 
 // Method Description:
@@ -4491,7 +4506,7 @@ ITermDispatch::StringHandler AdaptDispatch::_RestoreCursorInformation()
         VTParameter row{};
         VTParameter column{};
     };
-    return [&, state = State{}](const auto ch) mutable {
+    return _perCharacterHandler([&, state = State{}](const auto ch) mutable {
         if (numeric.test(state.field))
         {
             if (ch >= '0' && ch <= '9')
@@ -4611,7 +4626,7 @@ ITermDispatch::StringHandler AdaptDispatch::_RestoreCursorInformation()
             }
         }
         return (ch != AsciiChars::ESC);
-    };
+    });
 }
 
 // Method Description:
@@ -4663,7 +4678,7 @@ ITermDispatch::StringHandler AdaptDispatch::_RestoreTabStops()
     _ClearAllTabStops();
     _InitTabStopsForWidth(width);
 
-    return [this, width, column = size_t{}](const auto ch) mutable {
+    return _perCharacterHandler([this, width, column = size_t{}](const auto ch) mutable {
         if (ch >= L'0' && ch <= L'9')
         {
             column *= 10;
@@ -4687,7 +4702,7 @@ ITermDispatch::StringHandler AdaptDispatch::_RestoreTabStops()
             return false;
         }
         return (ch != AsciiChars::ESC);
-    };
+    });
 }
 
 void AdaptDispatch::_ReturnCsiResponse(const std::wstring_view response) const
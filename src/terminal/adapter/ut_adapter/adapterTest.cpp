@@ -8,6 +8,7 @@
 #include "../../../renderer/inc/DummyRenderer.hpp"
 
 #include "adaptDispatch.hpp"
+#include "SixelParser.hpp"
 
 using namespace WEX::Common;
 using namespace WEX::Logging;
@@ -1844,11 +1845,8 @@ public:
     {
         const auto requestSetting = [=](const std::wstring_view settingId = {}) {
             const auto stringHandler = _pDispatch->RequestSetting();
-            for (auto ch : settingId)
-            {
-                stringHandler(ch);
-            }
-            stringHandler(L'\033'); // String terminator
+            stringHandler(settingId);
+            stringHandler(L"\033"); // String terminator
         };
 
         Log::Comment(L"Requesting DECSTBM margins (5 to 10).");
@@ -2066,6 +2064,38 @@ public:
         _testGetSet->ValidateInputEvent(L"\033P0$r\033\\");
     }
 
+    TEST_METHOD(RequestSettingsSplitAcrossWritesTests)
+    {
+        // The state machine hands DCS data to the handler in runs, so a query
+        // that arrives in several writes must parse the same as a single one.
+        Log::Comment(L"Requesting DECSTBM margins with the ID in its own write.");
+        _testGetSet->PrepData();
+        _pDispatch->SetTopBottomScrollingMargins(5, 10);
+        _stateMachine->ProcessString(L"\033P$q");
+        _stateMachine->ProcessString(L"r");
+        _testGetSet->ValidateInputEvent(L"\033P1$r5;10r\033\\");
+        _stateMachine->ProcessString(L"\033\\");
+
+        Log::Comment(L"Requesting SGR attributes with the terminator split off.");
+        _testGetSet->PrepData();
+        auto attribute = TextAttribute{};
+        attribute.SetIntense(true);
+        _testGetSet->_textBuffer->SetCurrentAttributes(attribute);
+        _stateMachine->ProcessString(L"\033P$qm\033");
+        _testGetSet->ValidateInputEvent(L"\033P1$r0;1m\033\\");
+        _stateMachine->ProcessString(L"\\");
+
+        Log::Comment(L"Requesting DECAC colors with the parameter, intermediate and final split.");
+        _testGetSet->PrepData();
+        auto& renderSettings = _testGetSet->_renderer._renderSettings;
+        renderSettings.SetColorAliasIndex(ColorAlias::FrameForeground, 4);
+        renderSettings.SetColorAliasIndex(ColorAlias::FrameBackground, 6);
+        _stateMachine->ProcessString(L"\033P$q2");
+        _stateMachine->ProcessString(L",");
+        _stateMachine->ProcessString(L"|\033\\");
+        _testGetSet->ValidateInputEvent(L"\033P1$r2;4;6,|\033\\");
+    }
+
     TEST_METHOD(RequestStandardModeTests)
     {
         // The mode numbers below correspond to the ANSIStandardMode values
@@ -3285,6 +3315,55 @@ public:
         }
     }
 
+    TEST_METHOD(SixelSplitAcrossWrites)
+    {
+        _testGetSet->PrepData(CursorX::LEFT, CursorY::TOP);
+
+        // We use a VT340-level parser so that palette changes made in the image
+        // are also applied to the text color table, where we can inspect them.
+        _pDispatch->_sixelParser = std::make_shared<SixelParser>(*_pDispatch, *_stateMachine, 3);
+
+        const auto& renderSettings = _testGetSet->_renderer._renderSettings;
+        const auto originalColor = renderSettings.GetColorTableEntry(1);
+        const auto blue = RGB(0, 0, 255);
+        const auto imageSlice = [&] {
+            return _testGetSet->_textBuffer->GetRowByOffset(_testGetSet->_viewport.top).GetImageSlice();
+        };
+        const auto topLeftPixel = [&] {
+            const auto pixel = imageSlice()->Pixels(0)[0];
+            return RGB(pixel.rgbRed, pixel.rgbGreen, pixel.rgbBlue);
+        };
+
+        Log::Comment(L"A sixel run split across writes is not flushed early");
+        _stateMachine->ProcessString(L"\033Pq#1;2;100;0;0#1!1");
+        _stateMachine->ProcessString(L"0~$#1;2;0;100;0$#1");
+        VERIFY_IS_NULL(imageSlice());
+        VERIFY_ARE_EQUAL(originalColor, renderSettings.GetColorTableEntry(1));
+
+        Log::Comment(L"A color change at the end of a write flushes the image");
+        _stateMachine->ProcessString(L"#1;2;0;0;10");
+        VERIFY_IS_NULL(imageSlice());
+        _stateMachine->ProcessString(L"0$");
+        VERIFY_IS_NOT_NULL(imageSlice());
+        VERIFY_ARE_EQUAL(blue, topLeftPixel());
+        VERIFY_ARE_EQUAL(blue, renderSettings.GetColorTableEntry(1));
+
+        Log::Comment(L"The terminator keeps the final image and palette");
+        _stateMachine->ProcessString(L"\033\\");
+        VERIFY_ARE_EQUAL(10, imageSlice()->PixelWidth());
+        VERIFY_ARE_EQUAL(blue, topLeftPixel());
+        VERIFY_ARE_EQUAL(blue, renderSettings.GetColorTableEntry(1));
+
+        Log::Comment(L"The same image in a single write ends in the same state");
+        _testGetSet->PrepData(CursorX::LEFT, CursorY::TOP);
+        _stateMachine->ProcessString(L"\033Pq#1;2;100;0;0#1!10~$#1;2;0;100;0$#1#1;2;0;0;100$\033\\");
+        VERIFY_ARE_EQUAL(10, imageSlice()->PixelWidth());
+        VERIFY_ARE_EQUAL(blue, topLeftPixel());
+        VERIFY_ARE_EQUAL(blue, renderSettings.GetColorTableEntry(1));
+
+        _pDispatch->_sixelParser = nullptr;
+    }
+
     TEST_METHOD(SoftFontSizeDetection)
     {
         using CellMatrix = DispatchTypes::DrcsCellMatrix;
@@ -3309,11 +3388,8 @@ public:
                 return false;
             }
 
-            fontBuffer.AddSixelData(L'B'); // Charset identifier
-            for (auto ch : data)
-            {
-                fontBuffer.AddSixelData(ch);
-            }
+            fontBuffer.AddSixelData(L"B"); // Charset identifier
+            fontBuffer.AddSixelData(data);
             if (!fontBuffer.FinalizeSixelData())
             {
                 return false;
@@ -3557,11 +3633,8 @@ public:
     {
         const auto assignCharset = [=](const auto charsetSize, const std::wstring_view charsetId = {}) {
             const auto stringHandler = _pDispatch->AssignUserPreferenceCharset(charsetSize);
-            for (auto ch : charsetId)
-            {
-                stringHandler(ch);
-            }
-            stringHandler(L'\033'); // String terminator
+            stringHandler(charsetId);
+            stringHandler(L"\033"); // String terminator
         };
         auto& termOutput = _pDispatch->_termOutput;
         termOutput.SoftReset();
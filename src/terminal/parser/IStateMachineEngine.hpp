@@ -20,7 +20,10 @@ namespace Microsoft::Console::VirtualTerminal
     class IStateMachineEngine
     {
     public:
-        using StringHandler = std::function<bool(const wchar_t)>;
+        // Receives the data string of a DCS sequence in runs of characters, which are as long as
+        // the input allows, followed by an ESC on its own once the string ends. Returning false
+        // indicates that the rest of the string should be ignored.
+        using StringHandler = std::function<bool(const std::wstring_view)>;
 
         virtual ~IStateMachineEngine() = 0;
         IStateMachineEngine(const IStateMachineEngine&) = default;
@@ -405,6 +405,15 @@ bool OutputStateMachineEngine::ActionVt52EscDispatch(const VTID id, const VTPara
 // - true iff we successfully dispatched the sequence.
 bool OutputStateMachineEngine::ActionCsiDispatch(const VTID id, const VTParameters parameters)
 {
+    // SGR makes up the bulk of the sequences in colorized output, so we handle it
+    // before anything else. It accepts sub parameters, so it can skip that check too.
+    if (id == CsiActionCodes::SGR_SetGraphicsRendition) [[likely]]
+    {
+        _dispatch->SetGraphicsRendition(parameters);
+        _ClearLastChar();
+        return true;
+    }
+
     // Bail out if we receive subparameters, but we don't accept them in the sequence.
     if (parameters.hasSubParams() && !_CanSeqAcceptSubParam(id, parameters)) [[unlikely]]
     {
@@ -501,9 +510,6 @@ bool OutputStateMachineEngine::ActionCsiDispatch(const VTID id, const VTParamete
             _dispatch->ResetMode(DispatchTypes::DECPrivateMode(mode));
         });
         break;
-    case CsiActionCodes::SGR_SetGraphicsRendition:
-        _dispatch->SetGraphicsRendition(parameters);
-        break;
     case CsiActionCodes::DSR_DeviceStatusReport:
         _dispatch->DeviceStatusReport(DispatchTypes::ANSIStandardStatus(parameters.at(0)), parameters.at(1));
         break;
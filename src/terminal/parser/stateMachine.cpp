@@ -374,6 +374,65 @@ static constexpr bool _isApcIndicator(const wchar_t wch) noexcept
 
 #pragma warning(pop)
 
+// The classes of characters that the CSI states distinguish between.
+// CAN, SUB, and ESC never reach these states. See ProcessCharacter.
+enum class CsiCharClass : uint8_t
+{
+    Execute, // C0 control characters
+    Delete,
+    Intermediate, // 0x20 - 0x2F
+    Digit, // 0x30 - 0x39
+    SubParameterDelimiter, // 0x3A
+    ParameterDelimiter, // 0x3B
+    PrivateMarker, // 0x3C - 0x3F
+    Final, // Everything else
+};
+
+// The class of every ASCII character, built at compile time from the predicates above, so that the CSI
+// states can switch over it, instead of testing each character against a chain of ranges.
+static constexpr auto csiCharClasses = []() {
+    std::array<CsiCharClass, 128> classes{};
+    for (wchar_t wch = 0; wch < classes.size(); ++wch)
+    {
+        auto c = CsiCharClass::Final;
+        if (_isC0Code(wch))
+        {
+            c = CsiCharClass::Execute;
+        }
+        else if (_isDelete(wch))
+        {
+            c = CsiCharClass::Delete;
+        }
+        else if (_isIntermediate(wch))
+        {
+            c = CsiCharClass::Intermediate;
+        }
+        else if (_isNumericParamValue(wch))
+        {
+            c = CsiCharClass::Digit;
+        }
+        else if (_isSubParameterDelimiter(wch))
+        {
+            c = CsiCharClass::SubParameterDelimiter;
+        }
+        else if (_isParameterDelimiter(wch))
+        {
+            c = CsiCharClass::ParameterDelimiter;
+        }
+        else if (_isCsiPrivateMarker(wch))
+        {
+            c = CsiCharClass::PrivateMarker;
+        }
+        til::at(classes, wch) = c;
+    }
+    return classes;
+}();
+
+static constexpr CsiCharClass _classifyCsiChar(const wchar_t wch) noexcept
+{
+    return wch < csiCharClasses.size() ? til::at(csiCharClasses, wch) : CsiCharClass::Final;
+}
+
 // Routine Description:
 // - Triggers the Execute action to indicate that the listener should immediately respond to a C0 control character.
 // Arguments:
@@ -547,6 +606,46 @@ void StateMachine::_ActionParam(const wchar_t wch)
     }
 }
 
+// Routine Description:
+// - Triggers the Param action for a run of parameter characters at once.
+//   This is equivalent to calling _ActionParam for each of them, but it
+//   accumulates the digits of a parameter before storing the value.
+// Arguments:
+// - string - The remaining input.
+// Return Value:
+// - The number of characters that were consumed.
+size_t StateMachine::_ActionParamRun(const std::wstring_view string)
+{
+    _trace.TraceOnAction(L"Param");
+
+    const auto size = string.size();
+    size_t i = 0;
+    while (i < size)
+    {
+        const auto wch = til::at(string, i);
+        if (_isNumericParamValue(wch) && !_parameterLimitOverflowed && !_parameters.empty())
+        {
+            auto currentParameter = _parameters.back().value_or(0);
+            do
+            {
+                _AccumulateTo(til::at(string, i), currentParameter);
+                ++i;
+            } while (i < size && _isNumericParamValue(til::at(string, i)));
+            _parameters.back() = currentParameter;
+        }
+        else if (_isNumericParamValue(wch) || _isParameterDelimiter(wch))
+        {
+            _ActionParam(wch);
+            ++i;
+        }
+        else
+        {
+            break;
+        }
+    }
+    return i;
+}
+
 // Routine Description:
 // - Triggers the SubParam action to indicate that the state machine should
 //   store this character as a part of a sub-parameter to a control sequence.
@@ -655,7 +754,8 @@ void StateMachine::_ActionInterrupt()
     if (_state == VTStates::DcsPassThrough)
     {
         // The ESC signals the end of the data string.
-        _dcsStringHandler(AsciiChars::ESC);
+        static constexpr wchar_t esc = AsciiChars::ESC;
+        _dcsStringHandler({ &esc, 1 });
         _dcsStringHandler = nullptr;
     }
 }
@@ -686,6 +786,19 @@ void StateMachine::_ActionOscPut(const wchar_t wch)
     _oscString.push_back(wch);
 }
 
+// Routine Description:
+// - Triggers the OscPut action for a run of characters at once.
+// Arguments:
+// - string - The characters to add to the OSC string.
+// Return Value:
+// - <none>
+void StateMachine::_ActionOscPutString(const std::wstring_view string)
+{
+    _trace.TraceOnAction(L"OscPut");
+
+    _oscString.append(string);
+}
+
 // Routine Description:
 // - Triggers the OscDispatch action to indicate that the listener should handle a control sequence.
 //   These sequences perform various API-type commands that can include many parameters.
@@ -1219,39 +1332,36 @@ void StateMachine::_EventEscapeIntermediate(const wchar_t wch)
 void StateMachine::_EventCsiEntry(const wchar_t wch)
 {
     _trace.TraceOnEvent(L"CsiEntry");
-    if (_isC0Code(wch))
+    switch (_classifyCsiChar(wch))
     {
+    case CsiCharClass::Execute:
         _ActionExecute(wch);
-    }
-    else if (_isDelete(wch))
-    {
+        break;
+    case CsiCharClass::Delete:
         _ActionIgnore();
-    }
-    else if (_isIntermediate(wch))
-    {
+        break;
+    case CsiCharClass::Intermediate:
         _ActionCollect(wch);
         _EnterCsiIntermediate();
-    }
-    else if (_isNumericParamValue(wch) || _isParameterDelimiter(wch))
-    {
+        break;
+    case CsiCharClass::Digit:
+    case CsiCharClass::ParameterDelimiter:
         _ActionParam(wch);
         _EnterCsiParam();
-    }
-    else if (_isSubParameterDelimiter(wch))
-    {
+        break;
+    case CsiCharClass::SubParameterDelimiter:
         _ActionSubParam(wch);
         _EnterCsiSubParam();
-    }
-    else if (_isCsiPrivateMarker(wch))
-    {
+        break;
+    case CsiCharClass::PrivateMarker:
         _ActionCollect(wch);
         _EnterCsiParam();
-    }
-    else
-    {
+        break;
+    default:
         _ActionCsiDispatch(wch);
         _EnterGround();
         _ExecuteCsiCompleteCallback();
+        break;
     }
 }
 
@@ -1270,27 +1380,28 @@ void StateMachine::_EventCsiEntry(const wchar_t wch)
 void StateMachine::_EventCsiIntermediate(const wchar_t wch)
 {
     _trace.TraceOnEvent(L"CsiIntermediate");
-    if (_isC0Code(wch))
+    switch (_classifyCsiChar(wch))
     {
+    case CsiCharClass::Execute:
         _ActionExecute(wch);
-    }
-    else if (_isIntermediate(wch))
-    {
+        break;
+    case CsiCharClass::Intermediate:
         _ActionCollect(wch);
-    }
-    else if (_isDelete(wch))
-    {
+        break;
+    case CsiCharClass::Delete:
         _ActionIgnore();
-    }
-    else if (_isIntermediateInvalid(wch))
-    {
+        break;
+    case CsiCharClass::Digit:
+    case CsiCharClass::SubParameterDelimiter:
+    case CsiCharClass::ParameterDelimiter:
+    case CsiCharClass::PrivateMarker:
         _EnterCsiIgnore();
-    }
-    else
-    {
+        break;
+    default:
         _ActionCsiDispatch(wch);
         _EnterGround();
         _ExecuteCsiCompleteCallback();
+        break;
     }
 }
 
@@ -1309,25 +1420,17 @@ void StateMachine::_EventCsiIntermediate(const wchar_t wch)
 void StateMachine::_EventCsiIgnore(const wchar_t wch)
 {
     _trace.TraceOnEvent(L"CsiIgnore");
-    if (_isC0Code(wch))
+    switch (_classifyCsiChar(wch))
     {
+    case CsiCharClass::Execute:
         _ActionExecute(wch);
-    }
-    else if (_isDelete(wch))
-    {
-        _ActionIgnore();
-    }
-    else if (_isIntermediate(wch))
-    {
-        _ActionIgnore();
-    }
-    else if (_isIntermediateInvalid(wch))
-    {
-        _ActionIgnore();
-    }
-    else
-    {
+        break;
+    case CsiCharClass::Final:
         _EnterGround();
+        break;
+    default:
+        _ActionIgnore();
+        break;
     }
 }
 
@@ -1348,37 +1451,34 @@ void StateMachine::_EventCsiIgnore(const wchar_t wch)
 void StateMachine::_EventCsiParam(const wchar_t wch)
 {
     _trace.TraceOnEvent(L"CsiParam");
-    if (_isC0Code(wch))
+    switch (_classifyCsiChar(wch))
     {
+    case CsiCharClass::Execute:
         _ActionExecute(wch);
-    }
-    else if (_isDelete(wch))
-    {
+        break;
+    case CsiCharClass::Delete:
         _ActionIgnore();
-    }
-    else if (_isNumericParamValue(wch) || _isParameterDelimiter(wch))
-    {
+        break;
+    case CsiCharClass::Digit:
+    case CsiCharClass::ParameterDelimiter:
         _ActionParam(wch);
-    }
-    else if (_isSubParameterDelimiter(wch))
-    {
+        break;
+    case CsiCharClass::SubParameterDelimiter:
         _ActionSubParam(wch);
         _EnterCsiSubParam();
-    }
-    else if (_isIntermediate(wch))
-    {
+        break;
+    case CsiCharClass::Intermediate:
         _ActionCollect(wch);
         _EnterCsiIntermediate();
-    }
-    else if (_isParameterInvalid(wch))
-    {
+        break;
+    case CsiCharClass::PrivateMarker:
         _EnterCsiIgnore();
-    }
-    else
-    {
+        break;
+    default:
         _ActionCsiDispatch(wch);
         _EnterGround();
         _ExecuteCsiCompleteCallback();
+        break;
     }
 }
 
@@ -1399,37 +1499,34 @@ void StateMachine::_EventCsiParam(const wchar_t wch)
 void StateMachine::_EventCsiSubParam(const wchar_t wch)
 {
     _trace.TraceOnEvent(L"CsiSubParam");
-    if (_isC0Code(wch))
+    switch (_classifyCsiChar(wch))
     {
+    case CsiCharClass::Execute:
         _ActionExecute(wch);
-    }
-    else if (_isDelete(wch))
-    {
+        break;
+    case CsiCharClass::Delete:
         _ActionIgnore();
-    }
-    else if (_isNumericParamValue(wch) || _isSubParameterDelimiter(wch))
-    {
+        break;
+    case CsiCharClass::Digit:
+    case CsiCharClass::SubParameterDelimiter:
         _ActionSubParam(wch);
-    }
-    else if (_isParameterDelimiter(wch))
-    {
+        break;
+    case CsiCharClass::ParameterDelimiter:
         _ActionParam(wch);
         _EnterCsiParam();
-    }
-    else if (_isIntermediate(wch))
-    {
+        break;
+    case CsiCharClass::Intermediate:
         _ActionCollect(wch);
         _EnterCsiIntermediate();
-    }
-    else if (_isParameterInvalid(wch))
-    {
+        break;
+    case CsiCharClass::PrivateMarker:
         _EnterCsiIgnore();
-    }
-    else
-    {
+        break;
+    default:
         _ActionCsiDispatch(wch);
         _EnterGround();
         _ExecuteCsiCompleteCallback();
+        break;
     }
 }
 
@@ -1789,6 +1886,23 @@ void StateMachine::_EventDcsParam(const wchar_t wch)
     }
 }
 
+// Routine Description:
+// - Triggers the DcsPassThrough action to pass a run of data string characters
+//   on to the string handler. If the handler doesn't want any more of the
+//   string, the remainder will be ignored.
+// Arguments:
+// - string - The run of characters.
+// Return Value:
+// - <none>
+void StateMachine::_ActionDcsPassThrough(const std::wstring_view string)
+{
+    _trace.TraceOnAction(L"DcsPassThrough");
+    if (!_dcsStringHandler(string))
+    {
+        _EnterDcsIgnore();
+    }
+}
+
 // Routine Description:
 // - Processes a character event into an Action that occurs while in the DcsPassThrough state.
 //   Events in this state will:
@@ -1804,10 +1918,7 @@ void StateMachine::_EventDcsPassThrough(const wchar_t wch)
     _trace.TraceOnEvent(L"DcsPassThrough");
     if (_isC0Code(wch) || _isDcsPassThroughValid(wch))
     {
-        if (!_dcsStringHandler(wch))
-        {
-            _EnterDcsIgnore();
-        }
+        _ActionDcsPassThrough({ &wch, 1 });
     }
     else
     {
@@ -1922,6 +2033,62 @@ void StateMachine::ProcessCharacter(const wchar_t wch)
         }
     }
 }
+
+// Routine Description:
+// - Processes the leading run of characters that would all lead to the same
+//   action in the current state, if the state allows for that. Parameters make
+//   up most of a typical control sequence, and strings can be huge (OSC 52
+//   clipboard data or sixel images for instance), so this avoids going through
+//   ProcessCharacter for each of their characters.
+// - IsProcessingLastCharacter() must remain accurate for every character that
+//   is passed on (the sixel parser relies on it, for instance). That's why the
+//   run passed to the OSC and DCS handlers never includes the last character
+//   of the input. It's left for ProcessString to process individually.
+// Arguments:
+// - string - The remaining input.
+// Return Value:
+// - The number of characters that were consumed. 0 if the next character
+//   needs to be processed individually.
+size_t StateMachine::_ProcessRun(const std::wstring_view string)
+{
+    const auto beg = string.data();
+    const auto len = string.size();
+    const auto lenExceptLast = len - 1;
+
+    switch (_state)
+    {
+    case VTStates::CsiParam:
+        return _ActionParamRun(string);
+    case VTStates::OscString:
+    {
+        // Anything that's not actionable from the ground state is part of the OSC string.
+        const auto run = string.substr(0, Microsoft::Console::Utils::FindActionableControlCharacter(beg, lenExceptLast) - beg);
+        if (!run.empty())
+        {
+            _processingLastCharacter = false;
+            _ActionOscPutString(run);
+        }
+        return run.size();
+    }
+    case VTStates::DcsPassThrough:
+    {
+        const auto run = string.substr(0, Microsoft::Console::Utils::FindDataStringTerminator(beg, lenExceptLast) - beg);
+        if (!run.empty())
+        {
+            _processingLastCharacter = false;
+            _ActionDcsPassThrough(run);
+        }
+        return run.size();
+    }
+    case VTStates::DcsIgnore:
+    case VTStates::SosPmApcString:
+        // Both of these ignore everything up to the end of the string.
+        return Microsoft::Console::Utils::FindDataStringTerminator(beg, len) - beg;
+    default:
+        return 0;
+    }
+}
+
 // Method Description:
 // - Pass the current string we're processing through to the engine. It may eat
 //      the string, it may write it straight to the input unmodified, it might
@@ -2018,6 +2185,14 @@ void StateMachine::ProcessString(const std::wstring_view string)
 
         do
         {
+            // Some states can consume entire runs of characters at once.
+            if (const auto len = _ProcessRun(string.substr(i)))
+            {
+                i += len;
+                _runSize += len;
+                continue;
+            }
+
             _runSize++;
             _processingLastCharacter = i + 1 >= string.size();
             // If we're processing characters individually, send it to the state machine.
@@ -170,7 +170,7 @@ class Microsoft::Console::VirtualTerminal::OutputEngineTest final
         {
             Log::Comment(L"Escape from DcsPassThrough");
             mach._state = StateMachine::VTStates::DcsPassThrough;
-            mach._dcsStringHandler = [](const auto) { return true; };
+            mach._dcsStringHandler = [](const std::wstring_view) { return true; };
             break;
         }
         case 17:
@@ -38,6 +38,10 @@ public:
         dcsId = 0;
         dcsParams.clear();
         dcsDataString.clear();
+        dcsDataRuns = 0;
+        dcsLastCharacterFlags.clear();
+        oscParam = 0;
+        oscString.clear();
     }
 
     bool EncounteredWin32InputModeSequence() const noexcept override
@@ -69,13 +73,15 @@ public:
 
     bool ActionVt52EscDispatch(const VTID /*id*/, const VTParameters /*parameters*/) override { return true; };
 
-    bool ActionOscDispatch(const size_t /* parameter */, const std::wstring_view /* string */) override
+    bool ActionOscDispatch(const size_t parameter, const std::wstring_view string) override
     {
         if (pfnFlushToTerminal)
         {
             pfnFlushToTerminal();
             return true;
         }
+        oscParam = parameter;
+        oscString = string;
         return true;
     };
 
@@ -109,7 +115,18 @@ public:
             dcsParams.push_back(parameters.at(i).value_or(0));
         }
         dcsDataString.clear();
-        return [=](const auto ch) { dcsDataString += ch; return true; };
+        dcsDataRuns = 0;
+        dcsLastCharacterFlags.clear();
+        return [=](const std::wstring_view str) {
+            dcsDataString += str;
+            dcsDataRuns++;
+            if (stateMachine)
+            {
+                // This is what a handler that processes each character individually would see.
+                dcsLastCharacterFlags.append(str.size(), stateMachine->IsProcessingLastCharacter() ? L'1' : L'0');
+            }
+            return true;
+        };
     }
 
     // These will only be populated if ActionCsiDispatch is called.
@@ -132,6 +149,14 @@ public:
     uint64_t dcsId = 0;
     std::vector<size_t> dcsParams;
     std::wstring dcsDataString;
+    size_t dcsDataRuns = 0;
+    // Only populated if stateMachine is set.
+    std::wstring dcsLastCharacterFlags;
+    const StateMachine* stateMachine = nullptr;
+
+    // These will only be populated if ActionOscDispatch is called.
+    size_t oscParam = 0;
+    std::wstring oscString;
 };
 
 class Microsoft::Console::VirtualTerminal::StateMachineTest
@@ -154,8 +179,11 @@ class Microsoft::Console::VirtualTerminal::StateMachineTest
     TEST_METHOD(RunStorageBeforeEscape);
     TEST_METHOD(BulkTextPrint);
     TEST_METHOD(PassThroughUnhandledSplitAcrossWrites);
+    TEST_METHOD(ParametersSplitAcrossWrites);
+    TEST_METHOD(OscStringSplitAcrossWrites);
 
     TEST_METHOD(DcsDataStringsReceivedByHandler);
+    TEST_METHOD(DcsHandlerSeesLastCharacterOfEachWrite);
 
     TEST_METHOD(VtParameterSubspanTest);
 };
@@ -276,6 +304,47 @@ void StateMachineTest::PassThroughUnhandledSplitAcrossWrites()
     VERIFY_ARE_EQUAL(L"", engine.printed);
 }
 
+void StateMachineTest::ParametersSplitAcrossWrites()
+{
+    auto enginePtr{ std::make_unique<TestStateMachineEngine>() };
+    // this dance is required because StateMachine presumes to take ownership of its engine.
+    auto& engine{ *enginePtr.get() };
+    StateMachine machine{ std::move(enginePtr) };
+
+    // Parameters are accumulated in runs, so split them in the middle of
+    // a value, and mix in omitted values, sub parameters, and overflows.
+    machine.ProcessString(L"\x1b[12;3");
+    machine.ProcessString(L"45;;9999999");
+    machine.ProcessString(L"9:1;7m");
+
+    VERIFY_ARE_EQUAL(static_cast<uint64_t>(VTID("m")), engine.csiId);
+    VERIFY_ARE_EQUAL(std::vector<size_t>({ 12, 345, 0, MAX_PARAMETER_VALUE, 7 }), engine.csiParams);
+
+    // A private marker in the middle of the parameters invalidates the sequence.
+    engine.ResetTestState();
+    machine.ProcessString(L"\x1b[1;2?3m");
+
+    VERIFY_ARE_EQUAL(0ull, engine.csiId);
+    VERIFY_ARE_EQUAL(L"", engine.printed);
+}
+
+void StateMachineTest::OscStringSplitAcrossWrites()
+{
+    auto enginePtr{ std::make_unique<TestStateMachineEngine>() };
+    // this dance is required because StateMachine presumes to take ownership of its engine.
+    auto& engine{ *enginePtr.get() };
+    StateMachine machine{ std::move(enginePtr) };
+
+    // OSC strings are collected in runs, so make sure that runs are correctly
+    // resumed after a split, and after characters that are processed individually.
+    machine.ProcessString(L"\x1b]2;t\u00eftl\u00e9 with DEL \x7f and");
+    machine.ProcessString(L" C0 \x01" L"controls\x07printed text");
+
+    VERIFY_ARE_EQUAL(2u, engine.oscParam);
+    VERIFY_ARE_EQUAL(L"t\u00eftl\u00e9 with DEL \x7f and C0 controls", engine.oscString);
+    VERIFY_ARE_EQUAL(L"printed text", engine.printed);
+}
+
 void StateMachineTest::DcsDataStringsReceivedByHandler()
 {
     BEGIN_TEST_METHOD_PROPERTIES()
@@ -329,6 +398,10 @@ void StateMachineTest::DcsDataStringsReceivedByHandler()
     // Verify that the data string is received (ESC terminated).
     VERIFY_ARE_EQUAL(L"data string\033", engine.dcsDataString);
 
+    // Verify that the data is passed on in a single run, except for the last character of the write,
+    // which is passed on individually, followed by the ESC.
+    VERIFY_ARE_EQUAL(3u, engine.dcsDataRuns);
+
     // Verify the characters following the sequence are printed.
     VERIFY_ARE_EQUAL(L"printed text", engine.printed);
 
@@ -339,6 +412,24 @@ void StateMachineTest::DcsDataStringsReceivedByHandler()
     VERIFY_ARE_EQUAL(expectedExecuted, engine.executed);
 }
 
+void StateMachineTest::DcsHandlerSeesLastCharacterOfEachWrite()
+{
+    auto enginePtr{ std::make_unique<TestStateMachineEngine>() };
+    // this dance is required because StateMachine presumes to take ownership of its engine.
+    auto& engine{ *enginePtr.get() };
+    StateMachine machine{ std::move(enginePtr) };
+    engine.stateMachine = &machine;
+
+    machine.ProcessString(L"\033P1;2;3|abc");
+    machine.ProcessString(L"def");
+    machine.ProcessString(L"\033\\");
+
+    // Most of the data is passed on in runs, but IsProcessingLastCharacter()
+    // must only be true for the last character of each write.
+    VERIFY_ARE_EQUAL(L"abcdef\033", engine.dcsDataString);
+    VERIFY_ARE_EQUAL(L"0010010", engine.dcsLastCharacterFlags);
+}
+
 void StateMachineTest::VtParameterSubspanTest()
 {
     const auto parameterList = std::vector<VTParameter>{ 12, 34, 56, 78 };
@@ -17,6 +17,7 @@ class Utf8Utf16ConvertTests
     TEST_METHOD(TestU8ToU16Partials);
     TEST_METHOD(TestU16ToU8Partials);
     TEST_METHOD(TestU8ToU16OneByOne);
+    TEST_METHOD(TestAsciiRuns);
 };
 
 void Utf8Utf16ConvertTests::TestU8ToU16()
@@ -191,3 +192,28 @@ void Utf8Utf16ConvertTests::TestU8ToU16OneByOne()
     VERIFY_SUCCEEDED(til::u8u16(u8String1_4, u16Out1, state));
     VERIFY_ARE_EQUAL(u16StringComp1, u16Out1);
 }
+
+void Utf8Utf16ConvertTests::TestAsciiRuns()
+{
+    // Runs of 16+ ASCII characters are converted without the platform API. Make sure that the conversion
+    // is seamless at their boundaries and that invalid sequences in front of them are replaced just like
+    // MultiByteToWideChar and WideCharToMultiByte would do it if they converted the whole string.
+    const std::string asciiRun{ "0123456789abcdefghij" };
+    const std::wstring asciiRun16{ L"0123456789abcdefghij" };
+
+    const auto u8String{ asciiRun + "\xC3\xB6" + asciiRun + "\xE2\x82" + asciiRun + "\xE2\x82\xAC" };
+    std::wstring u16StringComp(u8String.size(), L'\0');
+    u16StringComp.resize(MultiByteToWideChar(CP_UTF8, 0, u8String.data(), gsl::narrow<int>(u8String.size()), u16StringComp.data(), gsl::narrow<int>(u16StringComp.size())));
+
+    std::wstring u16Out{};
+    VERIFY_ARE_EQUAL(S_OK, til::u8u16(u8String, u16Out));
+    VERIFY_ARE_EQUAL(u16StringComp, u16Out);
+
+    const auto u16String{ asciiRun16 + L"\u00f6" + asciiRun16 + L"\xd853" + asciiRun16 + L"\u20ac" };
+    std::string u8StringComp(u16String.size() * 3, '\0');
+    u8StringComp.resize(WideCharToMultiByte(CP_UTF8, 0, u16String.data(), gsl::narrow<int>(u16String.size()), u8StringComp.data(), gsl::narrow<int>(u8StringComp.size()), nullptr, nullptr));
+
+    std::string u8Out{};
+    VERIFY_ARE_EQUAL(S_OK, til::u16u8(u16String, u8Out));
+    VERIFY_ARE_EQUAL(u8StringComp, u8Out);
+}
@@ -1235,6 +1235,95 @@ plainSearch:
     return it;
 }
 
+// Returns true for CAN, SUB, ESC, and anything outside of 7-bit ASCII.
+constexpr bool isDataStringTerminator(const wchar_t wch) noexcept
+{
+    // This is equivalent to:
+    //   return wch == 0x18 || wch == 0x1a || wch == 0x1b || wch >= 0x7f;
+    // See isActionableFromGround for why it's written like this.
+    return (wch == 0x18) | (static_cast<wchar_t>(wch - 0x1a) <= 1) | (wch >= 0x7f);
+}
+
+// Returns the first character that can't be passed through as part of a DCS data string.
+// CAN, SUB, and ESC end the string, and DEL and non-ASCII characters need to be dropped.
+const wchar_t* Utils::FindDataStringTerminator(const wchar_t* beg, const size_t len) noexcept
+{
+    auto it = beg;
+
+#if defined(TIL_SSE_INTRINSICS)
+
+    for (const auto end = beg + (len & ~size_t{ 7 }); it < end; it += 8)
+    {
+        const auto wch = _mm_loadu_si128(reinterpret_cast<const __m128i*>(it));
+
+        // Check for (wch >= 0x7f) with the same saturating subtraction trick as above.
+        auto a = _mm_subs_epu16(wch, _mm_set1_epi16(0x7e));
+        a = _mm_xor_si128(_mm_cmpeq_epi16(a, _mm_setzero_si128()), _mm_set1_epi8(-1));
+        const auto b = _mm_cmpeq_epi16(wch, _mm_set1_epi16(0x18));
+        const auto c = _mm_cmpeq_epi16(wch, _mm_set1_epi16(0x1a));
+        const auto d = _mm_cmpeq_epi16(wch, _mm_set1_epi16(0x1b));
+
+        const auto e = _mm_or_si128(_mm_or_si128(a, b), _mm_or_si128(c, d));
+        const auto mask = _mm_movemask_epi8(e);
+
+        if (mask)
+        {
+            unsigned long offset;
+            _BitScanForward(&offset, mask);
+            it += offset / 2;
+            return it;
+        }
+    }
+
+#elif defined(TIL_ARM_NEON_INTRINSICS)
+
+    uint64_t mask;
+
+    for (const auto end = beg + (len & ~size_t{ 7 });;)
+    {
+        if (it >= end)
+        {
+            goto plainSearch;
+        }
+
+        const auto wch = vld1q_u16(it);
+        const auto a = vcgeq_u16(wch, vdupq_n_u16(0x7f));
+        const auto b = vceqq_u16(wch, vdupq_n_u16(0x18));
+        const auto c = vcleq_u16(vsubq_u16(wch, vdupq_n_u16(0x1a)), vdupq_n_u16(1));
+        const auto d = vorrq_u16(a, vorrq_u16(b, c));
+
+        mask = vgetq_lane_u64(d, 0);
+        if (mask)
+        {
+            break;
+        }
+        it += 4;
+
+        mask = vgetq_lane_u64(d, 1);
+        if (mask)
+        {
+            break;
+        }
+        it += 4;
+    }
+
+    unsigned long offset;
+    _BitScanForward64(&offset, mask);
+    it += offset / 16;
+    return it;
+
+plainSearch:
+
+#endif
+
+#pragma loop(no_vector)
+    for (const auto end = beg + len; it < end && !isDataStringTerminator(*it); ++it)
+    {
+    }
+
+    return it;
+}
+
 #pragma warning(pop)
 
 std::wstring Utils::EvaluateStartingDirectory(